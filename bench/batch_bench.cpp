@@ -0,0 +1,170 @@
+// NodeBatchProcessor against the per-node virtual path on chains of control
+// nodes (lfo -> remap -> remap). The per-node nodes compute the same values
+// as the built-in kernels, one process() call each; both sides include
+// collectDirtyNodes(). Build with optimizations so the kernels vectorize.
+//
+// Usage: batch_bench [chains]
+#include "core/NodeBatch.h"
+#include "core/NodeRegistry.h"
+#include "core/NodeScheduler.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace gfx;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int FRAMES = 2000;
+
+// Per-node LFO: the lfo kernel's math over one node's parameters
+class LfoNode : public Node {
+public:
+    LfoNode(int id, const float& time) : Node(id, "lfo", osc::NodeType::GENERATOR), time_(time) {
+        frequency_ = addParameter("frequency", osc::ParameterType::FLOAT);
+        amplitude_ = addParameter("amplitude", osc::ParameterType::FLOAT);
+        offset_ = addParameter("offset", osc::ParameterType::FLOAT);
+        phase_ = addParameter("phase", osc::ParameterType::FLOAT);
+        shape_ = addParameter("shape", osc::ParameterType::INT);
+        setTimeDependent(true);
+    }
+
+    void process() override {
+        float position = time_ * frequency_.getFloatValue() + phase_.getFloatValue();
+        float cycle = position - static_cast<float>(static_cast<int32_t>(position));
+        if (cycle < 0.0f) {
+            cycle += 1.0f;
+        }
+        float u = cycle - 0.5f;
+        float wave;
+        switch (shape_.getIntValue()) {
+            case 1: wave = 1.0f - 4.0f * std::fabs(u); break;
+            case 2: wave = 2.0f * cycle - 1.0f; break;
+            case 3: wave = (cycle < 0.5f) ? 1.0f : -1.0f; break;
+            default:
+                wave = 16.0f * u * std::fabs(u) - 8.0f * u;
+                wave += 0.225f * (wave * std::fabs(wave) - wave);
+                break;
+        }
+        value = offset_.getFloatValue() + amplitude_.getFloatValue() * wave;
+    }
+
+    float value = 0.0f;
+
+private:
+    const float& time_;
+    Parameter frequency_, amplitude_, offset_, phase_, shape_;
+};
+
+class RemapNode : public Node {
+public:
+    RemapNode(int id, const float* in) : Node(id, "remap", osc::NodeType::EFFECT), in_(in) {
+        scale_ = addParameter("scale", osc::ParameterType::FLOAT);
+        offset_ = addParameter("offset", osc::ParameterType::FLOAT);
+        scale_.setValue(1.0f);
+    }
+
+    void process() override {
+        value = *in_ * scale_.getFloatValue() + offset_.getFloatValue();
+    }
+
+    float value = 0.0f;
+
+private:
+    const float* in_;
+    Parameter scale_, offset_;
+};
+
+template <typename Frame>
+double microsecondsPerFrame(float& time, Frame&& frame) {
+    auto start = Clock::now();
+    for (int f = 0; f < FRAMES; ++f) {
+        time = f * 0.016f;
+        frame();
+    }
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / FRAMES;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int chains = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+    NodeRegistry registry;
+    registerBuiltinNodeKinds(registry);
+
+    // The same chains twice: registry kinds for the batch processor, and
+    // per-node classes for the virtual path
+    NodeGraph batched;
+    batched.setNodeFactory(registry.getFactory());
+    NodeGraph per_node;
+    float time = 0.0f;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> random(-2.0f, 2.0f);
+    for (int i = 0; i < chains; ++i) {
+        float frequency = random(rng);
+        float amplitude = random(rng);
+        int shape = static_cast<int>(rng() % 4);
+        float scale = random(rng);
+
+        auto lfo = batched.createNode(i, "lfo", "lfo");
+        lfo->getParameter("frequency").setValue(frequency);
+        lfo->getParameter("amplitude").setValue(amplitude);
+        lfo->getParameter("shape").setValue(shape);
+        auto remap = batched.createNode(chains + i, "remap", "remap");
+        remap->getParameter("scale").setValue(scale);
+        batched.addNode(lfo);
+        batched.addNode(remap);
+        batched.addNode(batched.createNode(2 * chains + i, "remap", "remap"));
+        batched.addConnection(Connection(i, i, "value", chains + i, "in"));
+        batched.addConnection(Connection(chains + i, chains + i, "value", 2 * chains + i, "in"));
+
+        auto lfo_node = std::make_shared<LfoNode>(i, time);
+        lfo_node->getParameter("frequency").setValue(frequency);
+        lfo_node->getParameter("amplitude").setValue(amplitude);
+        lfo_node->getParameter("shape").setValue(shape);
+        auto remap_node = std::make_shared<RemapNode>(chains + i, &lfo_node->value);
+        remap_node->getParameter("scale").setValue(scale);
+        auto last_node = std::make_shared<RemapNode>(2 * chains + i, &remap_node->value);
+        per_node.addNode(lfo_node);
+        per_node.addNode(remap_node);
+        per_node.addNode(last_node);
+        per_node.addConnection(Connection(i, i, "value", chains + i, "in"));
+        per_node.addConnection(Connection(chains + i, chains + i, "value", 2 * chains + i, "in"));
+    }
+
+    NodeBatchProcessor batch(registry);
+    std::vector<Node*> remaining;
+    NodeScheduler serial(1);
+    serial.setMode(NodeScheduler::Mode::SERIAL);
+    NodeScheduler parallel;
+
+    double batched_frame = microsecondsPerFrame(time, [&] {
+        remaining.clear();
+        batch.run(batched, batched.collectDirtyNodes(), time, remaining);
+    });
+    double serial_frame = microsecondsPerFrame(time, [&] { serial.run(per_node, per_node.collectDirtyNodes()); });
+    double parallel_frame = microsecondsPerFrame(time, [&] { parallel.run(per_node, per_node.collectDirtyNodes()); });
+
+    // Both paths ran the same last frame
+    const Atom value = AtomTable::find("value");
+    for (int i = 0; i < chains; ++i) {
+        int id = 2 * chains + i;
+        float expected = static_cast<const RemapNode*>(per_node.getNode(id))->value;
+        if (std::fabs(batch.getOutput(*batched.getNode(id), value) - expected) > 1e-4f) {
+            std::cerr << "batched and per-node results differ for node " << id << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << 3 * chains << " control nodes, " << batch.getKernelCalls() << " kernel calls per frame\n"
+              << "batched:            " << batched_frame << " us/frame\n"
+              << "per-node, serial:   " << serial_frame << " us/frame\n"
+              << "per-node, parallel: " << parallel_frame << " us/frame" << std::endl;
+    return 0;
+}
@@ -0,0 +1,139 @@
+// OSCServer dispatch cost per message, apart from receiving: a timed bundle
+// of messages is sent once over loopback, held through the bundle handler
+// and dispatched over and over. Compared with a std::map lookup by string,
+// the dispatch used before handlers were found by hash.
+//
+// Usage: dispatch_bench [port]
+#include "osc/OSCServer.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+
+using namespace gfx;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int BUNDLE_MESSAGES = 256;
+constexpr int ROUNDS = 20000;
+
+const osc::Address PATHS[] = {
+    osc::engine::STATUS, osc::engine::QUIT, osc::engine::CREATE_NODE, osc::engine::DELETE_NODE,
+    osc::engine::UPDATE_NODE, osc::engine::SET_PARAMETER, osc::engine::GET_PARAMETER,
+    osc::engine::CONNECT_NODES, osc::engine::DISCONNECT_NODES, osc::engine::RENDER_FRAME,
+    osc::engine::SAVE_GRAPH, osc::engine::LOAD_GRAPH, osc::engine::SYNC_GRAPH, osc::engine::UNDO,
+    osc::engine::REDO, osc::engine::SET_AUTOMATION, osc::engine::CLEAR_AUTOMATION,
+};
+constexpr int PATH_COUNT = sizeof(PATHS) / sizeof(PATHS[0]);
+
+double nanoseconds(Clock::time_point start, Clock::time_point end, size_t messages) {
+    return std::chrono::duration<double, std::nano>(end - start).count() / messages;
+}
+
+// Send a bundle timed one second ahead, so that the bundle handler holds it
+bool sendBundle(lo_address address, const char* (*path)(int)) {
+    lo_timetag time;
+    lo_timetag_now(&time);
+    time.sec += 1;
+    lo_bundle bundle = lo_bundle_new(time);
+    for (int i = 0; i < BUNDLE_MESSAGES; ++i) {
+        lo_message message = lo_message_new();
+        lo_message_add_int32(message, i);
+        lo_bundle_add_message(bundle, path(i), message);
+    }
+    bool sent = lo_send_bundle(address, bundle) >= 0;
+    lo_bundle_free_recursive(bundle);
+    return sent;
+}
+
+// Poll until the bundle handler got a bundle (up to two seconds)
+bool receiveBundle(OSCServer& server, OSCBundle& held) {
+    auto deadline = Clock::now() + std::chrono::seconds(2);
+    while (held.getMessageCount() == 0 && Clock::now() < deadline) {
+        server.poll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return held.getMessageCount() > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int port = argc > 1 ? std::atoi(argv[1]) : osc::ENGINE_PORT + 100;
+    uint64_t handled = 0;
+
+    // Before: a map keyed by path, with a string built per message
+    {
+        std::map<std::string, OSCServer::MessageHandler> handlers;
+        for (const osc::Address& path : PATHS) {
+            handlers[path.path] = [&](const std::string&, lo_message) { handled++; };
+        }
+        const size_t messages = static_cast<size_t>(ROUNDS) * BUNDLE_MESSAGES;
+        auto start = Clock::now();
+        for (size_t i = 0; i < messages; ++i) {
+            const char* path = PATHS[i % PATH_COUNT];
+            auto it = handlers.find(path);
+            if (it != handlers.end()) {
+                it->second(it->first, nullptr);
+            }
+        }
+        std::cout << "std::map by string: " << nanoseconds(start, Clock::now(), messages) << " ns/message\n";
+    }
+
+    OSCServer server(port);
+    OSCBundle held;
+    server.setDispatchMode(OSCServer::DispatchMode::QUEUED);
+    server.setBundleHandler([&](OSCBundle bundle) { held = std::move(bundle); });
+    for (const osc::Address& path : PATHS) {
+        server.addHandler(path, [&](const std::string&, lo_message) { handled++; });
+    }
+    if (!server.start()) {
+        return 1;
+    }
+
+    std::string port_string = std::to_string(port);
+    lo_address address = lo_address_new("127.0.0.1", port_string.c_str());
+    int result = 0;
+
+    // Registered addresses, one handler each
+    auto exact = [](int i) -> const char* { return PATHS[i % PATH_COUNT]; };
+    if (sendBundle(address, exact) && receiveBundle(server, held)) {
+        handled = 0;
+        auto start = Clock::now();
+        for (int r = 0; r < ROUNDS; ++r) {
+            server.dispatch(held);
+        }
+        size_t messages = static_cast<size_t>(ROUNDS) * held.getMessageCount();
+        std::cout << "hashed:             " << nanoseconds(start, Clock::now(), messages)
+                  << " ns/message\n";
+    } else {
+        std::cerr << "bundle not received" << std::endl;
+        result = 1;
+    }
+
+    // A pattern matching two addresses (compiled once, then cached)
+    held = OSCBundle();
+    auto pattern = [](int) -> const char* { return "/engine/node/param/{set,get}"; };
+    if (result == 0 && sendBundle(address, pattern) && receiveBundle(server, held)) {
+        handled = 0;
+        auto start = Clock::now();
+        for (int r = 0; r < ROUNDS; ++r) {
+            server.dispatch(held);
+        }
+        size_t messages = static_cast<size_t>(ROUNDS) * held.getMessageCount();
+        std::cout << "pattern, 2 targets: " << nanoseconds(start, Clock::now(), messages)
+                  << " ns/message (" << static_cast<double>(handled) / messages << " handlers each)\n";
+    } else if (result == 0) {
+        std::cerr << "bundle not received" << std::endl;
+        result = 1;
+    }
+
+    lo_address_free(address);
+    held = OSCBundle();
+    server.stop();
+    return result;
+}
@@ -0,0 +1,154 @@
+// Sustained OSC ingest over loopback: a sender thread blasts parameter
+// messages at the server for a fixed time while the main thread polls the
+// queue. Compares batched receive (recvmmsg, decoded in place) with the
+// liblo path. Linux only (sendmmsg).
+//
+// Usage: ingest_bench [port] [seconds]
+#include "osc/OSCServer.h"
+#include "core/FrameArena.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+using namespace gfx;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t SEND_BATCH = 64;
+constexpr size_t QUEUE_CAPACITY = 65536;
+
+struct Result {
+    uint64_t sent = 0;
+    uint64_t handled = 0;
+    uint64_t dropped = 0;
+    uint64_t allocations = 0;
+    double seconds = 0.0;
+};
+
+#if defined(__linux__)
+
+// Send copies of datagram to port until stop is set; returns the number sent
+uint64_t blast(int port, const std::vector<char>& datagram, const std::atomic<bool>& stop) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    iovec vectors[SEND_BATCH];
+    mmsghdr headers[SEND_BATCH] = {};
+    for (size_t i = 0; i < SEND_BATCH; ++i) {
+        vectors[i].iov_base = const_cast<char*>(datagram.data());
+        vectors[i].iov_len = datagram.size();
+        headers[i].msg_hdr.msg_name = &address;
+        headers[i].msg_hdr.msg_namelen = sizeof(address);
+        headers[i].msg_hdr.msg_iov = &vectors[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    uint64_t sent = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        int count = sendmmsg(fd, headers, SEND_BATCH, 0);
+        if (count > 0) {
+            sent += static_cast<uint64_t>(count);
+        }
+    }
+    close(fd);
+    return sent;
+}
+
+Result run(int port, bool batched, double seconds, const std::vector<char>& datagram) {
+    OSCServer server(port);
+    server.setDispatchMode(OSCServer::DispatchMode::QUEUED, QUEUE_CAPACITY);
+    server.setBatchedReceive(batched);
+
+    uint64_t handled = 0;
+    float sum = 0.0f;
+    if (batched) {
+        server.addViewHandler(osc::engine::SET_PARAMETER, [&](const OSCMessageView& message) {
+            handled++;
+            sum += message.getFloat(2);
+        });
+    } else {
+        server.addHandler(osc::engine::SET_PARAMETER, [&](const std::string&, lo_message message) {
+            handled++;
+            sum += lo_message_get_argv(message)[2]->f;
+        });
+    }
+    Result result;
+    if (!server.start()) {
+        return result;
+    }
+
+    std::atomic<bool> stop{false};
+    uint64_t sent = 0;
+    uint64_t allocations = getAllocationCount();
+    auto start = Clock::now();
+    std::thread sender([&] { sent = blast(port, datagram, stop); });
+    auto end = start + std::chrono::duration<double>(seconds);
+    while (Clock::now() < end) {
+        server.poll();
+    }
+    stop = true;
+    sender.join();
+
+    // Count what was received in time; drain the rest
+    result.handled = handled;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.allocations = getAllocationCount() - allocations;
+    server.poll();
+    server.stop();
+    result.sent = sent;
+    result.dropped = server.getDroppedCount();
+    return result;
+}
+
+void report(const char* name, const Result& result) {
+    std::cout << name << ": " << result.handled / result.seconds / 1e6 << " M msgs/s handled ("
+              << result.sent << " sent, " << result.handled << " handled, "
+              << result.dropped << " dropped from the queue)";
+#ifdef GFX_COUNT_ALLOCATIONS
+    std::cout << ", " << static_cast<double>(result.allocations) / result.handled << " allocations/message";
+#endif
+    std::cout << "\n";
+}
+
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+#if defined(__linux__)
+    const int port = argc > 1 ? std::atoi(argv[1]) : osc::ENGINE_PORT + 300;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+
+    // One /engine/node/param/set message, as a controller sends it
+    lo_message message = lo_message_new();
+    lo_message_add_int32(message, 12);
+    lo_message_add_string(message, "frequency");
+    lo_message_add_float(message, 0.5f);
+    std::vector<char> datagram(lo_message_length(message, osc::engine::SET_PARAMETER));
+    size_t size = datagram.size();
+    lo_message_serialise(message, osc::engine::SET_PARAMETER, datagram.data(), &size);
+    lo_message_free(message);
+
+    report("batched receive", run(port, true, seconds, datagram));
+    report("liblo receive  ", run(port + 1, false, seconds, datagram));
+    return 0;
+#else
+    std::cout << "ingest_bench needs Linux (sendmmsg/recvmmsg)" << std::endl;
+    return 0;
+#endif
+}
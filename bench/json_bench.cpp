@@ -0,0 +1,92 @@
+// Streaming JSON save and load of a large graph, with the memory the
+// load takes (resident growth) and the process peak.
+//
+// Usage: json_bench [nodes]
+#include "core/NodeGraph.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#if defined(__linux__)
+#include <fstream>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace gfx;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Peak resident set size of the process so far, in MB (0 where unknown)
+double peakMemoryMB() {
+#if defined(__linux__)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss / 1024.0;
+    }
+#endif
+    return 0.0;
+}
+
+// Current resident set size, in MB (0 where unknown)
+double residentMemoryMB() {
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (statm >> pages >> resident) {
+        return resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+    }
+#endif
+    return 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int node_count = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    // A chain of nodes, each with a scalar, a vector and a string parameter
+    std::string json;
+    {
+        NodeGraph graph;
+        for (int i = 0; i < node_count; ++i) {
+            auto node = std::make_shared<GenericNode>(i, "node" + std::to_string(i), osc::NodeType::CUSTOM);
+            node->setPosition(i * 1.5f, -i * 0.5f);
+            node->addParameter("value", osc::ParameterType::FLOAT).setValue(i * 0.5f);
+            node->addParameter("offset", osc::ParameterType::VEC3).setValue(1.0f, 2.0f, 3.0f);
+            node->addParameter("label", osc::ParameterType::STRING).setValue(std::string("label"));
+            graph.addNode(node);
+            if (i > 0) {
+                graph.addConnection(Connection(i, i - 1, "out", i, "in"));
+            }
+        }
+
+        auto start = Clock::now();
+        json = graph.toJSON();
+        auto end = Clock::now();
+        std::cout << node_count << " nodes, " << json.size() / 1e6 << " MB of JSON\n"
+                  << "save: " << milliseconds(start, end) << " ms\n";
+    }
+
+    double resident_before = residentMemoryMB();
+    NodeGraph loaded;
+    auto start = Clock::now();
+    bool ok = loaded.fromJSON(json);
+    auto end = Clock::now();
+    if (!ok || loaded.getNodes().size() != static_cast<size_t>(node_count)) {
+        std::cerr << "load failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "load: " << milliseconds(start, end) << " ms\n"
+              << "memory: " << residentMemoryMB() - resident_before << " MB resident growth, "
+              << peakMemoryMB() << " MB process peak" << std::endl;
+    return 0;
+}
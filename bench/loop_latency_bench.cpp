@@ -0,0 +1,168 @@
+// Wake-to-dispatch latency over loopback: each message carries its send
+// time and the handler measures how long it took to run. Compares the old
+// receive thread polling lo_server_recv_noblock() every 50 ms with the
+// epoll loop of one server and of four servers sharing a loop.
+//
+// Usage: loop_latency_bench [base port]
+#include "osc/OSCServer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace gfx;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int MESSAGES = 2000;
+constexpr char PATH[] = "/bench/latency";
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Latencies in ns, recorded on the receiving thread
+struct Recorder {
+    std::vector<double> latencies;
+    std::atomic<int> received{0};
+
+    Recorder() { latencies.reserve(MESSAGES); }
+
+    void record(int64_t sent) {
+        latencies.push_back(static_cast<double>(now() - sent));
+        received.fetch_add(1, std::memory_order_release);
+    }
+
+    void report(const char* name) {
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << name << ": median " << latencies[latencies.size() / 2] / 1000.0
+                  << " us, p99 " << latencies[latencies.size() * 99 / 100] / 1000.0 << " us\n";
+        latencies.clear();
+        received = 0;
+    }
+};
+
+// Send one message at a time to the given ports in turn and wait for it,
+// with a pause in between so that each message finds the receiver idle
+bool sendAll(const std::vector<lo_address>& addresses, Recorder& recorder) {
+    for (int i = 0; i < MESSAGES; ++i) {
+        lo_message message = lo_message_new();
+        lo_message_add_int64(message, now());
+        lo_send_message(addresses[i % addresses.size()], PATH, message);
+        lo_message_free(message);
+
+        auto deadline = Clock::now() + std::chrono::seconds(1);
+        while (recorder.received.load(std::memory_order_acquire) <= i) {
+            if (Clock::now() > deadline) {
+                std::cerr << "message " << i << " not received" << std::endl;
+                return false;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    return true;
+}
+
+int oldLoopHandler(const char*, const char*, lo_arg** argv, int argc, lo_message, void* user_data) {
+    if (argc == 1) {
+        static_cast<Recorder*>(user_data)->record(argv[0]->h);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int base_port = argc > 1 ? std::atoi(argv[1]) : osc::ENGINE_PORT + 200;
+    Recorder recorder;
+    auto handler = [&](const OSCMessageView& message) {
+        if (message.getArgumentCount() == 1) {
+            recorder.record(message.getInt64(0));
+        }
+    };
+    auto addressOf = [](int port) { return lo_address_new("127.0.0.1", std::to_string(port).c_str()); };
+    int result = 0;
+
+    // Before: a thread receiving with a 50 ms timeout
+    {
+        lo_server server = lo_server_new(std::to_string(base_port).c_str(), nullptr);
+        if (!server) {
+            return 1;
+        }
+        lo_server_add_method(server, PATH, "h", oldLoopHandler, &recorder);
+        std::atomic<bool> running{true};
+        std::thread thread([&] {
+            while (running) {
+                lo_server_recv_noblock(server, 50);
+            }
+        });
+        std::vector<lo_address> addresses = {addressOf(base_port)};
+        if (sendAll(addresses, recorder)) {
+            recorder.report("recv_noblock(50) thread");
+        } else {
+            result = 1;
+        }
+
+        auto start = Clock::now();
+        running = false;
+        thread.join();
+        std::cout << "  stop: " << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms\n";
+        lo_address_free(addresses[0]);
+        lo_server_free(server);
+    }
+
+    // One server on its own epoll loop
+    if (result == 0) {
+        OSCServer server(base_port + 1);
+        server.addViewHandler(PATH, handler);
+        if (!server.start()) {
+            return 1;
+        }
+        std::vector<lo_address> addresses = {addressOf(base_port + 1)};
+        if (sendAll(addresses, recorder)) {
+            recorder.report("epoll loop");
+        } else {
+            result = 1;
+        }
+
+        auto start = Clock::now();
+        server.stop();
+        std::cout << "  stop: " << std::chrono::duration<double, std::milli>(Clock::now() - start).count() << " ms\n";
+        lo_address_free(addresses[0]);
+    }
+
+    // Four servers sharing one loop thread
+    if (result == 0) {
+        auto loop = std::make_shared<OSCEventLoop>();
+        std::vector<std::unique_ptr<OSCServer>> servers;
+        std::vector<lo_address> addresses;
+        for (int k = 0; k < 4; ++k) {
+            servers.push_back(std::make_unique<OSCServer>(base_port + 2 + k));
+            servers[k]->setEventLoop(loop);
+            servers[k]->addViewHandler(PATH, handler);
+            if (!servers[k]->start()) {
+                return 1;
+            }
+            addresses.push_back(addressOf(base_port + 2 + k));
+        }
+        loop->start();
+        if (sendAll(addresses, recorder)) {
+            recorder.report("shared epoll loop, 4 servers");
+        } else {
+            result = 1;
+        }
+
+        loop->stop();
+        servers.clear();
+        for (lo_address address : addresses) {
+            lo_address_free(address);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,98 @@
+// NodeScheduler scaling from one thread to all cores on a wide graph of
+// heavy control-rate nodes (levels of independent nodes, each reading two
+// nodes of the level above).
+//
+// Usage: scheduler_bench [width] [work per node]
+#include "core/NodeGraph.h"
+#include "core/NodeScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace gfx;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int LEVELS = 8;
+constexpr int FRAMES = 20;
+
+class HeavyNode : public Node {
+public:
+    HeavyNode(int id, int work) : Node(id, "heavy", osc::NodeType::CUSTOM), work_(work) {}
+
+    void process() override {
+        double sum = 0.0;
+        for (int k = 0; k < work_; ++k) {
+            sum += std::sin(k * 0.001 + id_);
+        }
+        for (const HeavyNode* input : inputs) {
+            sum += input->value;
+        }
+        value = sum;
+    }
+
+    std::vector<const HeavyNode*> inputs;
+    double value = 0.0;
+
+private:
+    int work_;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int width = argc > 1 ? std::atoi(argv[1]) : 256;
+    const int work = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+    NodeGraph graph;
+    std::vector<std::shared_ptr<HeavyNode>> nodes;
+    int connection_id = 1;
+    for (int level = 0; level < LEVELS; ++level) {
+        for (int i = 0; i < width; ++i) {
+            auto node = std::make_shared<HeavyNode>(level * width + i, work);
+            graph.addNode(node);
+            if (level > 0) {
+                for (int k = 0; k < 2; ++k) {
+                    int source = (level - 1) * width + (i * 7 + k * 13) % width;
+                    graph.addConnection(Connection(connection_id++, source, "out", node->getId(), "in"));
+                    node->inputs.push_back(nodes[source].get());
+                }
+            }
+            nodes.push_back(node);
+        }
+    }
+
+    std::cout << LEVELS << " levels of " << width << " nodes, " << work << " iterations each\n";
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    double serial = 0.0;
+    std::vector<size_t> thread_counts;
+    for (size_t threads = 1; threads < cores; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(cores);
+    for (size_t threads : thread_counts) {
+        NodeScheduler scheduler(threads);
+        double total = 0.0;
+        for (int f = 0; f < FRAMES; ++f) {
+            for (auto& node : nodes) {
+                node->markDirty();
+            }
+            const std::vector<Node*>& dirty = graph.collectDirtyNodes();
+            auto start = Clock::now();
+            scheduler.run(graph, dirty);
+            total += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+        double frame = total / FRAMES;
+        if (threads == 1) {
+            serial = frame;
+        }
+        std::cout << threads << " thread(s): " << frame << " ms/frame, x" << serial / frame << "\n";
+    }
+    std::cout.flush();
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Frame cost of walking the cached topological order on a large graph:
+// steady frames (no edits) against edit-heavy frames (one connection
+// removed and one added per frame).
+//
+// Usage: topology_bench [nodes] [edges]
+#include "core/NodeGraph.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+using namespace gfx;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class CountingNode : public Node {
+public:
+    CountingNode(int id) : Node(id, "n", osc::NodeType::CUSTOM) {}
+    void process() override { calls++; }
+
+    uint64_t calls = 0;
+};
+
+double microseconds(Clock::time_point start, Clock::time_point end, int frames) {
+    return std::chrono::duration<double, std::micro>(end - start).count() / frames;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int node_count = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int edge_count = argc > 2 ? std::atoi(argv[2]) : 50000;
+    const int steady_frames = 1000;
+    const int edit_frames = 1000;
+
+    NodeGraph graph;
+    std::mt19937 rng(1);
+    for (int i = 1; i <= node_count; ++i) {
+        graph.addNode(std::make_shared<CountingNode>(i));
+    }
+
+    // Edges from lower to higher ids keep the graph acyclic
+    int connection_id = 1;
+    for (int e = 0; e < edge_count; ++e) {
+        int source = static_cast<int>(rng() % node_count) + 1;
+        int target = static_cast<int>(rng() % node_count) + 1;
+        if (source > target) {
+            std::swap(source, target);
+        }
+        if (source == target) {
+            continue;
+        }
+        graph.addConnection(Connection(connection_id++, source, "out", target, "in"));
+    }
+    graph.getTopologicalOrder();
+
+    uint64_t processed = 0;
+    auto start = Clock::now();
+    for (int f = 0; f < steady_frames; ++f) {
+        for (Node* node : graph.getTopologicalOrder()) {
+            node->process();
+            processed++;
+        }
+    }
+    auto steady_end = Clock::now();
+
+    // Random edges in either direction: some need re-ranking, some would
+    // close a cycle and are rejected
+    int removed = 1;
+    for (int f = 0; f < edit_frames; ++f) {
+        graph.removeConnection(removed++);
+        int source = static_cast<int>(rng() % node_count) + 1;
+        int target = static_cast<int>(rng() % node_count) + 1;
+        if (source != target) {
+            graph.addConnection(Connection(connection_id++, source, "out", target, "in"));
+        }
+        for (Node* node : graph.getTopologicalOrder()) {
+            node->process();
+            processed++;
+        }
+    }
+    auto edit_end = Clock::now();
+
+    std::cout << node_count << " nodes, " << graph.getConnections().size() << " connections\n"
+              << "steady frame: " << microseconds(start, steady_end, steady_frames) << " us\n"
+              << "edit frame:   " << microseconds(steady_end, edit_end, edit_frames) << " us\n"
+              << "(" << processed << " nodes processed)" << std::endl;
+    return 0;
+}
@@ -13,6 +13,7 @@ CodeInterpreter::CodeInterpreter()
       script_engine_(nullptr), script_context_(nullptr) {
     
     osc_server_ = std::make_unique<OSCServer>(osc::CODE_INTERPRETER_PORT);
+    osc_server_->setDispatchMode(OSCServer::DispatchMode::QUEUED);
     engine_client_ = std::make_unique<OSCClient>();
     node_editor_client_ = std::make_unique<OSCClient>();
 }
@@ -69,10 +70,10 @@ void CodeInterpreter::run() {
     
     // Send ping to other components to test connections
     if (engine_connected_) {
-        engine_client_->sendMessage(osc::common::PING);
+        engine_client_->sendMessage(std::string(osc::common::PING));
     }
     if (node_editor_connected_) {
-        node_editor_client_->sendMessage(osc::common::PING);
+        node_editor_client_->sendMessage(std::string(osc::common::PING));
     }
     
     std::cout << "Code Interpreter is running. Type commands or 'quit' to exit." << std::endl;
@@ -80,6 +81,7 @@ void CodeInterpreter::run() {
     
     // Main command processing loop
     while (running_) {
+        osc_server_->poll();
         processCommands();
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
@@ -0,0 +1,65 @@
+#include "Atom.h"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace gfx {
+
+namespace {
+
+struct AtomStorage {
+    std::shared_mutex mutex;
+    std::unordered_map<std::string_view, Atom> ids;   // Views into names
+    std::deque<std::string> names;  // deque keeps references stable on growth
+};
+
+AtomStorage& storage() {
+    static AtomStorage instance;
+    return instance;
+}
+
+} // namespace
+
+Atom AtomTable::intern(const std::string& name) {
+    AtomStorage& table = storage();
+    {
+        std::shared_lock<std::shared_mutex> lock(table.mutex);
+        auto it = table.ids.find(name);
+        if (it != table.ids.end()) {
+            return it->second;
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.ids.find(name);
+    if (it != table.ids.end()) {
+        return it->second;
+    }
+    Atom atom = static_cast<Atom>(table.names.size());
+    table.names.push_back(name);
+    table.ids.emplace(table.names.back(), atom);
+    return atom;
+}
+
+Atom AtomTable::find(std::string_view name) {
+    AtomStorage& table = storage();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.ids.find(name);
+    return (it != table.ids.end()) ? it->second : INVALID_ATOM;
+}
+
+const std::string& AtomTable::name(Atom atom) {
+    static const std::string unknown;
+    AtomStorage& table = storage();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    return (atom < table.names.size()) ? table.names[atom] : unknown;
+}
+
+size_t AtomTable::size() {
+    AtomStorage& table = storage();
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    return table.names.size();
+}
+
+} // namespace gfx
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace gfx {
+
+// Interned string ID. Parameter names (and later other identifiers) are
+// mapped to small dense integers once, so hot paths compare and index by
+// integer instead of walking string maps.
+using Atom = uint32_t;
+constexpr Atom INVALID_ATOM = 0xFFFFFFFFu;
+
+// Process-wide intern table. Atoms are never released, so an atom and the
+// string reference returned by name() stay valid for the process lifetime.
+class AtomTable {
+public:
+    // Return the atom for name, interning it on first use
+    static Atom intern(const std::string& name);
+    
+    // Return the atom for name, or INVALID_ATOM if it was never interned.
+    // Does not allocate, so a name straight from a message can be looked up.
+    static Atom find(std::string_view name);
+    
+    // Name of an interned atom (empty string for unknown atoms)
+    static const std::string& name(Atom atom);
+    
+    // Number of atoms interned so far; atoms are always below this bound
+    static size_t size();
+};
+
+} // namespace gfx
@@ -0,0 +1,257 @@
+#include "Automation.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+
+namespace gfx {
+
+namespace {
+
+bool targetLess(const Automation::Target& a, const Automation::Target& b) {
+    return std::tie(a.node_id, a.parameter, a.component) < std::tie(b.node_id, b.parameter, b.component);
+}
+
+} // namespace
+
+Automation::Automation()
+    : graph_(nullptr), structure_revision_(0), targets_dirty_(true) {
+}
+
+void Automation::setTrack(const Target& target, std::vector<Keyframe> keys, bool loop, float start_time) {
+    int existing = findTrack(target);
+    if (keys.empty()) {
+        if (existing >= 0) {
+            tracks_.erase(tracks_.begin() + existing);
+            invalidate();
+        }
+        return;
+    }
+    std::stable_sort(keys.begin(), keys.end(), [](const Keyframe& a, const Keyframe& b) {
+        return a.time < b.time;
+    });
+
+    Track track;
+    track.target = target;
+    track.keys = std::move(keys);
+    track.loop = loop;
+    track.start_time = start_time;
+
+    // Tracks stay sorted by target, so the tracks of one node are adjacent
+    if (existing >= 0) {
+        tracks_[existing] = std::move(track);
+    } else {
+        auto it = std::lower_bound(tracks_.begin(), tracks_.end(), target, [](const Track& t, const Target& key) {
+            return targetLess(t.target, key);
+        });
+        tracks_.insert(it, std::move(track));
+    }
+    invalidate();
+}
+
+void Automation::removeTracks(int node_id, Atom parameter) {
+    auto removed = std::remove_if(tracks_.begin(), tracks_.end(), [&](const Track& track) {
+        return track.target.node_id == node_id &&
+               (parameter == INVALID_ATOM || track.target.parameter == parameter);
+    });
+    if (removed != tracks_.end()) {
+        tracks_.erase(removed, tracks_.end());
+        invalidate();
+    }
+}
+
+void Automation::clear() {
+    tracks_.clear();
+    invalidate();
+}
+
+void Automation::evaluate(float time) {
+    const size_t count = tracks_.size();
+    if (values_.size() != count) {
+        local_time_.resize(count);
+        origin_.resize(count);
+        inverse_duration_.resize(count);
+        a_.resize(count);
+        b_.resize(count);
+        c_.resize(count);
+        d_.resize(count);
+        values_.resize(count);
+    }
+
+    // Segment lookup: only tracks that left their cached segment search
+    for (size_t i = 0; i < count; ++i) {
+        const Track& track = tracks_[i];
+        float local_time = localTime(track, time);
+        local_time_[i] = local_time;
+        if (!(local_time >= track.segment_begin && local_time < track.segment_end)) {
+            selectSegment(i, local_time);
+        }
+    }
+
+    // Plain loop over columns, vectorized
+    const float* local_time = local_time_.data();
+    const float* origin = origin_.data();
+    const float* inverse_duration = inverse_duration_.data();
+    const float* a = a_.data();
+    const float* b = b_.data();
+    const float* c = c_.data();
+    const float* d = d_.data();
+    float* value = values_.data();
+    for (size_t i = 0; i < count; ++i) {
+        float u = (local_time[i] - origin[i]) * inverse_duration[i];
+        value[i] = ((a[i] * u + b[i]) * u + c[i]) * u + d[i];
+    }
+}
+
+float Automation::getValue(const Target& target) const {
+    int index = findTrack(target);
+    return (index >= 0 && static_cast<size_t>(index) < values_.size()) ? values_[index] : 0.0f;
+}
+
+void Automation::apply(NodeGraph& graph, std::vector<Node*>& changed, bool all) {
+    if (targets_dirty_ || &graph != graph_ || graph.getStructureRevision() != structure_revision_) {
+        resolveTargets(graph);
+    }
+
+    const size_t count = std::min(values_.size(), bindings_.size());
+    for (size_t i = 0; i < count; ++i) {
+        Binding& binding = bindings_[i];
+        if (!binding.parameter) {
+            continue;
+        }
+        // Compare as stored: ints are truncated, bools are 0 or 1
+        float value = values_[i];
+        if (binding.type == osc::ParameterType::INT) {
+            int32_t integer = 0;
+            parameterInt(value, integer);
+            value = static_cast<float>(integer);
+        } else if (binding.type == osc::ParameterType::BOOL) {
+            value = (value != 0.0f) ? 1.0f : 0.0f;
+        }
+        uint32_t component = tracks_[i].target.component;
+        if (binding.parameter.getComponent(component) != value) {
+            binding.parameter.assignComponent(component, value);
+        } else if (!all) {
+            continue;
+        }
+
+        // Tracks of one node are adjacent
+        if (changed.empty() || changed.back() != binding.node) {
+            changed.push_back(binding.node);
+        }
+    }
+}
+
+int Automation::findTrack(const Target& target) const {
+    auto it = std::lower_bound(tracks_.begin(), tracks_.end(), target, [](const Track& t, const Target& key) {
+        return targetLess(t.target, key);
+    });
+    return (it != tracks_.end() && it->target == target) ? static_cast<int>(it - tracks_.begin()) : -1;
+}
+
+float Automation::localTime(const Track& track, float time) const {
+    float local_time = time - track.start_time;
+    if (!track.loop) {
+        return local_time;
+    }
+
+    // Loop from the first to the last key once past the first key
+    float first = track.keys.front().time;
+    float span = track.keys.back().time - first;
+    if (span <= 0.0f || local_time < first) {
+        return local_time;
+    }
+    return first + std::fmod(local_time - first, span);
+}
+
+void Automation::selectSegment(size_t index, float local_time) {
+    Track& track = tracks_[index];
+    const std::vector<Keyframe>& keys = track.keys;
+
+    // Last key at or before local_time
+    auto next = std::upper_bound(keys.begin(), keys.end(), local_time, [](float t, const Keyframe& key) {
+        return t < key.time;
+    });
+    int32_t segment = static_cast<int32_t>(next - keys.begin()) - 1;
+    track.segment = segment;
+
+    // Before the first or after the last key: hold its value
+    if (segment < 0 || next == keys.end()) {
+        const Keyframe& key = (segment < 0) ? keys.front() : keys.back();
+        track.segment_begin = (segment < 0) ? -std::numeric_limits<float>::infinity() : key.time;
+        track.segment_end = (segment < 0) ? key.time : std::numeric_limits<float>::infinity();
+        origin_[index] = 0.0f;
+        inverse_duration_[index] = 0.0f;
+        a_[index] = 0.0f;
+        b_[index] = 0.0f;
+        c_[index] = 0.0f;
+        d_[index] = key.value;
+        return;
+    }
+
+    const Keyframe& from = keys[segment];
+    const Keyframe& to = *next;
+    track.segment_begin = from.time;
+    track.segment_end = to.time;
+    origin_[index] = from.time;
+    inverse_duration_[index] = 1.0f / (to.time - from.time);
+
+    float p0 = from.value;
+    float p3 = to.value;
+    switch (from.interpolation) {
+        case Interpolation::STEP:
+            a_[index] = 0.0f;
+            b_[index] = 0.0f;
+            c_[index] = 0.0f;
+            break;
+        case Interpolation::LINEAR:
+            a_[index] = 0.0f;
+            b_[index] = 0.0f;
+            c_[index] = p3 - p0;
+            break;
+        case Interpolation::BEZIER: {
+            float p1 = from.control1;
+            float p2 = from.control2;
+            a_[index] = -p0 + 3.0f * p1 - 3.0f * p2 + p3;
+            b_[index] = 3.0f * p0 - 6.0f * p1 + 3.0f * p2;
+            c_[index] = -3.0f * p0 + 3.0f * p1;
+            break;
+        }
+    }
+    d_[index] = p0;
+}
+
+void Automation::resolveTargets(NodeGraph& graph) {
+    graph_ = &graph;
+    structure_revision_ = graph.getStructureRevision();
+    targets_dirty_ = false;
+
+    bindings_.assign(tracks_.size(), Binding());
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        const Target& target = tracks_[i].target;
+        Node* node = graph.getNode(target.node_id);
+        if (!node) {
+            continue;
+        }
+        Parameter parameter = node->getParameter(target.parameter);
+        if (parameter && target.component < parameterComponents(parameter.getType())) {
+            bindings_[i].node = node;
+            bindings_[i].parameter = parameter;
+            bindings_[i].type = parameter.getType();
+        }
+    }
+}
+
+void Automation::invalidate() {
+    // Track indices moved: every track looks its segment up again, and
+    // apply() writes nothing until the next evaluate()
+    for (Track& track : tracks_) {
+        track.segment = -1;
+        track.segment_begin = std::numeric_limits<float>::infinity();
+        track.segment_end = -std::numeric_limits<float>::infinity();
+    }
+    values_.clear();
+    targets_dirty_ = true;
+}
+
+} // namespace gfx
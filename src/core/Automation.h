@@ -0,0 +1,125 @@
+#pragma once
+
+#include "NodeGraph.h"
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// Interpolation of the segment that starts at a keyframe
+enum class Interpolation : uint8_t {
+    STEP = 0,       // Hold the key's value until the next key
+    LINEAR,
+    BEZIER          // Cubic through the key's two control values
+};
+
+// One key of an automation track. Bezier control values are in value
+// space, at one and two thirds of the segment's duration.
+struct Keyframe {
+    float time;
+    float value;
+    float control1 = 0.0f;
+    float control2 = 0.0f;
+    Interpolation interpolation = Interpolation::LINEAR;
+};
+
+// Keyframed values driving numeric parameter components, evaluated once per
+// frame by the engine instead of streaming param/set messages.
+//
+// Every segment is stored as a cubic in its normalized local time u in
+// [0, 1): step, linear and bezier segments only differ in their
+// coefficients. Each track caches its current segment and only searches the
+// keys again once its local time leaves that segment, which is rare when
+// time moves forward. The values of all tracks are then computed in one
+// branch-free loop over coefficient columns, which the compiler vectorizes
+// (-O3, i.e. Release builds).
+//
+// Tracks address parameters by node id and atom, so they survive the graph
+// being replaced; apply() resolves them again when the graph's structure
+// changes.
+class Automation {
+public:
+    struct Target {
+        int node_id;
+        Atom parameter;
+        uint32_t component;     // 0 for scalars; x, y, z, w for vectors and colors
+
+        bool operator==(const Target& other) const {
+            return node_id == other.node_id && parameter == other.parameter &&
+                   component == other.component;
+        }
+    };
+
+    Automation();
+
+    // Add a track, or replace the one with the same target. Keys are sorted
+    // by time; a track without keys is removed. Track time starts at
+    // start_time; a looping track repeats from its first to its last key.
+    void setTrack(const Target& target, std::vector<Keyframe> keys, bool loop, float start_time);
+
+    // Remove the tracks of a node, or of one of its parameters
+    void removeTracks(int node_id, Atom parameter = INVALID_ATOM);
+    void clear();
+
+    size_t getTrackCount() const { return tracks_.size(); }
+
+    // Compute the value of every track at the given time
+    void evaluate(float time);
+
+    // Value of a track after the last evaluate(); 0 for unknown targets
+    float getValue(const Target& target) const;
+
+    // Write the evaluated values into the graph. Values that did not change
+    // are skipped; nodes that were written are appended to changed once.
+    // With all set, every automated node is appended, e.g. after the
+    // consumer of changed lost the values written so far.
+    void apply(NodeGraph& graph, std::vector<Node*>& changed, bool all = false);
+
+private:
+    struct Track {
+        Target target;
+        std::vector<Keyframe> keys;
+        bool loop;
+        float start_time;
+
+        // Current segment: its index (-1 before the first key, the last
+        // key after it) and the local time range it is valid for
+        int32_t segment = -1;
+        float segment_begin = 0.0f;
+        float segment_end = 0.0f;
+    };
+
+    int findTrack(const Target& target) const;
+    float localTime(const Track& track, float time) const;
+    void selectSegment(size_t index, float local_time);
+    void resolveTargets(NodeGraph& graph);
+    void invalidate();
+
+    std::vector<Track> tracks_;
+
+    // Per track, indexed like tracks_: the current segment's cubic
+    // ((a * u + b) * u + c) * u + d with u = (t - origin) * inverse_duration
+    std::vector<float> local_time_;
+    std::vector<float> origin_;
+    std::vector<float> inverse_duration_;
+    std::vector<float> a_;
+    std::vector<float> b_;
+    std::vector<float> c_;
+    std::vector<float> d_;
+    std::vector<float> values_;
+
+    // Resolved targets for apply(), indexed like tracks_; rebuilt when the
+    // tracks, the graph or its structure change. A null parameter marks a
+    // target that does not exist (yet).
+    struct Binding {
+        Node* node = nullptr;
+        Parameter parameter;
+        osc::ParameterType type = osc::ParameterType::FLOAT;
+    };
+    const NodeGraph* graph_;
+    uint64_t structure_revision_;
+    bool targets_dirty_;
+    std::vector<Binding> bindings_;
+};
+
+} // namespace gfx
@@ -0,0 +1,107 @@
+#include "FrameArena.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace gfx {
+
+FrameArena::FrameArena(size_t initial_size)
+    : buffer_(new std::byte[initial_size]), size_(initial_size) {
+    resource_.emplace(buffer_.get(), size_, &overflow_);
+}
+
+void FrameArena::reset() {
+    if (overflow_.allocated == 0) {
+        resource_->release();
+        return;
+    }
+
+    // The last frame did not fit: grow so that it would have
+    size_t size = size_ + overflow_.allocated;
+    resource_.reset();
+    buffer_.reset(new std::byte[size]);
+    size_ = size;
+    overflow_.allocated = 0;
+    resource_.emplace(buffer_.get(), size_, &overflow_);
+}
+
+void* FrameArena::OverflowResource::do_allocate(size_t bytes, size_t alignment) {
+    allocated += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void FrameArena::OverflowResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool FrameArena::OverflowResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+#ifdef GFX_COUNT_ALLOCATIONS
+
+namespace {
+
+thread_local uint64_t thread_allocations = 0;
+std::atomic<uint64_t> total_allocations{0};
+
+void* countedAllocate(size_t size) {
+    thread_allocations++;
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* countedAllocate(size_t size, std::align_val_t alignment) {
+    thread_allocations++;
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    size = (size + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, size ? size : align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+uint64_t getThreadAllocationCount() {
+    return thread_allocations;
+}
+
+uint64_t getAllocationCount() {
+    return total_allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+uint64_t getThreadAllocationCount() {
+    return 0;
+}
+
+uint64_t getAllocationCount() {
+    return 0;
+}
+
+#endif
+
+} // namespace gfx
+
+#ifdef GFX_COUNT_ALLOCATIONS
+
+// Replacements of the global allocation functions; the other forms
+// (nothrow, aligned sized delete) forward to these by default
+void* operator new(size_t size) { return gfx::countedAllocate(size); }
+void* operator new[](size_t size) { return gfx::countedAllocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return gfx::countedAllocate(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return gfx::countedAllocate(size, alignment); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace gfx {
+
+// Scratch memory for one frame (or one message). Containers take it as a
+// std::pmr::memory_resource; allocating bumps a pointer in a buffer and
+// deallocating does nothing. reset() makes the whole buffer available
+// again, so nothing allocated from the arena may outlive the frame.
+//
+// When a frame needs more than the buffer holds, the overflow comes from
+// the heap and the buffer is grown to cover it at the next reset(). After
+// a few frames the buffer fits the working set and frames stop touching
+// the heap. Not thread-safe: use one arena per thread.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initial_size = 64 * 1024);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    std::pmr::memory_resource* getResource() { return &*resource_; }
+
+    // Release everything allocated since the last reset
+    void reset();
+
+    size_t getCapacity() const { return size_; }
+
+private:
+    // Heap fallback of the buffer resource; counts what it hands out
+    class OverflowResource : public std::pmr::memory_resource {
+    public:
+        size_t allocated = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t size_;
+    OverflowResource overflow_;
+    std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
+
+// Number of global operator new calls made by the calling thread so far.
+// Only counted in builds with GFX_COUNT_ALLOCATIONS (CMake option
+// GRAPHICS_ENGINE_COUNT_ALLOCATIONS), which replace the global operator
+// new; always 0 otherwise.
+uint64_t getThreadAllocationCount();
+
+// Number of global operator new calls made by all threads so far (same
+// builds only; always 0 otherwise)
+uint64_t getAllocationCount();
+
+} // namespace gfx
@@ -0,0 +1,92 @@
+#include "GraphDiff.h"
+#include "NodeGraph.h"
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+bool sameValue(const ParameterBlock& a, const ParameterSchema::Field& field_a,
+               const ParameterBlock& b, const ParameterSchema::Field& field_b) {
+    if (field_a.type != field_b.type) {
+        return false;
+    }
+
+    if (field_a.type == osc::ParameterType::STRING) {
+        return a.getString(field_a.slot) == b.getString(field_b.slot);
+    }
+    // Bitwise, so a value only counts as unchanged if it would upload the same
+    return std::memcmp(a.getSlot(field_a.slot).i, b.getSlot(field_b.slot).i,
+                       parameterComponents(field_a.type) * sizeof(int32_t)) == 0;
+}
+
+// Whether node_id exists in both graphs as the same kind of node
+bool isKept(const NodeGraph& from, const NodeGraph& to, int node_id) {
+    const Node* old_node = from.getNode(node_id);
+    const Node* new_node = to.getNode(node_id);
+    return old_node && new_node && old_node->getTypeId() == new_node->getTypeId() &&
+           old_node->getName() == new_node->getName();
+}
+
+// Whether graph has a connection with the same endpoints
+bool hasConnection(const NodeGraph& graph, const Connection& connection) {
+    return graph.findConnection(connection.getSourceNodeId(), connection.getSourceOutput(),
+                                connection.getTargetNodeId(), connection.getTargetInput()).isValid();
+}
+
+} // namespace
+
+GraphDiff GraphDiff::compute(const NodeGraph& from, const NodeGraph& to) {
+    GraphDiff diff;
+
+    for (const NodeEntry& entry : from.getNodes()) {
+        int id = entry.node->getId();
+        if (!isKept(from, to, id)) {
+            diff.removed_nodes.push_back(id);
+        }
+    }
+
+    for (const NodeEntry& entry : to.getNodes()) {
+        Node* node = entry.node.get();
+        const ParameterBlock& parameters = node->getParameters();
+        if (!isKept(from, to, node->getId())) {
+            diff.added_nodes.push_back(node);
+            for (size_t i = 0; i < parameters.getFieldCount(); ++i) {
+                diff.changed_parameters.push_back({node, static_cast<uint32_t>(i)});
+            }
+            continue;
+        }
+
+        const ParameterBlock& old_parameters = from.getNode(node->getId())->getParameters();
+        for (size_t i = 0; i < parameters.getFieldCount(); ++i) {
+            const ParameterSchema::Field& field = parameters.getField(i);
+            int old_field = old_parameters.findField(field.atom);
+            if (old_field < 0 ||
+                !sameValue(parameters, field, old_parameters, old_parameters.getField(old_field))) {
+                diff.changed_parameters.push_back({node, static_cast<uint32_t>(i)});
+            }
+        }
+    }
+
+    // Connections touching a removed node go away with it; connections
+    // between kept nodes are compared by endpoints
+    for (const Connection& connection : from.getConnections()) {
+        if (isKept(from, to, connection.getSourceNodeId()) &&
+            isKept(from, to, connection.getTargetNodeId()) &&
+            !hasConnection(to, connection)) {
+            diff.removed_connections.push_back(&connection);
+        }
+    }
+
+    for (const Connection& connection : to.getConnections()) {
+        if (!isKept(from, to, connection.getSourceNodeId()) ||
+            !isKept(from, to, connection.getTargetNodeId()) ||
+            !hasConnection(from, connection)) {
+            diff.added_connections.push_back(&connection);
+        }
+    }
+
+    return diff;
+}
+
+} // namespace gfx
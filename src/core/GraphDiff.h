@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+class Node;
+class Connection;
+class NodeGraph;
+
+// Edit script that turns one graph into another using the operations the
+// engine understands over OSC: node create/delete, connect/disconnect and
+// parameter set. Applying it in member order (removals, then additions,
+// then parameter values, then connections) to a graph equal to `from`
+// yields `to`.
+//
+// Nodes are matched by ID; a node whose name or type changed is deleted and
+// created again. Connections are matched by their endpoints rather than by
+// ID, since the engine assigns its own connection IDs. Editor-side state
+// (positions) is not part of the script, and parameters that exist only in
+// `from` are left alone because the engine cannot remove parameters.
+struct GraphDiff {
+    struct ParameterChange {
+        Node* node;             // Node in `to`
+        uint32_t field;         // Parameter index in that node
+    };
+
+    std::vector<const Connection*> removed_connections; // Connections in `from`; send
+                                                        // their endpoints, not their IDs
+    std::vector<int> removed_nodes;                 // Also drops their connections
+    std::vector<Node*> added_nodes;                 // Nodes in `to`; their parameters
+                                                    // are listed in changed_parameters
+    std::vector<ParameterChange> changed_parameters;
+    std::vector<const Connection*> added_connections;   // Connections in `to`
+
+    // Pointers refer into `from` and `to`, which must outlive the diff
+    static GraphDiff compute(const NodeGraph& from, const NodeGraph& to);
+
+    bool empty() const { return size() == 0; }
+    size_t size() const {
+        return removed_connections.size() + removed_nodes.size() + added_nodes.size() +
+               changed_parameters.size() + added_connections.size();
+    }
+};
+
+} // namespace gfx
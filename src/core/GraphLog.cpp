@@ -0,0 +1,618 @@
+#include "GraphLog.h"
+#include "NodeGraph.h"
+#include <algorithm>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+constexpr size_t DEFAULT_CHECKPOINT_INTERVAL = 4096;
+constexpr uint64_t DEFAULT_HISTORY_LIMIT = 64 * 1024;
+
+// Node id, field index and type in front of a SET_PARAMETER value
+constexpr size_t SET_PARAMETER_HEADER = sizeof(int32_t) + sizeof(uint16_t) + sizeof(uint8_t);
+
+template <typename T>
+void put(std::vector<uint8_t>& out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(&out[at], &value, sizeof(T));
+}
+
+void putString(std::vector<uint8_t>& out, const std::string& value) {
+    put<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+// Bytes of a numeric value on the wire (0 for strings)
+size_t valueSize(osc::ParameterType type) {
+    switch (type) {
+        case osc::ParameterType::INT:
+        case osc::ParameterType::BOOL:
+        case osc::ParameterType::FLOAT:
+            return 4;
+        case osc::ParameterType::VEC2:
+            return 8;
+        case osc::ParameterType::VEC3:
+            return 12;
+        case osc::ParameterType::VEC4:
+        case osc::ParameterType::COLOR:
+            return 16;
+        case osc::ParameterType::STRING:
+            break;
+    }
+    return 0;
+}
+
+void putValue(std::vector<uint8_t>& out, const ParameterBlock& parameters,
+              const ParameterSchema::Field& field) {
+    if (field.type == osc::ParameterType::STRING) {
+        putString(out, parameters.getString(field.slot));
+        return;
+    }
+    const ParameterSlot& slot = parameters.getSlot(field.slot);
+    size_t size = valueSize(field.type);
+    size_t at = out.size();
+    out.resize(at + size);
+    std::memcpy(&out[at], slot.f, size);
+}
+
+// Payload of ADD_NODE
+void putNode(std::vector<uint8_t>& out, const Node& node) {
+    const ParameterBlock& parameters = node.getParameters();
+    float x, y;
+    node.getPosition(x, y);
+
+    put<int32_t>(out, node.getId());
+    putString(out, node.getName());
+    putString(out, node.getTypeName());
+    put<uint8_t>(out, node.isTimeDependent() ? 1 : 0);
+    put(out, x);
+    put(out, y);
+    put<uint16_t>(out, static_cast<uint16_t>(parameters.getFieldCount()));
+    for (size_t i = 0; i < parameters.getFieldCount(); ++i) {
+        const ParameterSchema::Field& field = parameters.getField(i);
+        putString(out, AtomTable::name(field.atom));
+        put<uint8_t>(out, static_cast<uint8_t>(field.type));
+        putValue(out, parameters, field);
+    }
+}
+
+// Payload of ADD_CONNECTION
+void putConnection(std::vector<uint8_t>& out, const Connection& connection) {
+    put<int32_t>(out, connection.getId());
+    put<int32_t>(out, connection.getSourceNodeId());
+    putString(out, connection.getSourceOutput());
+    put<int32_t>(out, connection.getTargetNodeId());
+    putString(out, connection.getTargetInput());
+}
+
+// Bounds-checked cursor over an op stream
+struct Reader {
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool ok;
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (static_cast<size_t>(end - pos) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    void getString(std::string& value) {
+        uint32_t size = get<uint32_t>();
+        if (!ok || static_cast<size_t>(end - pos) < size) {
+            ok = false;
+            return;
+        }
+        value.assign(reinterpret_cast<const char*>(pos), size);
+        pos += size;
+    }
+
+    // Copy a numeric value of size bytes into a slot
+    void getValue(size_t size, ParameterSlot& slot) {
+        if (static_cast<size_t>(end - pos) < size) {
+            ok = false;
+            return;
+        }
+        std::memcpy(slot.f, pos, size);
+        pos += size;
+    }
+};
+
+bool validParameterType(uint8_t type) {
+    return type <= static_cast<uint8_t>(osc::ParameterType::COLOR);
+}
+
+} // namespace
+
+// Applies ops with the same calls a user of NodeGraph would make, so a graph
+// with its own log attached records them again
+class GraphLogReplayer {
+public:
+    GraphLogReplayer(NodeGraph& graph, const uint8_t* data, size_t size)
+        : graph_(graph), reader_{data, data + size, true} {}
+
+    bool atEnd() const { return reader_.pos == reader_.end; }
+    const uint8_t* position() const { return reader_.pos; }
+
+    bool applyNext() {
+        auto op = reader_.get<GraphLog::Op>();
+        if (!reader_.ok) {
+            return false;
+        }
+        switch (op) {
+            case GraphLog::Op::ADD_NODE:
+                return addNode();
+            case GraphLog::Op::REMOVE_NODE: {
+                int32_t node_id = reader_.get<int32_t>();
+                if (reader_.ok) {
+                    graph_.removeNode(node_id);
+                }
+                return reader_.ok;
+            }
+            case GraphLog::Op::ADD_CONNECTION: {
+                int32_t id = reader_.get<int32_t>();
+                int32_t source = reader_.get<int32_t>();
+                reader_.getString(source_output_);
+                int32_t target = reader_.get<int32_t>();
+                reader_.getString(target_input_);
+                if (reader_.ok) {
+                    graph_.addConnection(Connection(id, source, source_output_, target, target_input_));
+                }
+                return reader_.ok;
+            }
+            case GraphLog::Op::REMOVE_CONNECTION: {
+                int32_t connection_id = reader_.get<int32_t>();
+                if (reader_.ok) {
+                    graph_.removeConnection(connection_id);
+                }
+                return reader_.ok;
+            }
+            case GraphLog::Op::ADD_PARAMETER: {
+                Node* node = graph_.getNode(reader_.get<int32_t>());
+                reader_.getString(name_);
+                uint8_t type = reader_.get<uint8_t>();
+                if (!reader_.ok || !node || !validParameterType(type)) {
+                    return false;
+                }
+                node->addParameter(AtomTable::intern(name_), static_cast<osc::ParameterType>(type));
+                return true;
+            }
+            case GraphLog::Op::SET_PARAMETER:
+                return setParameter();
+            case GraphLog::Op::SET_POSITION: {
+                Node* node = graph_.getNode(reader_.get<int32_t>());
+                float x = reader_.get<float>();
+                float y = reader_.get<float>();
+                if (!reader_.ok || !node) {
+                    return false;
+                }
+                node->setPosition(x, y);
+                return true;
+            }
+            case GraphLog::Op::SET_TIME_DEPENDENT: {
+                Node* node = graph_.getNode(reader_.get<int32_t>());
+                uint8_t time_dependent = reader_.get<uint8_t>();
+                if (!reader_.ok || !node) {
+                    return false;
+                }
+                node->setTimeDependent(time_dependent != 0);
+                return true;
+            }
+            case GraphLog::Op::CLEAR:
+                graph_.clear();
+                return true;
+        }
+        return false;
+    }
+
+private:
+    bool addNode() {
+        int32_t id = reader_.get<int32_t>();
+        reader_.getString(name_);
+        reader_.getString(type_);
+        uint8_t time_dependent = reader_.get<uint8_t>();
+        float x = reader_.get<float>();
+        float y = reader_.get<float>();
+        uint16_t field_count = reader_.get<uint16_t>();
+        if (!reader_.ok) {
+            return false;
+        }
+
+        std::shared_ptr<Node> node = graph_.createNode(id, name_, type_);
+        if (!node) {
+            return false;
+        }
+
+        // The node is filled in before it joins the graph, so a logging
+        // graph records it as a single op
+        for (uint16_t i = 0; i < field_count; ++i) {
+            reader_.getString(name_);
+            uint8_t field_type = reader_.get<uint8_t>();
+            if (!reader_.ok || !validParameterType(field_type)) {
+                return false;
+            }
+            auto parameter_type = static_cast<osc::ParameterType>(field_type);
+            uint32_t field = node->parameters_.addField(AtomTable::intern(name_), parameter_type);
+            uint32_t slot = node->parameters_.getField(field).slot;
+            if (parameter_type == osc::ParameterType::STRING) {
+                reader_.getString(node->parameters_.getString(slot));
+            } else {
+                reader_.getValue(valueSize(parameter_type), node->parameters_.getSlot(slot));
+            }
+        }
+        if (!reader_.ok) {
+            return false;
+        }
+        node->setPosition(x, y);
+        node->setTimeDependent(time_dependent != 0);
+        graph_.addNode(std::move(node));
+        return true;
+    }
+
+    bool setParameter() {
+        int32_t node_id = reader_.get<int32_t>();
+        uint16_t field = reader_.get<uint16_t>();
+        uint8_t type = reader_.get<uint8_t>();
+        if (!reader_.ok) {
+            return false;
+        }
+
+        Node* node = graph_.getNode(node_id);
+        if (!node || field >= node->parameters_.getFieldCount() ||
+            static_cast<uint8_t>(node->parameters_.getField(field).type) != type) {
+            return false;
+        }
+
+        const ParameterSchema::Field& info = node->parameters_.getField(field);
+        if (info.type == osc::ParameterType::STRING) {
+            reader_.getString(node->parameters_.getString(info.slot));
+            node->markStructureChanged();
+        } else {
+            reader_.getValue(valueSize(info.type), node->parameters_.getSlot(info.slot));
+        }
+        if (!reader_.ok) {
+            return false;
+        }
+        node->markDirty();
+        node->logParameter(field);
+        return true;
+    }
+
+    NodeGraph& graph_;
+    Reader reader_;
+    std::string name_;              // Scratch strings, reused across ops
+    std::string type_;
+    std::string source_output_;
+    std::string target_input_;
+};
+
+GraphLog::GraphLog()
+    : graph_(nullptr), op_count_(0), cursor_(0), cursor_offset_(0), first_op_(0),
+      history_limit_(DEFAULT_HISTORY_LIMIT), merge_offset_(NO_MERGE),
+      checkpoint_interval_(DEFAULT_CHECKPOINT_INTERVAL), ops_since_checkpoint_(0),
+      step_depth_(0), step_started_(false), step_begin_(0) {
+}
+
+void GraphLog::recordAddNode(const Node& node) {
+    beginOp(Op::ADD_NODE);
+    putNode(bytes_, node);
+    endOp();
+}
+
+void GraphLog::recordRemoveNode(int node_id) {
+    beginOp(Op::REMOVE_NODE);
+    put<int32_t>(bytes_, node_id);
+    endOp();
+}
+
+void GraphLog::recordAddConnection(const Connection& connection) {
+    beginOp(Op::ADD_CONNECTION);
+    putConnection(bytes_, connection);
+    endOp();
+}
+
+void GraphLog::recordRemoveConnection(int connection_id) {
+    beginOp(Op::REMOVE_CONNECTION);
+    put<int32_t>(bytes_, connection_id);
+    endOp();
+}
+
+void GraphLog::recordAddParameter(const Node& node, uint32_t field) {
+    const ParameterSchema::Field& info = node.getParameters().getField(field);
+    beginOp(Op::ADD_PARAMETER);
+    put<int32_t>(bytes_, node.getId());
+    putString(bytes_, AtomTable::name(info.atom));
+    put<uint8_t>(bytes_, static_cast<uint8_t>(info.type));
+    endOp();
+}
+
+void GraphLog::recordSetParameter(const Node& node, uint32_t field) {
+    const ParameterSchema::Field& info = node.getParameters().getField(field);
+    if (merge_offset_ != NO_MERGE && cursor_ == op_count_) {
+        int32_t last_node;
+        uint16_t last_field;
+        std::memcpy(&last_node, &bytes_[merge_offset_], sizeof(last_node));
+        std::memcpy(&last_field, &bytes_[merge_offset_ + sizeof(last_node)], sizeof(last_field));
+        if (last_node == node.getId() && last_field == field) {
+            // Replace the value of the last op; the op count is unchanged
+            bytes_.resize(merge_offset_ + SET_PARAMETER_HEADER);
+            putValue(bytes_, node.getParameters(), info);
+            cursor_offset_ = bytes_.size();
+            return;
+        }
+    }
+
+    beginOp(Op::SET_PARAMETER);
+    merge_offset_ = bytes_.size();
+    put<int32_t>(bytes_, node.getId());
+    put<uint16_t>(bytes_, static_cast<uint16_t>(field));
+    put<uint8_t>(bytes_, static_cast<uint8_t>(info.type));
+    putValue(bytes_, node.getParameters(), info);
+    endOp();
+}
+
+void GraphLog::recordSetPosition(const Node& node) {
+    float x, y;
+    node.getPosition(x, y);
+    beginOp(Op::SET_POSITION);
+    put<int32_t>(bytes_, node.getId());
+    put(bytes_, x);
+    put(bytes_, y);
+    endOp();
+}
+
+void GraphLog::recordSetTimeDependent(const Node& node) {
+    beginOp(Op::SET_TIME_DEPENDENT);
+    put<int32_t>(bytes_, node.getId());
+    put<uint8_t>(bytes_, node.isTimeDependent() ? 1 : 0);
+    endOp();
+}
+
+void GraphLog::recordClear() {
+    beginOp(Op::CLEAR);
+    endOp();
+}
+
+void GraphLog::recordGraph(const NodeGraph& graph) {
+    beginStep();
+    recordClear();
+    for (const NodeEntry& entry : graph.getNodes()) {
+        recordAddNode(*entry.node);
+    }
+    for (const Connection& connection : graph.getConnections()) {
+        recordAddConnection(connection);
+    }
+    endStep();
+}
+
+void GraphLog::beginStep() {
+    // Steps never absorb ops from before or after them
+    if (step_depth_++ == 0) {
+        step_started_ = false;
+        merge_offset_ = NO_MERGE;
+    }
+}
+
+void GraphLog::endStep() {
+    if (step_depth_ > 0 && --step_depth_ == 0) {
+        if (step_started_) {
+            steps_.emplace_back(step_begin_, op_count_);
+        }
+        merge_offset_ = NO_MERGE;
+        checkpointIfDue();
+    }
+}
+
+void GraphLog::beginOp(Op op) {
+    if (cursor_ < op_count_) {
+        truncateToCursor();
+    }
+    if (step_depth_ > 0 && !step_started_) {
+        step_started_ = true;
+        step_begin_ = op_count_;
+    }
+    merge_offset_ = NO_MERGE;
+    put(bytes_, op);
+}
+
+void GraphLog::endOp() {
+    op_count_++;
+    cursor_ = op_count_;
+    cursor_offset_ = bytes_.size();
+    ops_since_checkpoint_++;
+    checkpointIfDue();
+}
+
+void GraphLog::checkpointIfDue() {
+    // Inside a step the graph may not match the ops recorded so far (e.g.
+    // recordGraph() after the owner swapped graphs), so wait for its end
+    if (step_depth_ > 0) {
+        return;
+    }
+    uint64_t interval = checkpoint_interval_;
+    if (!checkpoints_.empty()) {
+        interval = std::max(interval, checkpoints_.back().op_count);
+    }
+    if (ops_since_checkpoint_ >= interval) {
+        writeCheckpoint();
+    }
+}
+
+void GraphLog::truncateToCursor() {
+    bytes_.resize(cursor_offset_);
+    op_count_ = cursor_;
+    while (!checkpoints_.empty() && checkpoints_.back().op_index > cursor_) {
+        checkpoints_.pop_back();
+    }
+    while (!steps_.empty() && steps_.back().second > cursor_) {
+        steps_.pop_back();
+    }
+    ops_since_checkpoint_ = cursor_ - (checkpoints_.empty() ? 0 : checkpoints_.back().op_index);
+}
+
+void GraphLog::writeCheckpoint() {
+    // The checkpoint holds the last op's value, so that op is final
+    ops_since_checkpoint_ = 0;
+    merge_offset_ = NO_MERGE;
+    if (!graph_) {
+        return;
+    }
+
+    Checkpoint checkpoint;
+    checkpoint.op_index = op_count_;
+    checkpoint.offset = bytes_.size();
+    checkpoint.op_count = graph_->getNodes().size() + graph_->getConnections().size();
+    for (const NodeEntry& entry : graph_->getNodes()) {
+        put(checkpoint.state, Op::ADD_NODE);
+        putNode(checkpoint.state, *entry.node);
+    }
+    for (const Connection& connection : graph_->getConnections()) {
+        put(checkpoint.state, Op::ADD_CONNECTION);
+        putConnection(checkpoint.state, connection);
+    }
+    checkpoints_.push_back(std::move(checkpoint));
+    dropHistory();
+}
+
+void GraphLog::dropHistory() {
+    if (op_count_ - first_op_ <= history_limit_) {
+        return;
+    }
+
+    // The latest checkpoint that still leaves history_limit_ ops (and the
+    // cursor) after it becomes the base; everything before it goes.
+    // Checkpoints are only written outside steps, so no step spans the base.
+    uint64_t keep_from = std::min(op_count_ - history_limit_, cursor_);
+    auto next = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), keep_from,
+        [](uint64_t index, const Checkpoint& c) { return index < c.op_index; });
+    if (next == checkpoints_.begin()) {
+        return;
+    }
+    auto base = std::prev(next);
+    if (base->op_index == first_op_) {
+        return;
+    }
+
+    size_t shift = base->offset;
+    first_op_ = base->op_index;
+    bytes_.erase(bytes_.begin(), bytes_.begin() + shift);
+    checkpoints_.erase(checkpoints_.begin(), base);
+    for (Checkpoint& checkpoint : checkpoints_) {
+        checkpoint.offset -= shift;
+    }
+    cursor_offset_ -= shift;
+    steps_.erase(steps_.begin(), std::lower_bound(steps_.begin(), steps_.end(), std::make_pair(first_op_, uint64_t(0))));
+}
+
+bool GraphLog::undo(NodeGraph& graph) {
+    if (!canUndo()) {
+        return false;
+    }
+
+    // Undo to the start of the step containing the last op before the cursor
+    uint64_t target = cursor_ - 1;
+    auto step = std::upper_bound(steps_.begin(), steps_.end(), std::make_pair(target, UINT64_MAX));
+    if (step != steps_.begin() && target < std::prev(step)->second) {
+        target = std::prev(step)->first;
+    }
+    return restore(graph, target);
+}
+
+bool GraphLog::redo(NodeGraph& graph) {
+    if (!canRedo()) {
+        return false;
+    }
+
+    uint64_t target = cursor_ + 1;
+    auto step = std::upper_bound(steps_.begin(), steps_.end(), std::make_pair(cursor_, UINT64_MAX));
+    if (step != steps_.begin() && cursor_ < std::prev(step)->second) {
+        target = std::prev(step)->second;
+    }
+    return restore(graph, target);
+}
+
+bool GraphLog::restore(NodeGraph& graph, uint64_t op_index) {
+    if (op_index > op_count_ || op_index < first_op_) {
+        return false;
+    }
+
+    // Start from the latest checkpoint at or before op_index, or keep going
+    // from the cursor when moving the attached graph forward
+    auto checkpoint = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), op_index,
+        [](uint64_t index, const Checkpoint& c) { return index < c.op_index; });
+    const Checkpoint* base = (checkpoint != checkpoints_.begin()) ? &*std::prev(checkpoint) : nullptr;
+    const bool attached = (&graph == graph_);
+    const bool forward = attached && cursor_ <= op_index && (!base || cursor_ >= base->op_index);
+
+    GraphLog* log = graph.getLog();
+    graph.setLog(nullptr);
+
+    uint64_t index = 0;
+    size_t offset = 0;
+    bool ok = true;
+    if (forward) {
+        index = cursor_;
+        offset = cursor_offset_;
+    } else {
+        graph.clear();
+        if (base) {
+            ok = replay(graph, base->state.data(), base->state.size()) >= 0;
+            index = base->op_index;
+            offset = base->offset;
+        }
+    }
+
+    GraphLogReplayer replayer(graph, bytes_.data() + offset, bytes_.size() - offset);
+    while (ok && index < op_index) {
+        ok = replayer.applyNext();
+        index++;
+    }
+
+    graph.setLog(log);
+    if (!ok) {
+        return false;
+    }
+    if (attached) {
+        cursor_ = op_index;
+        cursor_offset_ = static_cast<size_t>(replayer.position() - bytes_.data());
+    }
+    return true;
+}
+
+void GraphLog::writeCatchUp(std::vector<uint8_t>& out) const {
+    auto checkpoint = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), cursor_,
+        [](uint64_t index, const Checkpoint& c) { return index < c.op_index; });
+    size_t offset = 0;
+
+    out.clear();
+    put(out, Op::CLEAR);
+    if (checkpoint != checkpoints_.begin()) {
+        const Checkpoint& base = *std::prev(checkpoint);
+        out.insert(out.end(), base.state.begin(), base.state.end());
+        offset = base.offset;
+    }
+    out.insert(out.end(), bytes_.begin() + offset, bytes_.begin() + cursor_offset_);
+}
+
+int64_t GraphLog::replay(NodeGraph& graph, const uint8_t* data, size_t size) {
+    GraphLogReplayer replayer(graph, data, size);
+    int64_t count = 0;
+    while (!replayer.atEnd()) {
+        if (!replayer.applyNext()) {
+            return -1;
+        }
+        count++;
+    }
+    return count;
+}
+
+} // namespace gfx
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace gfx {
+
+class Node;
+class Connection;
+class NodeGraph;
+
+// Append-only log of NodeGraph edits in a compact binary encoding. A graph
+// with an attached log (NodeGraph::setLog) records every node, connection
+// and parameter edit after it is applied, so replaying the log onto an empty
+// graph reproduces the graph exactly.
+//
+// Every few thousand ops the log stores a checkpoint: the whole graph,
+// encoded as the ops that rebuild it. Restoring a past state replays the
+// nearest checkpoint and the ops after it, so its cost is bounded by the
+// graph size plus the checkpoint interval rather than by the session length.
+// Undo and redo move a cursor through the log and restore the state at the
+// cursor; recording a new edit after an undo drops the undone ops.
+//
+// A parameter set right after a set of the same parameter replaces it rather
+// than adding an op, so a controller streaming values into one parameter
+// adds one op (and one undo step) however many values it sends. Only recent
+// history is kept: once a checkpoint is more than the history limit behind
+// the end of the log, the ops and checkpoints before it are dropped.
+//
+// Ops use host byte order. Parameter values are addressed by field index,
+// names travel as strings, so a stream written by one process (e.g. the
+// catch-up stream) can be replayed by another.
+class GraphLog {
+public:
+    enum class Op : uint8_t {
+        ADD_NODE = 1,           // Full node state: id, name, type, flags, position, parameters
+        REMOVE_NODE,
+        ADD_CONNECTION,
+        REMOVE_CONNECTION,
+        ADD_PARAMETER,
+        SET_PARAMETER,          // Node id, field index, type, value
+        SET_POSITION,
+        SET_TIME_DEPENDENT,
+        CLEAR
+    };
+
+    GraphLog();
+
+    // Ops between checkpoints. Large graphs checkpoint less often, so the
+    // cost of writing checkpoints stays proportional to the ops recorded.
+    void setCheckpointInterval(size_t ops) { checkpoint_interval_ = ops; }
+
+    // Ops that stay restorable; older history is dropped a checkpoint at a time
+    void setHistoryLimit(uint64_t ops) { history_limit_ = ops; }
+
+    // Recording; called by the attached NodeGraph and its nodes
+    void recordAddNode(const Node& node);
+    void recordRemoveNode(int node_id);
+    void recordAddConnection(const Connection& connection);
+    void recordRemoveConnection(int connection_id);
+    void recordAddParameter(const Node& node, uint32_t field);
+    void recordSetParameter(const Node& node, uint32_t field);
+    void recordSetPosition(const Node& node);
+    void recordSetTimeDependent(const Node& node);
+    void recordClear();
+
+    // Record the whole graph, e.g. after the owner switched to a graph that
+    // was loaded without a log
+    void recordGraph(const NodeGraph& graph);
+
+    // Undo steps. Ops recorded between beginStep() and endStep() are undone
+    // together; ops recorded outside a step are undone one at a time.
+    void beginStep();
+    void endStep();
+    bool canUndo() const { return cursor_ > first_op_; }
+    bool canRedo() const { return cursor_ < op_count_; }
+    bool undo(NodeGraph& graph);
+    bool redo(NodeGraph& graph);
+
+    // Rebuild graph as it was after the first op_index ops. For the attached
+    // graph this also moves the cursor there; any other graph is simply
+    // rebuilt (e.g. to inspect a past state). Fails for dropped history.
+    bool restore(NodeGraph& graph, uint64_t op_index);
+
+    // Ops up to the cursor (all ops unless something was undone), the first
+    // op still restorable, and ops in total
+    uint64_t getCursor() const { return cursor_; }
+    uint64_t getFirstOp() const { return first_op_; }
+    uint64_t getOpCount() const { return op_count_; }
+    size_t getByteSize() const { return bytes_.size(); }
+    size_t getCheckpointCount() const { return checkpoints_.size(); }
+
+    // Op stream that rebuilds the state at the cursor from any graph: the
+    // latest checkpoint before the cursor plus the ops after it
+    void writeCatchUp(std::vector<uint8_t>& out) const;
+
+    // Apply an op stream (as produced by writeCatchUp) to graph. Returns the
+    // number of ops applied, or -1 if the stream is malformed.
+    static int64_t replay(NodeGraph& graph, const uint8_t* data, size_t size);
+
+private:
+    friend class NodeGraph;
+
+    struct Checkpoint {
+        uint64_t op_index;              // Ops covered by the checkpoint
+        size_t offset;                  // Byte offset of the next op in bytes_
+        uint64_t op_count;              // Ops in state
+        std::vector<uint8_t> state;
+    };
+
+    void attach(const NodeGraph* graph) { graph_ = graph; }
+    void beginOp(Op op);
+    void endOp();
+    void checkpointIfDue();
+    void truncateToCursor();
+    void writeCheckpoint();
+    void dropHistory();
+
+    const NodeGraph* graph_;            // Graph recording into this log
+    std::vector<uint8_t> bytes_;
+    uint64_t op_count_;
+    uint64_t cursor_;
+    size_t cursor_offset_;
+    uint64_t first_op_;                 // Ops before it were dropped
+    uint64_t history_limit_;
+
+    // Payload offset of the last op while a SET_PARAMETER of the same
+    // parameter may replace it, else NO_MERGE
+    static constexpr size_t NO_MERGE = SIZE_MAX;
+    size_t merge_offset_;
+
+    std::vector<Checkpoint> checkpoints_;
+    size_t checkpoint_interval_;
+    uint64_t ops_since_checkpoint_;
+
+    // Explicit undo steps as [first op, end op) ranges, in log order
+    std::vector<std::pair<uint64_t, uint64_t>> steps_;
+    int step_depth_;
+    bool step_started_;                 // The open step has recorded an op
+    uint64_t step_begin_;
+};
+
+} // namespace gfx
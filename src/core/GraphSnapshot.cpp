@@ -0,0 +1,369 @@
+#include "GraphSnapshot.h"
+#include "GraphVersion.h"
+#include "NodeGraph.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gfx {
+
+namespace {
+
+using namespace snapshot;
+
+size_t alignSection(size_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+}
+
+// Deduplicating string table; each distinct string is stored once
+class StringTableBuilder {
+public:
+    uint32_t add(const std::string& str) {
+        auto result = index_.emplace(str, static_cast<uint32_t>(entries_.size()));
+        if (result.second) {
+            entries_.push_back({static_cast<uint32_t>(data_.size()), static_cast<uint32_t>(str.size())});
+            data_.append(str);
+        }
+        return result.first->second;
+    }
+
+    const std::vector<StringEntry>& getEntries() const { return entries_; }
+    const std::string& getData() const { return data_; }
+
+private:
+    std::unordered_map<std::string, uint32_t> index_;
+    std::vector<StringEntry> entries_;
+    std::string data_;
+};
+
+// Checks that count records of record_size fit at offset with proper alignment
+bool sectionFits(uint64_t offset, uint64_t count, size_t record_size, size_t alignment, size_t file_size) {
+    return offset % alignment == 0 &&
+           offset <= file_size &&
+           count <= (file_size - offset) / record_size;
+}
+
+#if !defined(_WIN32)
+// Map the whole file read-only; nullptr on failure
+const char* mapFile(const std::string& path, size_t& size) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open snapshot " << path << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        std::cerr << "Snapshot " << path << " is too small" << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+
+    size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map snapshot " << path << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    return static_cast<const char*>(mapping);
+}
+
+void unmapFile(const char* data, size_t size) {
+    munmap(const_cast<char*>(data), size);
+}
+#else
+// No mmap: read the file into a buffer aligned like the file's sections
+const char* mapFile(const std::string& path, size_t& size) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        std::cerr << "Failed to open snapshot " << path << std::endl;
+        return nullptr;
+    }
+
+    std::streamoff length = file.tellg();
+    if (length < static_cast<std::streamoff>(sizeof(Header))) {
+        std::cerr << "Snapshot " << path << " is too small" << std::endl;
+        return nullptr;
+    }
+
+    size = static_cast<size_t>(length);
+    char* data = static_cast<char*>(::operator new(size, std::align_val_t(SECTION_ALIGNMENT)));
+    file.seekg(0);
+    if (!file.read(data, static_cast<std::streamsize>(size))) {
+        std::cerr << "Failed to read snapshot " << path << std::endl;
+        ::operator delete(data, std::align_val_t(SECTION_ALIGNMENT));
+        return nullptr;
+    }
+    return data;
+}
+
+void unmapFile(const char* data, size_t) {
+    ::operator delete(const_cast<char*>(data), std::align_val_t(SECTION_ALIGNMENT));
+}
+#endif
+
+void copyAt(std::vector<char>& out, uint64_t offset, const void* data, size_t size) {
+    if (size > 0) {
+        std::memcpy(out.data() + offset, data, size);
+    }
+}
+
+// Collects records and strings, then lays them out as a snapshot file
+class Encoder {
+public:
+    void reserve(size_t node_count, size_t connection_count) {
+        nodes_.reserve(node_count);
+        connections_.reserve(connection_count);
+    }
+
+    void addNode(int id, const std::string& name, const std::string& type, bool time_dependent,
+                 float x, float y, const ParameterBlock& block) {
+        NodeRecord record{};
+        record.id = id;
+        record.name = strings_.add(name);
+        record.type = strings_.add(type);
+        record.flags = time_dependent ? static_cast<uint32_t>(NODE_TIME_DEPENDENT) : 0u;
+        record.x = x;
+        record.y = y;
+        record.first_parameter = static_cast<uint32_t>(parameters_.size());
+        record.parameter_count = static_cast<uint32_t>(block.getFieldCount());
+        nodes_.push_back(record);
+
+        for (size_t i = 0; i < block.getFieldCount(); ++i) {
+            const ParameterSchema::Field& field = block.getField(i);
+            ParameterRecord param{};
+            param.name = strings_.add(AtomTable::name(field.atom));
+            param.type = static_cast<uint32_t>(field.type);
+            if (field.type == osc::ParameterType::STRING) {
+                param.value.i[0] = static_cast<int32_t>(strings_.add(block.getString(field.slot)));
+            } else {
+                param.value = block.getSlot(field.slot);
+            }
+            parameters_.push_back(param);
+        }
+    }
+
+    void addConnection(const Connection& connection) {
+        ConnectionRecord record{};
+        record.id = connection.getId();
+        record.source_node = connection.getSourceNodeId();
+        record.source_output = strings_.add(connection.getSourceOutput());
+        record.target_node = connection.getTargetNodeId();
+        record.target_input = strings_.add(connection.getTargetInput());
+        connections_.push_back(record);
+    }
+
+    void finish(std::vector<char>& out) const {
+        const auto& string_entries = strings_.getEntries();
+        const std::string& string_data = strings_.getData();
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.byte_order = BYTE_ORDER_MARK;
+        header.string_count = static_cast<uint32_t>(string_entries.size());
+        header.node_count = static_cast<uint32_t>(nodes_.size());
+        header.connection_count = static_cast<uint32_t>(connections_.size());
+        header.parameter_count = static_cast<uint32_t>(parameters_.size());
+        header.node_offset = alignSection(sizeof(Header));
+        header.parameter_offset = alignSection(header.node_offset + nodes_.size() * sizeof(NodeRecord));
+        header.connection_offset = alignSection(header.parameter_offset + parameters_.size() * sizeof(ParameterRecord));
+        header.string_index_offset = alignSection(header.connection_offset + connections_.size() * sizeof(ConnectionRecord));
+        header.string_data_offset = alignSection(header.string_index_offset + string_entries.size() * sizeof(StringEntry));
+        header.string_data_size = string_data.size();
+        header.file_size = header.string_data_offset + header.string_data_size;
+
+        // Padding between sections stays zero
+        out.assign(header.file_size, 0);
+        copyAt(out, 0, &header, sizeof(header));
+        copyAt(out, header.node_offset, nodes_.data(), nodes_.size() * sizeof(NodeRecord));
+        copyAt(out, header.parameter_offset, parameters_.data(), parameters_.size() * sizeof(ParameterRecord));
+        copyAt(out, header.connection_offset, connections_.data(), connections_.size() * sizeof(ConnectionRecord));
+        copyAt(out, header.string_index_offset, string_entries.data(), string_entries.size() * sizeof(StringEntry));
+        copyAt(out, header.string_data_offset, string_data.data(), string_data.size());
+    }
+
+private:
+    StringTableBuilder strings_;
+    std::vector<NodeRecord> nodes_;
+    std::vector<ConnectionRecord> connections_;
+    std::vector<ParameterRecord> parameters_;
+};
+
+} // namespace
+
+GraphSnapshot::~GraphSnapshot() {
+    close();
+}
+
+GraphSnapshot::GraphSnapshot(GraphSnapshot&& other) noexcept {
+    *this = std::move(other);
+}
+
+GraphSnapshot& GraphSnapshot::operator=(GraphSnapshot&& other) noexcept {
+    if (this != &other) {
+        close();
+        data_ = other.data_;
+        size_ = other.size_;
+        header_ = other.header_;
+        strings_ = other.strings_;
+        nodes_ = other.nodes_;
+        connections_ = other.connections_;
+        parameters_ = other.parameters_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.header_ = nullptr;
+    }
+    return *this;
+}
+
+bool GraphSnapshot::open(const std::string& path) {
+    close();
+
+    size_t size = 0;
+    const char* data = mapFile(path, size);
+    if (!data) {
+        return false;
+    }
+    data_ = data;
+    size_ = size;
+
+    const Header* header = reinterpret_cast<const Header*>(data_);
+    const char* error = nullptr;
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        error = "not a graph snapshot";
+    } else if (header->version != VERSION) {
+        error = "unsupported version";
+    } else if (header->byte_order != BYTE_ORDER_MARK) {
+        error = "written on a machine with different byte order";
+    } else if (header->file_size != size) {
+        error = "truncated file";
+    } else if (!sectionFits(header->string_index_offset, header->string_count,
+                            sizeof(StringEntry), alignof(StringEntry), size) ||
+               !sectionFits(header->string_data_offset, header->string_data_size, 1, 1, size) ||
+               !sectionFits(header->node_offset, header->node_count,
+                            sizeof(NodeRecord), alignof(NodeRecord), size) ||
+               !sectionFits(header->connection_offset, header->connection_count,
+                            sizeof(ConnectionRecord), alignof(ConnectionRecord), size) ||
+               !sectionFits(header->parameter_offset, header->parameter_count,
+                            sizeof(ParameterRecord), alignof(ParameterRecord), size)) {
+        error = "section out of bounds";
+    }
+    if (error) {
+        std::cerr << "Invalid snapshot " << path << ": " << error << std::endl;
+        close();
+        return false;
+    }
+
+    header_ = header;
+    strings_ = reinterpret_cast<const StringEntry*>(data_ + header->string_index_offset);
+    nodes_ = reinterpret_cast<const NodeRecord*>(data_ + header->node_offset);
+    connections_ = reinterpret_cast<const ConnectionRecord*>(data_ + header->connection_offset);
+    parameters_ = reinterpret_cast<const ParameterRecord*>(data_ + header->parameter_offset);
+    return true;
+}
+
+void GraphSnapshot::close() {
+    if (data_) {
+        unmapFile(data_, size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+    strings_ = nullptr;
+    nodes_ = nullptr;
+    connections_ = nullptr;
+    parameters_ = nullptr;
+}
+
+bool GraphSnapshot::getString(uint32_t index, std::string_view& out) const {
+    if (!header_ || index >= header_->string_count) {
+        return false;
+    }
+    const StringEntry& entry = strings_[index];
+    if (entry.offset > header_->string_data_size ||
+        entry.length > header_->string_data_size - entry.offset) {
+        return false;
+    }
+    out = std::string_view(data_ + header_->string_data_offset + entry.offset, entry.length);
+    return true;
+}
+
+bool GraphSnapshot::isSnapshotPath(const std::string& path) {
+    const size_t length = std::strlen(FILE_EXTENSION);
+    return path.size() >= length && path.compare(path.size() - length, length, FILE_EXTENSION) == 0;
+}
+
+void GraphSnapshot::encode(const NodeGraph& graph, std::vector<char>& out) {
+    Encoder encoder;
+    encoder.reserve(graph.getNodes().size(), graph.getConnections().size());
+    for (const NodeEntry& entry : graph.getNodes()) {
+        const Node& node = *entry.node;
+        float x, y;
+        node.getPosition(x, y);
+        encoder.addNode(node.getId(), node.getName(), node.getTypeName(), node.isTimeDependent(),
+                        x, y, node.getParameters());
+    }
+    for (const Connection& connection : graph.getConnections()) {
+        encoder.addConnection(connection);
+    }
+    encoder.finish(out);
+}
+
+void GraphSnapshot::encode(const GraphVersion& version, std::vector<char>& out) {
+    Encoder encoder;
+    encoder.reserve(version.getNodeCount(), version.getConnectionCount());
+    for (uint32_t slot = 0; slot < version.getSlotCount(); ++slot) {
+        const NodeState* state = version.getNode(slot);
+        if (state) {
+            encoder.addNode(state->id, state->name, AtomTable::name(state->type_id), state->time_dependent,
+                            state->x, state->y, state->parameters);
+        }
+    }
+    for (uint32_t slot = 0; slot < version.getConnectionSlotCount(); ++slot) {
+        if (const Connection* connection = version.getConnection(slot)) {
+            encoder.addConnection(*connection);
+        }
+    }
+    encoder.finish(out);
+}
+
+bool GraphSnapshot::writeFile(const std::vector<char>& data, const std::string& path) {
+    std::string temp_path = path + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Failed to open " << temp_path << " for writing" << std::endl;
+        return false;
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file.close();
+
+    if (!file || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Failed to write snapshot " << path << std::endl;
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool GraphSnapshot::write(const NodeGraph& graph, const std::string& path) {
+    std::vector<char> data;
+    encode(graph, data);
+    return writeFile(data, path);
+}
+
+} // namespace gfx
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "ParameterBlock.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace gfx {
+
+class GraphVersion;
+class NodeGraph;
+
+// On-disk layout of binary graph snapshots. All sections are arrays of
+// fixed-size records addressed by offsets in the header, so a mapped file is
+// used in place without parsing. Values are stored in host byte order; the
+// header records it and files from a machine of different endianness are
+// rejected. Strings are referenced by index into the string table.
+namespace snapshot {
+
+constexpr char MAGIC[8] = {'G', 'F', 'X', 'G', 'R', 'A', 'P', 'H'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304u;
+constexpr size_t SECTION_ALIGNMENT = 16;
+constexpr const char* FILE_EXTENSION = ".gfxg";
+
+enum NodeFlags : uint32_t {
+    NODE_TIME_DEPENDENT = 1u << 0
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t string_count;
+    uint32_t node_count;
+    uint32_t connection_count;
+    uint32_t parameter_count;
+    uint64_t string_index_offset;   // StringEntry[string_count]
+    uint64_t string_data_offset;
+    uint64_t string_data_size;
+    uint64_t node_offset;           // NodeRecord[node_count]
+    uint64_t connection_offset;     // ConnectionRecord[connection_count]
+    uint64_t parameter_offset;      // ParameterRecord[parameter_count]
+    uint64_t file_size;
+};
+
+struct StringEntry {
+    uint32_t offset;    // Relative to string_data_offset
+    uint32_t length;
+};
+
+struct NodeRecord {
+    int32_t id;
+    uint32_t name;              // String index
+    uint32_t type;              // String index (Node::getTypeName)
+    uint32_t flags;             // NodeFlags
+    float x;
+    float y;
+    uint32_t first_parameter;   // Range in the parameter section
+    uint32_t parameter_count;
+};
+
+struct ConnectionRecord {
+    int32_t id;
+    int32_t source_node;
+    uint32_t source_output;     // String index
+    int32_t target_node;
+    uint32_t target_input;      // String index
+};
+
+struct ParameterRecord {
+    uint32_t name;              // String index
+    uint32_t type;              // osc::ParameterType
+    uint32_t reserved[2];
+    ParameterSlot value;        // STRING parameters keep a string index in value.i[0]
+};
+
+static_assert(sizeof(Header) == 88, "snapshot header layout changed");
+static_assert(sizeof(NodeRecord) == 32, "snapshot node record layout changed");
+static_assert(sizeof(ConnectionRecord) == 20, "snapshot connection record layout changed");
+static_assert(sizeof(ParameterRecord) == 32, "snapshot parameter record layout changed");
+
+} // namespace snapshot
+
+// Read-only view of a binary graph snapshot mapped into memory. open() only
+// maps the file and validates the header, so its cost does not depend on the
+// size of the graph; records and strings are read straight from the mapping
+// when NodeGraph::loadSnapshot() (or any other reader) asks for them. Loading
+// still copies every string the graph keeps (node names and types, string
+// parameters, connection ports): nodes own their strings and the mapping is
+// released once loading returns. On Windows the file is read into a buffer
+// instead.
+class GraphSnapshot {
+public:
+    GraphSnapshot() = default;
+    ~GraphSnapshot();
+
+    GraphSnapshot(const GraphSnapshot&) = delete;
+    GraphSnapshot& operator=(const GraphSnapshot&) = delete;
+    GraphSnapshot(GraphSnapshot&& other) noexcept;
+    GraphSnapshot& operator=(GraphSnapshot&& other) noexcept;
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return header_ != nullptr; }
+
+    size_t getStringCount() const { return header_ ? header_->string_count : 0; }
+    size_t getNodeCount() const { return header_ ? header_->node_count : 0; }
+    size_t getConnectionCount() const { return header_ ? header_->connection_count : 0; }
+    size_t getParameterCount() const { return header_ ? header_->parameter_count : 0; }
+
+    const snapshot::NodeRecord& getNode(size_t index) const { return nodes_[index]; }
+    const snapshot::ConnectionRecord& getConnection(size_t index) const { return connections_[index]; }
+    const snapshot::ParameterRecord& getParameter(size_t index) const { return parameters_[index]; }
+
+    // View into the mapping; false if the index or its entry is out of range
+    bool getString(uint32_t index, std::string_view& out) const;
+
+    // Write a graph as a snapshot. The file is written next to path and
+    // renamed over it, so readers never see a partially written snapshot.
+    static bool write(const NodeGraph& graph, const std::string& path);
+
+    // The two halves of write(): encoding the graph into the file's bytes,
+    // and writing them, so the file can be written on another thread.
+    // Published versions are immutable, so a copy of one can be encoded on
+    // another thread too.
+    static void encode(const NodeGraph& graph, std::vector<char>& out);
+    static void encode(const GraphVersion& version, std::vector<char>& out);
+    static bool writeFile(const std::vector<char>& data, const std::string& path);
+
+    // True if path has the snapshot file extension
+    static bool isSnapshotPath(const std::string& path);
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const snapshot::Header* header_ = nullptr;
+    const snapshot::StringEntry* strings_ = nullptr;
+    const snapshot::NodeRecord* nodes_ = nullptr;
+    const snapshot::ConnectionRecord* connections_ = nullptr;
+    const snapshot::ParameterRecord* parameters_ = nullptr;
+};
+
+} // namespace gfx
@@ -0,0 +1,193 @@
+#include "GraphVersion.h"
+
+namespace gfx {
+
+GraphPublisher::GraphPublisher()
+    : reader_number_(0), full_publish_(true), structure_revision_(0),
+      pending_structure_(false), pending_reset_(false) {
+
+    // The reader always finds a version, even before the first publish
+    auto version = std::make_unique<GraphVersion>();
+    version->number_ = 1;
+    version->canonical_slots_ = std::make_shared<const std::vector<uint32_t>>();
+    version->reset_ = true;
+    current_.store(version.get(), std::memory_order_release);
+    versions_.push_back(std::move(version));
+}
+
+GraphPublisher::~GraphPublisher() = default;
+
+const GraphVersion* GraphPublisher::acquire() {
+    const GraphVersion* version = current_.load(std::memory_order_acquire);
+    reader_number_.store(version->number_, std::memory_order_release);
+    return version;
+}
+
+void GraphPublisher::publish(NodeGraph& graph) {
+    graph.setChangeTracking(true);
+    graph.takeChanges(changes_);
+
+    const GraphVersion& previous = *versions_.back();
+    const uint64_t number = previous.number_ + 1;
+    const bool structure_changed = full_publish_ || graph.getStructureRevision() != structure_revision_;
+    if (!full_publish_ && !structure_changed && changes_.changed.empty() && changes_.removed.empty()) {
+        return;
+    }
+
+    // Once the reader has picked up the previous version, it has seen every
+    // change so far and the next change set starts empty
+    if (reader_number_.load(std::memory_order_acquire) >= previous.number_) {
+        for (uint32_t slot : pending_changed_) {
+            pending_marked_[slot] = 0;
+        }
+        for (uint32_t slot : pending_changed_connections_) {
+            pending_marked_connections_[slot] = 0;
+        }
+        pending_changed_.clear();
+        pending_removed_.clear();
+        pending_changed_connections_.clear();
+        pending_removed_connections_.clear();
+        pending_structure_ = false;
+        pending_reset_ = false;
+    }
+
+    auto version = std::make_unique<GraphVersion>();
+    version->number_ = number;
+
+    const NodeGraph::NodeMap& nodes = graph.getNodes();
+    if (full_publish_) {
+        // The version number doubles as the edit token: trie nodes created
+        // for this version are written in place, shared ones are copied
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            NodeHandle handle = nodes.handleAt(i);
+            version->nodes_.set(handle.index, makeState(*nodes[i].node), number);
+            markChanged(handle.index);
+        }
+        const NodeGraph::ConnectionMap& connections = graph.getConnections();
+        for (size_t i = 0; i < connections.size(); ++i) {
+            ConnectionHandle handle = connections.handleAt(i);
+            version->connections_.set(handle.index, std::make_shared<const Connection>(connections[i]), number);
+            markConnectionChanged(handle.index);
+        }
+        pending_removed_.clear();
+        pending_removed_connections_.clear();
+        pending_reset_ = true;
+    } else {
+        version->nodes_ = previous.nodes_;
+        for (const auto& removed : changes_.removed) {
+            version->nodes_.set(removed.first.index, nullptr, number);
+            pending_removed_.push_back(removed.second);
+        }
+        for (NodeHandle handle : changes_.changed) {
+            if (const Node* node = graph.getNode(handle)) {
+                version->nodes_.set(handle.index, makeState(*node), number);
+                markChanged(handle.index);
+            }
+        }
+        
+        // Removals first: a slot freed and reused since the last publish
+        // ends up holding the new connection
+        version->connections_ = previous.connections_;
+        for (const auto& removed : changes_.disconnected) {
+            version->connections_.set(removed.first.index, nullptr, number);
+            pending_removed_connections_.push_back(removed.second);
+        }
+        for (ConnectionHandle handle : changes_.connected) {
+            if (const Connection* connection = graph.getConnection(handle)) {
+                version->connections_.set(handle.index, std::make_shared<const Connection>(*connection), number);
+                markConnectionChanged(handle.index);
+            }
+        }
+    }
+
+    if (structure_changed) {
+        structure_revision_ = graph.getStructureRevision();
+        pending_structure_ = true;
+    }
+
+    version->structure_hash_ = graph.getStructureHash();
+    version->live_structure_hash_ = graph.getLiveStructureHash();
+    
+    // The canonical order only changes with the live structure, or when a
+    // live node moved to another slot (removed and added back unchanged)
+    bool canonical_changed = full_publish_ || version->live_structure_hash_ != previous.live_structure_hash_;
+    for (const auto& removed : changes_.removed) {
+        uint32_t slot = removed.first.index;
+        canonical_changed |= slot < canonical_marked_.size() && canonical_marked_[slot];
+    }
+    if (canonical_changed) {
+        for (uint32_t slot : *previous.canonical_slots_) {
+            canonical_marked_[slot] = 0;
+        }
+        graph.getCanonicalOrder(canonical_order_);
+        auto slots = std::make_shared<std::vector<uint32_t>>();
+        slots->reserve(canonical_order_.size());
+        for (NodeHandle handle : canonical_order_) {
+            slots->push_back(handle.index);
+            if (handle.index >= canonical_marked_.size()) {
+                canonical_marked_.resize(handle.index + 1, 0);
+            }
+            canonical_marked_[handle.index] = 1;
+        }
+        version->canonical_slots_ = std::move(slots);
+    } else {
+        version->canonical_slots_ = previous.canonical_slots_;
+    }
+    version->slot_count_ = nodes.capacity();
+    version->node_count_ = nodes.size();
+    version->connection_slot_count_ = graph.getConnections().capacity();
+    version->connection_count_ = graph.getConnections().size();
+    version->reset_ = pending_reset_;
+    version->structure_changed_ = pending_structure_;
+    version->changed_slots_ = pending_changed_;
+    version->removed_nodes_ = pending_removed_;
+    version->changed_connection_slots_ = pending_changed_connections_;
+    version->removed_connections_ = pending_removed_connections_;
+    full_publish_ = false;
+
+    current_.store(version.get(), std::memory_order_release);
+    versions_.push_back(std::move(version));
+    retireVersions();
+}
+
+std::shared_ptr<const NodeState> GraphPublisher::makeState(const Node& node) const {
+    auto state = std::make_shared<NodeState>();
+    state->id = node.getId();
+    state->name = node.getName();
+    state->type_id = node.getTypeId();
+    node.getPosition(state->x, state->y);
+    state->time_dependent = node.isTimeDependent();
+    state->live = node.isLive();
+    state->parameters = node.getParameters();
+    return state;
+}
+
+void GraphPublisher::markChanged(uint32_t slot) {
+    if (slot >= pending_marked_.size()) {
+        pending_marked_.resize(slot + 1, 0);
+    }
+    if (!pending_marked_[slot]) {
+        pending_marked_[slot] = 1;
+        pending_changed_.push_back(slot);
+    }
+}
+
+void GraphPublisher::markConnectionChanged(uint32_t slot) {
+    if (slot >= pending_marked_connections_.size()) {
+        pending_marked_connections_.resize(slot + 1, 0);
+    }
+    if (!pending_marked_connections_[slot]) {
+        pending_marked_connections_[slot] = 1;
+        pending_changed_connections_.push_back(slot);
+    }
+}
+
+void GraphPublisher::retireVersions() {
+    // The reader only touches the version it acquired last (or a newer one)
+    uint64_t in_use = reader_number_.load(std::memory_order_acquire);
+    while (versions_.size() > 1 && versions_.front()->number_ < in_use) {
+        versions_.pop_front();
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "NodeGraph.h"
+#include "PersistentArray.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+// Published state of one node. Immutable once published and shared by every
+// version in which the node did not change.
+struct NodeState {
+    int id;
+    std::string name;
+    Atom type_id;
+    float x, y;
+    bool time_dependent;
+    bool live;                  // Reaches an output node (see NodeGraph::isLive)
+    ParameterBlock parameters;
+};
+
+// Immutable version of a graph as published by GraphPublisher. Node states
+// and connections are indexed by the slot of their handle in the writer's
+// graph and stored in persistent arrays, so consecutive versions share
+// every node and connection that did not change. Each version also carries the changes since the
+// version the reader acquired before it, which lets the reader update its
+// own state without comparing whole graphs.
+class GraphVersion {
+public:
+    uint64_t getNumber() const { return number_; }
+
+    // Node state in a slot, or null if the slot is empty
+    const NodeState* getNode(uint32_t slot) const { return nodes_.get(slot).get(); }
+    size_t getSlotCount() const { return slot_count_; }
+    size_t getNodeCount() const { return node_count_; }
+
+    // Connection in a slot (of its handle in the writer's graph), or null
+    // if the slot is empty. Stored like node states, so versions share every
+    // connection that did not change.
+    const Connection* getConnection(uint32_t slot) const { return connections_.get(slot).get(); }
+    size_t getConnectionSlotCount() const { return connection_slot_count_; }
+    size_t getConnectionCount() const { return connection_count_; }
+
+    // Slots of the live nodes in the writer graph's canonical order (see
+    // NodeGraph::getCanonicalOrder)
+    const std::vector<uint32_t>& getCanonicalSlots() const { return *canonical_slots_; }
+
+    // Writer graph's NodeGraph::getStructureHash() and
+    // getLiveStructureHash() at publish time
+    uint64_t getStructureHash() const { return structure_hash_; }
+    uint64_t getLiveStructureHash() const { return live_structure_hash_; }
+
+    // Changes since the version the reader acquired before this one.
+    // A reset version replaces the whole graph.
+    bool isReset() const { return reset_; }
+    bool hasStructureChanged() const { return structure_changed_; }
+    const std::vector<uint32_t>& getChangedSlots() const { return changed_slots_; }
+    const std::vector<int>& getRemovedNodes() const { return removed_nodes_; }
+    const std::vector<uint32_t>& getChangedConnectionSlots() const { return changed_connection_slots_; }
+    const std::vector<int>& getRemovedConnections() const { return removed_connections_; }
+
+private:
+    friend class GraphPublisher;
+
+    uint64_t number_ = 0;
+    PersistentArray<std::shared_ptr<const NodeState>> nodes_;
+    size_t slot_count_ = 0;
+    size_t node_count_ = 0;
+    PersistentArray<std::shared_ptr<const Connection>> connections_;
+    size_t connection_slot_count_ = 0;
+    size_t connection_count_ = 0;
+    std::shared_ptr<const std::vector<uint32_t>> canonical_slots_;
+    uint64_t structure_hash_ = 0;
+    uint64_t live_structure_hash_ = 0;
+
+    bool reset_ = false;
+    bool structure_changed_ = false;
+    std::vector<uint32_t> changed_slots_;
+    std::vector<int> removed_nodes_;
+    std::vector<uint32_t> changed_connection_slots_;
+    std::vector<int> removed_connections_;
+};
+
+// Hands versions of a graph from one writer thread to one reader thread.
+// The writer edits its NodeGraph as usual and calls publish(); only nodes
+// and connections changed since the last publish are copied. The reader calls acquire()
+// once per frame, which is a single atomic load and never blocks.
+//
+// Versions are reclaimed by the writer once the reader has moved past them:
+// the reader announces the number of the version it acquired, and versions
+// older than that are no longer reachable from the reader.
+class GraphPublisher {
+public:
+    GraphPublisher();
+    ~GraphPublisher();
+
+    GraphPublisher(const GraphPublisher&) = delete;
+    GraphPublisher& operator=(const GraphPublisher&) = delete;
+
+    // Writer thread. Publishes nothing if the graph did not change.
+    void publish(NodeGraph& graph);
+
+    // Writer thread: publish the whole graph next time, e.g. after the
+    // writer switched to a different NodeGraph
+    void reset() { full_publish_ = true; }
+
+    // Reader thread: latest version; stays valid until the next acquire()
+    const GraphVersion* acquire();
+
+private:
+    std::shared_ptr<const NodeState> makeState(const Node& node) const;
+    void markChanged(uint32_t slot);
+    void markConnectionChanged(uint32_t slot);
+    void retireVersions();
+
+    std::atomic<const GraphVersion*> current_;
+    std::atomic<uint64_t> reader_number_;                  // Version the reader last acquired
+    std::deque<std::unique_ptr<GraphVersion>> versions_;   // Oldest first; back() is current_
+
+    bool full_publish_;
+    uint64_t structure_revision_;
+    NodeGraph::Changes changes_;
+    std::vector<NodeHandle> canonical_order_;
+    std::vector<uint8_t> canonical_marked_;     // Slots in the current canonical order
+
+    // Changes accumulated since the version the reader last acquired
+    std::vector<uint32_t> pending_changed_;
+    std::vector<uint8_t> pending_marked_;   // Indexed by slot
+    std::vector<int> pending_removed_;
+    std::vector<uint32_t> pending_changed_connections_;
+    std::vector<uint8_t> pending_marked_connections_;    // Indexed by slot
+    std::vector<int> pending_removed_connections_;
+    bool pending_structure_;
+    bool pending_reset_;
+};
+
+} // namespace gfx
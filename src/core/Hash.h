@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gfx {
+
+// Non-cryptographic 64-bit hashing for cache keys. Results depend only on
+// the bytes hashed, never on addresses or per-process state, so keys stay
+// the same across runs.
+
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+// FNV-1a
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t hashString(const std::string& value, uint64_t hash = FNV_OFFSET_BASIS) {
+    return hashBytes(value.data(), value.size(), hash);
+}
+
+// FNV-1a of a NUL-terminated string, usable in constant expressions; equal
+// to hashString of the same characters
+constexpr uint64_t hashString(const char* value, uint64_t hash = FNV_OFFSET_BASIS) {
+    for (; *value; ++value) {
+        hash = (hash ^ static_cast<unsigned char>(*value)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+// Bijective finalizer (splitmix64); spreads every input bit over the result
+inline uint64_t hashMix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
+
+// Order-dependent combination of two hashes
+inline uint64_t hashCombine(uint64_t seed, uint64_t value) {
+    return hashMix(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+}
+
+} // namespace gfx
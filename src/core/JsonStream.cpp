@@ -0,0 +1,426 @@
+#include "JsonStream.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+
+namespace gfx {
+
+namespace {
+constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+}
+
+// JsonWriter implementation
+JsonWriter::JsonWriter(std::ostream& stream)
+    : stream_(&stream), output_(nullptr), first_in_scope_(true), after_key_(false) {
+    buffer_.reserve(FLUSH_THRESHOLD + 256);
+}
+
+JsonWriter::JsonWriter(std::string& output)
+    : stream_(nullptr), output_(&output), first_in_scope_(true), after_key_(false) {
+}
+
+JsonWriter::~JsonWriter() {
+    flush();
+}
+
+void JsonWriter::beginObject() {
+    separator();
+    append("{", 1);
+    first_in_scope_ = true;
+}
+
+void JsonWriter::endObject() {
+    append("}", 1);
+    first_in_scope_ = false;
+}
+
+void JsonWriter::beginArray() {
+    separator();
+    append("[", 1);
+    first_in_scope_ = true;
+}
+
+void JsonWriter::endArray() {
+    append("]", 1);
+    first_in_scope_ = false;
+}
+
+void JsonWriter::key(const char* name) {
+    separator();
+    writeString(name, std::strlen(name));
+    append(":", 1);
+    after_key_ = true;
+}
+
+void JsonWriter::value(const std::string& str) {
+    separator();
+    writeString(str.data(), str.size());
+}
+
+void JsonWriter::value(const char* str) {
+    separator();
+    writeString(str, std::strlen(str));
+}
+
+void JsonWriter::value(int number) {
+    separator();
+    char digits[16];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    append(digits, result.ptr - digits);
+}
+
+void JsonWriter::value(float number) {
+    separator();
+    // JSON has no representation for NaN or infinity
+    if (!std::isfinite(number)) {
+        number = 0.0f;
+    }
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    append(digits, result.ptr - digits);
+}
+
+void JsonWriter::value(bool boolean) {
+    separator();
+    if (boolean) {
+        append("true", 4);
+    } else {
+        append("false", 5);
+    }
+}
+
+void JsonWriter::flush() {
+    if (stream_ && !buffer_.empty()) {
+        stream_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+}
+
+void JsonWriter::separator() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (!first_in_scope_) {
+        append(",", 1);
+    }
+    first_in_scope_ = false;
+}
+
+void JsonWriter::writeString(const char* str, size_t length) {
+    static const char hex[] = "0123456789abcdef";
+    append("\"", 1);
+    
+    // Copy runs of plain characters in one go; escape the rest
+    size_t run_start = 0;
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        append(str + run_start, i - run_start);
+        run_start = i + 1;
+        
+        switch (c) {
+            case '"': append("\\\"", 2); break;
+            case '\\': append("\\\\", 2); break;
+            case '\n': append("\\n", 2); break;
+            case '\r': append("\\r", 2); break;
+            case '\t': append("\\t", 2); break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                append(escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    append(str + run_start, length - run_start);
+    append("\"", 1);
+}
+
+void JsonWriter::append(const char* data, size_t length) {
+    if (output_) {
+        output_->append(data, length);
+        return;
+    }
+    buffer_.append(data, length);
+    if (buffer_.size() >= FLUSH_THRESHOLD) {
+        flush();
+    }
+}
+
+// JsonReader implementation
+JsonReader::JsonReader(const char* data, size_t size)
+    : cursor_(data), begin_(data), end_(data + size), just_opened_(false) {
+}
+
+bool JsonReader::beginObject() {
+    if (!expect('{')) {
+        return false;
+    }
+    just_opened_ = true;
+    return true;
+}
+
+bool JsonReader::beginArray() {
+    if (!expect('[')) {
+        return false;
+    }
+    just_opened_ = true;
+    return true;
+}
+
+bool JsonReader::nextKey(std::string& key) {
+    if (failed()) {
+        return false;
+    }
+    skipWhitespace();
+    if (cursor_ < end_ && *cursor_ == '}') {
+        ++cursor_;
+        just_opened_ = false;
+        return false;
+    }
+    if (!just_opened_ && !expect(',')) {
+        return false;
+    }
+    just_opened_ = false;
+    return readString(key) && expect(':');
+}
+
+bool JsonReader::nextElement() {
+    if (failed()) {
+        return false;
+    }
+    skipWhitespace();
+    if (cursor_ < end_ && *cursor_ == ']') {
+        ++cursor_;
+        just_opened_ = false;
+        return false;
+    }
+    if (!just_opened_ && !expect(',')) {
+        return false;
+    }
+    just_opened_ = false;
+    return true;
+}
+
+bool JsonReader::readString(std::string& out) {
+    if (!expect('"')) {
+        return false;
+    }
+    out.clear();
+    
+    const char* run_start = cursor_;
+    while (cursor_ < end_) {
+        char c = *cursor_;
+        if (c == '"') {
+            out.append(run_start, cursor_ - run_start);
+            ++cursor_;
+            return true;
+        }
+        if (c != '\\') {
+            ++cursor_;
+            continue;
+        }
+        
+        out.append(run_start, cursor_ - run_start);
+        if (++cursor_ >= end_) {
+            break;
+        }
+        switch (*cursor_++) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                auto readHex = [this](uint32_t& code) {
+                    if (end_ - cursor_ < 4) {
+                        return false;
+                    }
+                    auto result = std::from_chars(cursor_, cursor_ + 4, code, 16);
+                    if (result.ptr != cursor_ + 4) {
+                        return false;
+                    }
+                    cursor_ += 4;
+                    return true;
+                };
+                uint32_t code = 0;
+                if (!readHex(code)) {
+                    return fail("invalid \\u escape");
+                }
+                // Combine UTF-16 surrogate pairs
+                if (code >= 0xD800 && code < 0xDC00 && end_ - cursor_ >= 6 &&
+                    cursor_[0] == '\\' && cursor_[1] == 'u') {
+                    cursor_ += 2;
+                    uint32_t low = 0;
+                    if (!readHex(low) || low < 0xDC00 || low > 0xDFFF) {
+                        return fail("invalid surrogate pair");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                // Encode as UTF-8
+                if (code < 0x80) {
+                    out += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default:
+                return fail("invalid escape sequence");
+        }
+        run_start = cursor_;
+    }
+    return fail("unterminated string");
+}
+
+bool JsonReader::readNumberToken(const char*& begin, const char*& end) {
+    skipWhitespace();
+    begin = cursor_;
+    while (cursor_ < end_ && (std::strchr("+-.eE", *cursor_) || (*cursor_ >= '0' && *cursor_ <= '9'))) {
+        ++cursor_;
+    }
+    end = cursor_;
+    return (begin != end) || fail("expected number");
+}
+
+bool JsonReader::readInt(int& out) {
+    const char* begin;
+    const char* end;
+    if (!readNumberToken(begin, end)) {
+        return false;
+    }
+    auto result = std::from_chars(begin, end, out);
+    return (result.ec == std::errc() && result.ptr == end) || fail("invalid integer");
+}
+
+bool JsonReader::readFloat(float& out) {
+    const char* begin;
+    const char* end;
+    if (!readNumberToken(begin, end)) {
+        return false;
+    }
+    auto result = std::from_chars(begin, end, out);
+    return (result.ec == std::errc() && result.ptr == end) || fail("invalid number");
+}
+
+bool JsonReader::readBool(bool& out) {
+    skipWhitespace();
+    size_t remaining = end_ - cursor_;
+    if (remaining >= 4 && std::memcmp(cursor_, "true", 4) == 0) {
+        cursor_ += 4;
+        out = true;
+        return true;
+    }
+    if (remaining >= 5 && std::memcmp(cursor_, "false", 5) == 0) {
+        cursor_ += 5;
+        out = false;
+        return true;
+    }
+    return fail("expected boolean");
+}
+
+bool JsonReader::skipValue() {
+    skipWhitespace();
+    if (cursor_ >= end_) {
+        return fail("unexpected end of input");
+    }
+    
+    std::string scratch;
+    switch (*cursor_) {
+        case '"':
+            return readString(scratch);
+        case '{':
+            beginObject();
+            while (nextKey(scratch)) {
+                if (!skipValue()) {
+                    return false;
+                }
+            }
+            return !failed();
+        case '[':
+            beginArray();
+            while (nextElement()) {
+                if (!skipValue()) {
+                    return false;
+                }
+            }
+            return !failed();
+        case 't':
+        case 'f': {
+            bool ignored;
+            return readBool(ignored);
+        }
+        case 'n':
+            if (end_ - cursor_ >= 4 && std::memcmp(cursor_, "null", 4) == 0) {
+                cursor_ += 4;
+                return true;
+            }
+            return fail("invalid literal");
+        default: {
+            const char* begin;
+            const char* end;
+            return readNumberToken(begin, end);
+        }
+    }
+}
+
+bool JsonReader::peekString() {
+    skipWhitespace();
+    return cursor_ < end_ && *cursor_ == '"';
+}
+
+bool JsonReader::peekArray() {
+    skipWhitespace();
+    return cursor_ < end_ && *cursor_ == '[';
+}
+
+bool JsonReader::atEnd() {
+    skipWhitespace();
+    return cursor_ >= end_;
+}
+
+void JsonReader::skipWhitespace() {
+    while (cursor_ < end_ && (*cursor_ == ' ' || *cursor_ == '\n' || *cursor_ == '\r' || *cursor_ == '\t')) {
+        ++cursor_;
+    }
+}
+
+bool JsonReader::expect(char c) {
+    if (failed()) {
+        return false;
+    }
+    skipWhitespace();
+    if (cursor_ < end_ && *cursor_ == c) {
+        ++cursor_;
+        return true;
+    }
+    char message[32];
+    std::snprintf(message, sizeof(message), "expected '%c'", c);
+    return fail(message);
+}
+
+bool JsonReader::fail(const char* message) {
+    if (error_.empty()) {
+        error_ = std::string(message) + " at offset " + std::to_string(cursor_ - begin_);
+    }
+    return false;
+}
+
+} // namespace gfx
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace gfx {
+
+// Streaming JSON writer. Output is appended to an internal buffer that is
+// flushed to the target stream in large chunks, so documents of any size are
+// written without building them in memory. Numbers are formatted with
+// std::to_chars (shortest round-trip representation, locale independent).
+class JsonWriter {
+public:
+    explicit JsonWriter(std::ostream& stream);
+    explicit JsonWriter(std::string& output);
+    ~JsonWriter();
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    // Object key; must be followed by exactly one value
+    void key(const char* name);
+
+    void value(const std::string& str);
+    void value(const char* str);
+    void value(int number);
+    void value(float number);
+    void value(bool boolean);
+
+    void flush();
+
+private:
+    void separator();
+    void writeString(const char* str, size_t length);
+    void append(const char* data, size_t length);
+
+    std::ostream* stream_;
+    std::string* output_;
+    std::string buffer_;
+    bool first_in_scope_;
+    bool after_key_;
+};
+
+// Single-pass pull parser over an in-memory JSON document. Callers walk the
+// document with the typed read functions and write values straight into
+// their own objects; no intermediate tree is built. Every function returns
+// false on malformed input, after which getError() describes the problem.
+class JsonReader {
+public:
+    JsonReader(const char* data, size_t size);
+
+    bool beginObject();
+    bool beginArray();
+
+    // Iterate members of the current object: returns true and sets key while
+    // members remain, false at the closing brace (or on error)
+    bool nextKey(std::string& key);
+
+    // Iterate elements of the current array: true while elements remain
+    bool nextElement();
+
+    bool readString(std::string& out);
+    bool readInt(int& out);
+    bool readFloat(float& out);
+    bool readBool(bool& out);
+
+    // Skip over any value, including nested objects and arrays
+    bool skipValue();
+
+    // True if the next value is of the given kind (does not consume it)
+    bool peekString();
+    bool peekArray();
+
+    bool atEnd();
+    bool failed() const { return !error_.empty(); }
+    const std::string& getError() const { return error_; }
+
+private:
+    void skipWhitespace();
+    bool expect(char c);
+    bool fail(const char* message);
+    bool readNumberToken(const char*& begin, const char*& end);
+
+    const char* cursor_;
+    const char* begin_;
+    const char* end_;
+    bool just_opened_;      // No member or element read yet in the innermost scope
+    std::string error_;
+};
+
+} // namespace gfx
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace gfx {
+
+// Bounded lock-free queue for many producers and one consumer (Vyukov's
+// bounded queue). Every cell carries a sequence number telling whose turn
+// it is: producers claim a cell by advancing tail_ with a CAS, fill it and
+// publish it by bumping its sequence; the consumer takes cells in order.
+//
+// Values live in the cells and are filled and consumed in place, so a cell's
+// value (e.g. a std::string) keeps its capacity from one use to the next and
+// a warmed-up queue does not allocate. Nothing blocks: tryPush() fails when
+// the queue is full and tryPop() when the next cell is not published yet.
+template <typename T>
+class MpscQueue {
+public:
+    // Capacity is rounded up to a power of two
+    explicit MpscQueue(size_t capacity) : head_(0) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        mask_ = size - 1;
+        cells_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Any thread: fill(T&) writes the value into a free cell. Returns false,
+    // without calling fill, when the queue is full.
+    template <typename Fill>
+    bool tryPush(Fill&& fill) {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    fill(cell.value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only: consume(T&) reads the oldest value, which stays
+    // in the cell for reuse. Returns false when there is nothing to take.
+    template <typename Consume>
+    bool tryPop(Consume&& consume) {
+        Cell& cell = cells_[head_ & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+            return false;
+        }
+        consume(cell.value);
+        cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        head_++;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> tail_;     // Next cell to claim (producers)
+    alignas(64) size_t head_;                  // Next cell to take (consumer)
+};
+
+} // namespace gfx
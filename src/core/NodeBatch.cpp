@@ -0,0 +1,335 @@
+#include "NodeBatch.h"
+#include <algorithm>
+#include <functional>
+#include <memory_resource>
+#include <unordered_map>
+
+namespace gfx {
+
+NodeBatchProcessor::NodeBatchProcessor(const NodeRegistry& registry)
+    : registry_(registry), graph_(nullptr), structure_revision_(0),
+      batched_count_(0), kernel_calls_(0) {
+}
+
+void NodeBatchProcessor::run(const NodeGraph& graph, const std::vector<Node*>& nodes, float time,
+                             std::vector<Node*>& remaining, bool all) {
+    // Fresh tables hold no outputs yet, so every slice runs once
+    bool rebuilt = (&graph != graph_ || graph.getStructureRevision() != structure_revision_);
+    if (rebuilt) {
+        rebuild(graph);
+    } else {
+        for (Node* node : graph.getChangedNodes()) {
+            const RowRef* ref = findRow(*node);
+            if (ref) {
+                loadParameters(tables_[ref->table], ref->row);
+            }
+        }
+    }
+
+    batched_count_ = 0;
+    kernel_calls_ = 0;
+    slice_active_.assign(slices_.size(), rebuilt ? 1 : 0);
+    for (Node* node : nodes) {
+        const RowRef* ref = findRow(*node);
+        if (ref) {
+            slice_active_[ref->slice] = 1;
+            batched_count_++;
+        } else {
+            remaining.push_back(node);
+        }
+    }
+
+    for (size_t s = 0; s < slices_.size(); ++s) {
+        if (!slice_active_[s]) {
+            continue;
+        }
+        const Slice& slice = slices_[s];
+        Table& table = tables_[slice.table];
+        const size_t rows = table.rows();
+        const size_t parameter_count = table.parameter_columns.size();
+        const size_t input_count = table.input_columns.size();
+
+        // Gather upstream outputs; earlier levels have already run
+        for (size_t c = 0; c < input_count; ++c) {
+            float* column = table.column(parameter_count + c);
+            const float* const* sources = table.input_sources.data() + c * rows;
+            for (uint32_t row = slice.begin; row < slice.end; ++row) {
+                column[row] = sources[row] ? *sources[row] : 0.0f;
+            }
+        }
+
+        for (size_t c = 0; c < parameter_count; ++c) {
+            table.parameter_pointers[c] = table.column(c) + slice.begin;
+        }
+        for (size_t c = 0; c < input_count; ++c) {
+            table.input_pointers[c] = table.column(parameter_count + c) + slice.begin;
+        }
+        for (size_t c = 0; c < table.output_columns.size(); ++c) {
+            table.output_pointers[c] = table.column(parameter_count + input_count + c) + slice.begin;
+        }
+
+        BatchView view;
+        view.count = slice.end - slice.begin;
+        view.time = time;
+        view.parameters = table.parameter_pointers.data();
+        view.inputs = table.input_pointers.data();
+        view.outputs = table.output_pointers.data();
+        table.kind->batch_kernel(view);
+        kernel_calls_++;
+    }
+    writeSinks(all);
+}
+
+float NodeBatchProcessor::getOutput(const Node& node, Atom port, uint32_t component) const {
+    const RowRef* ref = findRow(node);
+    if (!ref) {
+        return 0.0f;
+    }
+    const Table& table = tables_[ref->table];
+    const size_t first = table.parameter_columns.size() + table.input_columns.size();
+    for (size_t c = 0; c < table.output_columns.size(); ++c) {
+        const Column& column = table.output_columns[c];
+        if (column.atom == port && column.component == component) {
+            return table.column(first + c)[ref->row];
+        }
+    }
+    return 0.0f;
+}
+
+void NodeBatchProcessor::rebuild(const NodeGraph& graph) {
+    graph_ = &graph;
+    structure_revision_ = graph.getStructureRevision();
+    tables_.clear();
+    slices_.clear();
+
+    const std::vector<Node*>& order = graph.getTopologicalOrder();
+    uint32_t slot_count = 0;
+    for (const Node* node : order) {
+        slot_count = std::max(slot_count, node->getGraphHandle().index + 1);
+    }
+    rows_.assign(slot_count, RowRef());
+
+    // Levels count batched nodes only: a node fed by none of them runs first
+    struct Entry {
+        uint32_t table;
+        uint32_t level;
+        Node* node;
+    };
+    std::pmr::memory_resource* scratch = graph.getScratchResource();
+    std::pmr::vector<Entry> entries(scratch);
+    std::pmr::vector<int32_t> levels(slot_count, -1, scratch);
+    std::pmr::unordered_map<const NodeKind*, uint32_t> table_of_kind(scratch);
+    for (Node* node : order) {
+        const NodeKind* kind = registry_.findKind(node->getTypeId());
+        if (!kind || !kind->batch_kernel || (graph.getDeadNodePruning() && !node->isLive())) {
+            continue;
+        }
+
+        NodeHandle handle = node->getGraphHandle();
+        int32_t level = 0;
+        for (const Edge& edge : graph.getIncomingConnections(handle)) {
+            if (edge.peer.index < slot_count && levels[edge.peer.index] >= 0) {
+                level = std::max(level, levels[edge.peer.index] + 1);
+            }
+        }
+        levels[handle.index] = level;
+
+        auto inserted = table_of_kind.emplace(kind, static_cast<uint32_t>(tables_.size()));
+        if (inserted.second) {
+            Table table;
+            table.kind = kind;
+            const ParameterBlock& defaults = kind->defaults;
+            for (size_t i = 0; i < defaults.getFieldCount(); ++i) {
+                const ParameterSchema::Field& field = defaults.getField(i);
+                for (uint32_t c = 0; c < parameterComponents(field.type); ++c) {
+                    table.parameter_columns.push_back({field.atom, field.type, c});
+                }
+            }
+            for (const NodePort& port : kind->inputs) {
+                for (uint32_t c = 0; c < parameterComponents(port.type); ++c) {
+                    table.input_columns.push_back({port.name, port.type, c});
+                }
+            }
+            for (const NodePort& port : kind->outputs) {
+                for (uint32_t c = 0; c < parameterComponents(port.type); ++c) {
+                    table.output_columns.push_back({port.name, port.type, c});
+                }
+            }
+            tables_.push_back(std::move(table));
+        }
+        entries.push_back({inserted.first->second, static_cast<uint32_t>(level), node});
+    }
+
+    // Rows grouped by level within each table; stable, so topological
+    // order is kept inside a slice
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return (a.table != b.table) ? a.table < b.table : a.level < b.level;
+    });
+    for (const Entry& entry : entries) {
+        Table& table = tables_[entry.table];
+        uint32_t row = static_cast<uint32_t>(table.nodes.size());
+        if (slices_.empty() || slices_.back().table != entry.table || slices_.back().level != entry.level) {
+            slices_.push_back({entry.table, row, row, entry.level});
+        }
+        slices_.back().end = row + 1;
+        table.nodes.push_back(entry.node);
+        RowRef& ref = rows_[entry.node->getGraphHandle().index];
+        ref.table = entry.table;
+        ref.row = row;
+    }
+    std::stable_sort(slices_.begin(), slices_.end(), [](const Slice& a, const Slice& b) {
+        return a.level < b.level;
+    });
+    for (uint32_t s = 0; s < slices_.size(); ++s) {
+        const Slice& slice = slices_[s];
+        const Table& table = tables_[slice.table];
+        for (uint32_t row = slice.begin; row < slice.end; ++row) {
+            rows_[table.nodes[row]->getGraphHandle().index].slice = s;
+        }
+    }
+
+    for (Table& table : tables_) {
+        const size_t columns = table.parameter_columns.size() + table.input_columns.size() +
+                               table.output_columns.size();
+        table.values.assign(columns * table.rows(), 0.0f);
+        table.input_sources.assign(table.input_columns.size() * table.rows(), nullptr);
+        table.parameter_pointers.resize(table.parameter_columns.size());
+        table.input_pointers.resize(table.input_columns.size());
+        table.output_pointers.resize(table.output_columns.size());
+        for (uint32_t row = 0; row < table.rows(); ++row) {
+            loadParameters(table, row);
+        }
+    }
+
+    // Resolve inputs once all tables have their final size. The first
+    // connection into a port wins.
+    for (Table& table : tables_) {
+        const size_t rows = table.rows();
+        for (uint32_t row = 0; row < rows; ++row) {
+            for (const Edge& edge : graph.getIncomingConnections(table.nodes[row]->getGraphHandle())) {
+                const RowRef& source = rows_[edge.peer.index];
+                if (source.table == INVALID) {
+                    continue;
+                }
+                const Connection* connection = graph.getConnection(edge.connection);
+                Atom input = AtomTable::find(connection->getTargetInput());
+                Atom output = AtomTable::find(connection->getSourceOutput());
+                const Table& source_table = tables_[source.table];
+                const size_t first_output = source_table.parameter_columns.size() +
+                                            source_table.input_columns.size();
+
+                for (size_t c = 0; c < table.input_columns.size(); ++c) {
+                    const Column& column = table.input_columns[c];
+                    const float*& slot = table.input_sources[c * rows + row];
+                    if (column.atom != input || slot) {
+                        continue;
+                    }
+                    for (size_t o = 0; o < source_table.output_columns.size(); ++o) {
+                        const Column& source_column = source_table.output_columns[o];
+                        if (source_column.atom == output && source_column.component == column.component) {
+                            slot = source_table.column(first_output + o) + source.row;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    resolveSinks(graph);
+}
+
+void NodeBatchProcessor::resolveSinks(const NodeGraph& graph) {
+    sinks_.clear();
+    for (const Table& table : tables_) {
+        const size_t first_output = table.parameter_columns.size() + table.input_columns.size();
+        for (uint32_t row = 0; row < table.rows(); ++row) {
+            NodeHandle handle = table.nodes[row]->getGraphHandle();
+            for (const Edge& edge : graph.getOutgoingConnections(handle)) {
+                Node* target = graph.getNode(edge.peer);
+                if (!target || (graph.getDeadNodePruning() && !target->isLive())) {
+                    continue;
+                }
+                const Connection* connection = graph.getConnection(edge.connection);
+                Atom parameter = AtomTable::find(connection->getTargetInput());
+                int field = target->getParameters().findField(parameter);
+                if (field < 0) {
+                    continue;
+                }
+                uint32_t components = parameterComponents(target->getParameters().getField(field).type);
+                Atom output = AtomTable::find(connection->getSourceOutput());
+                for (size_t o = 0; o < table.output_columns.size(); ++o) {
+                    const Column& column = table.output_columns[o];
+                    if (column.atom == output && column.component < components) {
+                        sinks_.push_back({target, parameter, column.component,
+                                          table.column(first_output + o) + row});
+                    }
+                }
+            }
+        }
+    }
+    std::stable_sort(sinks_.begin(), sinks_.end(), [](const Sink& a, const Sink& b) {
+        return std::less<Node*>()(a.node, b.node);
+    });
+}
+
+void NodeBatchProcessor::writeSinks(bool all) {
+    // Every sink is checked, not only those of slices that ran: the target's
+    // parameter may have been overwritten since (e.g. by applyVersion)
+    written_.clear();
+    for (const Sink& sink : sinks_) {
+        Parameter parameter = sink.node->getParameter(sink.parameter);
+        if (!parameter) {
+            continue;
+        }
+
+        // Compare as stored, so a settled output does not dirty its target
+        float value = *sink.source;
+        osc::ParameterType type = parameter.getType();
+        if (type == osc::ParameterType::INT) {
+            int32_t integer = 0;
+            parameterInt(value, integer);
+            value = static_cast<float>(integer);
+        } else if (type == osc::ParameterType::BOOL) {
+            value = (value != 0.0f) ? 1.0f : 0.0f;
+        }
+        bool changed = (parameter.getComponent(sink.component) != value);
+        if (changed && !parameter.assignComponent(sink.component, *sink.source)) {
+            continue;
+        }
+        if (!changed && !all) {
+            continue;
+        }
+        if (written_.empty() || written_.back() != sink.node) {
+            written_.push_back(sink.node);
+        }
+    }
+}
+
+void NodeBatchProcessor::loadParameters(Table& table, uint32_t row) {
+    const ParameterBlock& parameters = table.nodes[row]->getParameters();
+    for (size_t c = 0; c < table.parameter_columns.size(); ++c) {
+        const Column& column = table.parameter_columns[c];
+        float value = 0.0f;
+        int field = parameters.findField(column.atom);
+        if (field >= 0 && parameters.getField(field).type == column.type) {
+            const ParameterSlot& slot = parameters.getSlot(parameters.getField(field).slot);
+            bool integer = (column.type == osc::ParameterType::INT || column.type == osc::ParameterType::BOOL);
+            value = integer ? static_cast<float>(slot.i[column.component]) : slot.f[column.component];
+        }
+        table.column(c)[row] = value;
+    }
+}
+
+const NodeBatchProcessor::RowRef* NodeBatchProcessor::findRow(const Node& node) const {
+    uint32_t slot = node.getGraphHandle().index;
+    if (slot >= rows_.size()) {
+        return nullptr;
+    }
+    const RowRef& ref = rows_[slot];
+    if (ref.table == INVALID || tables_[ref.table].nodes[ref.row] != &node) {
+        return nullptr;
+    }
+    return &ref;
+}
+
+} // namespace gfx
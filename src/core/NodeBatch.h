@@ -0,0 +1,126 @@
+#pragma once
+
+#include "NodeRegistry.h"
+#include <cstdint>
+#include <vector>
+
+namespace gfx {
+
+// Evaluates nodes whose kind has a batch kernel (see NodeKind) from
+// columnar per-kind tables instead of one virtual process() call per node.
+//
+// Every batched node owns a row in its kind's table: one float column per
+// parameter component, input and output. Rows are sorted by level, where a
+// node's level is one more than that of the deepest batched node feeding
+// it, so the nodes of one kind and level are contiguous and run in a
+// single kernel call; levels run in order, which makes upstream outputs
+// ready before they are gathered into downstream inputs. Only outputs of
+// batched nodes flow into batched inputs.
+//
+// An output connected to an input named like a parameter of the target node
+// (e.g. lfo.value -> math.factor) is written into that parameter after the
+// kernels ran, so the value reaches uniforms and non-batched nodes. Only
+// changed values are written; the nodes written are reported by
+// getWrittenNodes() for upload.
+//
+// Tables are rebuilt when the graph's structure changes. Between rebuilds
+// only the parameters of changed nodes are copied into the columns. With
+// dead-node pruning enabled on the graph, nodes outside its live set get
+// no rows.
+class NodeBatchProcessor {
+public:
+    explicit NodeBatchProcessor(const NodeRegistry& registry);
+
+    // Evaluate the batched nodes among nodes (the graph's
+    // collectDirtyNodes() result) and append the others, still in
+    // topological order, to remaining for the per-node path. A kernel runs
+    // over the whole kind and level of any node that needs processing; after
+    // a rebuild every kernel runs once. With all set, every node with a
+    // connected parameter is reported as written, e.g. after the consumer of
+    // getWrittenNodes() lost the values written so far.
+    void run(const NodeGraph& graph, const std::vector<Node*>& nodes, float time,
+             std::vector<Node*>& remaining, bool all = false);
+
+    // Output value of a batched node after the last run; 0 if the node is
+    // not batched or has no such output
+    float getOutput(const Node& node, Atom port, uint32_t component = 0) const;
+
+    // Nodes whose parameters the last run wrote from batched outputs, each
+    // once, e.g. for Pipeline::uploadParameters()
+    const std::vector<Node*>& getWrittenNodes() const { return written_; }
+
+    size_t getBatchedNodeCount() const { return batched_count_; }
+    size_t getKernelCalls() const { return kernel_calls_; }   // In the last run
+
+private:
+    // Column fed from a parameter field component or from a port component
+    struct Column {
+        Atom atom;
+        osc::ParameterType type;
+        uint32_t component;
+    };
+
+    // Nodes of one kind and level: rows [begin, end) of a table
+    struct Slice {
+        uint32_t table;
+        uint32_t begin;
+        uint32_t end;
+        uint32_t level;
+    };
+
+    struct Table {
+        const NodeKind* kind;
+        std::vector<Column> parameter_columns;
+        std::vector<Column> input_columns;
+        std::vector<Column> output_columns;
+        std::vector<Node*> nodes;                   // Node of each row
+        std::vector<float> values;                  // Column-major: parameters, inputs, outputs
+        std::vector<const float*> input_sources;    // Per input column and row; null if unconnected
+
+        // Per-call column pointers, offset to the slice being run
+        std::vector<const float*> parameter_pointers;
+        std::vector<const float*> input_pointers;
+        std::vector<float*> output_pointers;
+
+        size_t rows() const { return nodes.size(); }
+        float* column(size_t index) { return values.data() + index * rows(); }
+        const float* column(size_t index) const { return values.data() + index * rows(); }
+    };
+
+    // Output component written into a parameter of a connected node
+    struct Sink {
+        Node* node;
+        Atom parameter;
+        uint32_t component;
+        const float* source;                        // Output column entry
+    };
+
+    // Row of a node, indexed by its graph handle's slot
+    struct RowRef {
+        uint32_t table = INVALID;
+        uint32_t row = 0;
+        uint32_t slice = 0;
+    };
+    static constexpr uint32_t INVALID = 0xFFFFFFFFu;
+
+    void rebuild(const NodeGraph& graph);
+    void resolveSinks(const NodeGraph& graph);
+    void writeSinks(bool all);
+    void loadParameters(Table& table, uint32_t row);
+    const RowRef* findRow(const Node& node) const;
+
+    const NodeRegistry& registry_;
+    const NodeGraph* graph_;
+    uint64_t structure_revision_;
+
+    std::vector<Table> tables_;
+    std::vector<Slice> slices_;              // In execution order: by level, then table
+    std::vector<RowRef> rows_;
+    std::vector<Sink> sinks_;                // Grouped by target node
+    std::vector<Node*> written_;
+    std::vector<uint8_t> slice_active_;      // Scratch, per run
+    size_t batched_count_;
+    size_t kernel_calls_;
+};
+
+} // namespace gfx
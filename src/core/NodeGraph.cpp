@@ -1,152 +1,284 @@
 #include "NodeGraph.h"
+#include "JsonStream.h"
+#include "GraphSnapshot.h"
+#include "GraphVersion.h"
+#include "GraphLog.h"
+#include "Hash.h"
+#include "NodeScheduler.h"
+#include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <cassert>
 #include <stdexcept>
+#include <functional>
 
 namespace gfx {
 
 // Parameter implementation
-Parameter::Parameter(const std::string& name, osc::ParameterType type) 
-    : name_(name), type_(type) {
-    // Initialize data to zero
-    data_.vec_values[0] = data_.vec_values[1] = data_.vec_values[2] = data_.vec_values[3] = 0.0f;
+const ParameterSchema::Field& Parameter::field() const {
+    return node_->parameters_.getField(field_);
+}
+
+ParameterSlot& Parameter::writeSlot() {
+    node_->markDirty();
+    return node_->parameters_.getSlot(field().slot);
+}
+
+const ParameterSlot& Parameter::slot() const {
+    return node_->parameters_.getSlot(field().slot);
 }
 
 void Parameter::setValue(int value) {
-    if (type_ != osc::ParameterType::INT) {
+    if (getType() != osc::ParameterType::INT) {
         throw std::runtime_error("Parameter type mismatch: expected int");
     }
-    data_.int_value = value;
+    writeSlot().i[0] = value;
+    node_->logParameter(field_);
 }
 
 void Parameter::setValue(float value) {
-    if (type_ != osc::ParameterType::FLOAT) {
+    if (getType() != osc::ParameterType::FLOAT) {
         throw std::runtime_error("Parameter type mismatch: expected float");
     }
-    data_.float_value = value;
+    writeSlot().f[0] = value;
+    node_->logParameter(field_);
 }
 
 void Parameter::setValue(const std::string& value) {
-    if (type_ != osc::ParameterType::STRING) {
+    if (getType() != osc::ParameterType::STRING) {
         throw std::runtime_error("Parameter type mismatch: expected string");
     }
-    string_value_ = value;
+    node_->markDirty();
+    node_->parameters_.getString(field().slot) = value;
+    node_->markStructureChanged();
+    node_->logParameter(field_);
 }
 
 void Parameter::setValue(bool value) {
-    if (type_ != osc::ParameterType::BOOL) {
+    if (getType() != osc::ParameterType::BOOL) {
         throw std::runtime_error("Parameter type mismatch: expected bool");
     }
-    data_.bool_value = value;
+    writeSlot().i[0] = value ? 1 : 0;
+    node_->logParameter(field_);
 }
 
 void Parameter::setValue(float x, float y) {
-    if (type_ != osc::ParameterType::VEC2) {
+    if (getType() != osc::ParameterType::VEC2) {
         throw std::runtime_error("Parameter type mismatch: expected vec2");
     }
-    data_.vec_values[0] = x;
-    data_.vec_values[1] = y;
+    ParameterSlot& values = writeSlot();
+    values.f[0] = x;
+    values.f[1] = y;
+    node_->logParameter(field_);
 }
 
 void Parameter::setValue(float x, float y, float z) {
-    if (type_ != osc::ParameterType::VEC3) {
+    if (getType() != osc::ParameterType::VEC3) {
         throw std::runtime_error("Parameter type mismatch: expected vec3");
     }
-    data_.vec_values[0] = x;
-    data_.vec_values[1] = y;
-    data_.vec_values[2] = z;
+    ParameterSlot& values = writeSlot();
+    values.f[0] = x;
+    values.f[1] = y;
+    values.f[2] = z;
+    node_->logParameter(field_);
 }
 
 void Parameter::setValue(float x, float y, float z, float w) {
-    if (type_ != osc::ParameterType::VEC4 && type_ != osc::ParameterType::COLOR) {
+    if (getType() != osc::ParameterType::VEC4 && getType() != osc::ParameterType::COLOR) {
         throw std::runtime_error("Parameter type mismatch: expected vec4 or color");
     }
-    data_.vec_values[0] = x;
-    data_.vec_values[1] = y;
-    data_.vec_values[2] = z;
-    data_.vec_values[3] = w;
+    ParameterSlot& values = writeSlot();
+    values.f[0] = x;
+    values.f[1] = y;
+    values.f[2] = z;
+    values.f[3] = w;
+    node_->logParameter(field_);
 }
 
 int Parameter::getIntValue() const {
-    if (type_ != osc::ParameterType::INT) {
+    if (getType() != osc::ParameterType::INT) {
         throw std::runtime_error("Parameter type mismatch: not an int");
     }
-    return data_.int_value;
+    return slot().i[0];
 }
 
 float Parameter::getFloatValue() const {
-    if (type_ != osc::ParameterType::FLOAT) {
+    if (getType() != osc::ParameterType::FLOAT) {
         throw std::runtime_error("Parameter type mismatch: not a float");
     }
-    return data_.float_value;
+    return slot().f[0];
 }
 
 const std::string& Parameter::getStringValue() const {
-    if (type_ != osc::ParameterType::STRING) {
+    if (getType() != osc::ParameterType::STRING) {
         throw std::runtime_error("Parameter type mismatch: not a string");
     }
-    return string_value_;
+    return node_->parameters_.getString(field().slot);
 }
 
 bool Parameter::getBoolValue() const {
-    if (type_ != osc::ParameterType::BOOL) {
+    if (getType() != osc::ParameterType::BOOL) {
         throw std::runtime_error("Parameter type mismatch: not a bool");
     }
-    return data_.bool_value;
+    return slot().i[0] != 0;
 }
 
 void Parameter::getVec2Value(float& x, float& y) const {
-    if (type_ != osc::ParameterType::VEC2) {
+    if (getType() != osc::ParameterType::VEC2) {
         throw std::runtime_error("Parameter type mismatch: not a vec2");
     }
-    x = data_.vec_values[0];
-    y = data_.vec_values[1];
+    const ParameterSlot& values = slot();
+    x = values.f[0];
+    y = values.f[1];
 }
 
 void Parameter::getVec3Value(float& x, float& y, float& z) const {
-    if (type_ != osc::ParameterType::VEC3) {
+    if (getType() != osc::ParameterType::VEC3) {
         throw std::runtime_error("Parameter type mismatch: not a vec3");
     }
-    x = data_.vec_values[0];
-    y = data_.vec_values[1];
-    z = data_.vec_values[2];
+    const ParameterSlot& values = slot();
+    x = values.f[0];
+    y = values.f[1];
+    z = values.f[2];
 }
 
 void Parameter::getVec4Value(float& x, float& y, float& z, float& w) const {
-    if (type_ != osc::ParameterType::VEC4 && type_ != osc::ParameterType::COLOR) {
+    if (getType() != osc::ParameterType::VEC4 && getType() != osc::ParameterType::COLOR) {
         throw std::runtime_error("Parameter type mismatch: not a vec4 or color");
     }
-    x = data_.vec_values[0];
-    y = data_.vec_values[1];
-    z = data_.vec_values[2];
-    w = data_.vec_values[3];
+    const ParameterSlot& values = slot();
+    x = values.f[0];
+    y = values.f[1];
+    z = values.f[2];
+    w = values.f[3];
+}
+
+bool Parameter::assign(const float* values, int count) {
+    osc::ParameterType type = getType();
+    switch (type) {
+        case osc::ParameterType::INT:
+        case osc::ParameterType::BOOL:
+        case osc::ParameterType::FLOAT:
+            if (count != 1) {
+                return false;
+            }
+            break;
+        case osc::ParameterType::VEC2:
+            if (count != 2) {
+                return false;
+            }
+            break;
+        case osc::ParameterType::VEC3:
+            if (count != 3) {
+                return false;
+            }
+            break;
+        case osc::ParameterType::VEC4:
+        case osc::ParameterType::COLOR:
+            if (count != 4) {
+                return false;
+            }
+            break;
+        case osc::ParameterType::STRING:
+            return false;
+    }
+    
+    int32_t integer = 0;
+    if (type == osc::ParameterType::INT && !parameterInt(values[0], integer)) {
+        return false;
+    }
+    
+    ParameterSlot& slot = writeSlot();
+    if (type == osc::ParameterType::INT) {
+        slot.i[0] = integer;
+    } else if (type == osc::ParameterType::BOOL) {
+        slot.i[0] = (values[0] != 0.0f) ? 1 : 0;
+    } else {
+        for (int i = 0; i < count; ++i) {
+            slot.f[i] = values[i];
+        }
+    }
+    node_->logParameter(field_);
+    return true;
+}
+
+bool Parameter::assign(int value) {
+    switch (getType()) {
+        case osc::ParameterType::INT:
+            writeSlot().i[0] = value;
+            break;
+        case osc::ParameterType::BOOL:
+            writeSlot().i[0] = (value != 0) ? 1 : 0;
+            break;
+        case osc::ParameterType::FLOAT:
+            writeSlot().f[0] = static_cast<float>(value);
+            break;
+        default:
+            return false;
+    }
+    node_->logParameter(field_);
+    return true;
+}
+
+float Parameter::getComponent(uint32_t component) const {
+    osc::ParameterType type = getType();
+    if (component >= parameterComponents(type)) {
+        return 0.0f;
+    }
+    if (type == osc::ParameterType::INT || type == osc::ParameterType::BOOL) {
+        return static_cast<float>(slot().i[component]);
+    }
+    return slot().f[component];
+}
+
+bool Parameter::assignComponent(uint32_t component, float value) {
+    osc::ParameterType type = getType();
+    if (component >= parameterComponents(type)) {
+        return false;
+    }
+    
+    int32_t integer = 0;
+    if (type == osc::ParameterType::INT && !parameterInt(value, integer)) {
+        return false;
+    }
+    
+    ParameterSlot& slot = writeSlot();
+    if (type == osc::ParameterType::INT) {
+        slot.i[0] = integer;
+    } else if (type == osc::ParameterType::BOOL) {
+        slot.i[0] = (value != 0.0f) ? 1 : 0;
+    } else {
+        slot.f[component] = value;
+    }
+    node_->logParameter(field_);
+    return true;
 }
 
 std::string Parameter::toString() const {
     std::stringstream ss;
-    switch (type_) {
+    switch (getType()) {
         case osc::ParameterType::INT:
-            ss << data_.int_value;
+            ss << slot().i[0];
             break;
         case osc::ParameterType::FLOAT:
-            ss << data_.float_value;
+            ss << slot().f[0];
             break;
         case osc::ParameterType::STRING:
-            ss << string_value_;
+            ss << node_->parameters_.getString(field().slot);
             break;
         case osc::ParameterType::BOOL:
-            ss << (data_.bool_value ? "true" : "false");
+            ss << (slot().i[0] ? "true" : "false");
             break;
         case osc::ParameterType::VEC2:
-            ss << data_.vec_values[0] << "," << data_.vec_values[1];
+            ss << slot().f[0] << "," << slot().f[1];
             break;
         case osc::ParameterType::VEC3:
-            ss << data_.vec_values[0] << "," << data_.vec_values[1] << "," << data_.vec_values[2];
+            ss << slot().f[0] << "," << slot().f[1] << "," << slot().f[2];
             break;
         case osc::ParameterType::VEC4:
         case osc::ParameterType::COLOR:
-            ss << data_.vec_values[0] << "," << data_.vec_values[1] << "," 
-               << data_.vec_values[2] << "," << data_.vec_values[3];
+            ss << slot().f[0] << "," << slot().f[1] << "," 
+               << slot().f[2] << "," << slot().f[3];
             break;
     }
     return ss.str();
@@ -155,60 +287,145 @@ std::string Parameter::toString() const {
 void Parameter::fromString(const std::string& str) {
     std::stringstream ss(str);
     std::string token;
+    node_->markDirty();
     
-    switch (type_) {
+    switch (getType()) {
         case osc::ParameterType::INT:
-            data_.int_value = std::stoi(str);
+            node_->parameters_.getSlot(field().slot).i[0] = std::stoi(str);
             break;
         case osc::ParameterType::FLOAT:
-            data_.float_value = std::stof(str);
+            node_->parameters_.getSlot(field().slot).f[0] = std::stof(str);
             break;
         case osc::ParameterType::STRING:
-            string_value_ = str;
+            node_->parameters_.getString(field().slot) = str;
+            node_->markStructureChanged();
             break;
         case osc::ParameterType::BOOL:
-            data_.bool_value = (str == "true" || str == "1");
+            node_->parameters_.getSlot(field().slot).i[0] = (str == "true" || str == "1") ? 1 : 0;
             break;
         case osc::ParameterType::VEC2:
-            std::getline(ss, token, ',');
-            data_.vec_values[0] = std::stof(token);
-            std::getline(ss, token, ',');
-            data_.vec_values[1] = std::stof(token);
-            break;
         case osc::ParameterType::VEC3:
-            std::getline(ss, token, ',');
-            data_.vec_values[0] = std::stof(token);
-            std::getline(ss, token, ',');
-            data_.vec_values[1] = std::stof(token);
-            std::getline(ss, token, ',');
-            data_.vec_values[2] = std::stof(token);
-            break;
         case osc::ParameterType::VEC4:
-        case osc::ParameterType::COLOR:
-            std::getline(ss, token, ',');
-            data_.vec_values[0] = std::stof(token);
-            std::getline(ss, token, ',');
-            data_.vec_values[1] = std::stof(token);
-            std::getline(ss, token, ',');
-            data_.vec_values[2] = std::stof(token);
-            std::getline(ss, token, ',');
-            data_.vec_values[3] = std::stof(token);
+        case osc::ParameterType::COLOR: {
+            int components = (getType() == osc::ParameterType::VEC2) ? 2 :
+                             (getType() == osc::ParameterType::VEC3) ? 3 : 4;
+            ParameterSlot& values = node_->parameters_.getSlot(field().slot);
+            for (int i = 0; i < components; ++i) {
+                std::getline(ss, token, ',');
+                values.f[i] = std::stof(token);
+            }
             break;
+        }
     }
+    node_->logParameter(field_);
 }
 
+namespace {
+
+// Type IDs of the category names, interned once
+Atom categoryTypeId(osc::NodeType type) {
+    static const std::vector<Atom> ids = [] {
+        std::vector<Atom> atoms;
+        for (int i = 0; i <= static_cast<int>(osc::NodeType::CUSTOM); ++i) {
+            atoms.push_back(AtomTable::intern(osc::nodeTypeToString(static_cast<osc::NodeType>(i))));
+        }
+        return atoms;
+    }();
+    return ids[static_cast<size_t>(type)];
+}
+
+} // namespace
+
 // Node implementation
 Node::Node(int id, const std::string& name, osc::NodeType type)
-    : id_(id), name_(name), type_(type), pos_x_(0.0f), pos_y_(0.0f) {
+    : Node(id, name, type, categoryTypeId(type)) {
+}
+
+Node::Node(int id, const std::string& name, osc::NodeType type, Atom type_id)
+    : id_(id), name_(name), type_(type), type_id_(type_id), pos_x_(0.0f), pos_y_(0.0f),
+      dirty_(true), time_dependent_(false), schedule_changed_(false), live_(false), dirty_queue_(nullptr),
+      log_(nullptr), hash_queued_(false), hash_queue_(nullptr) {
+}
+
+void Node::setPosition(float x, float y) {
+    pos_x_ = x;
+    pos_y_ = y;
+    if (log_) {
+        log_->recordSetPosition(*this);
+    }
+}
+
+void Node::logParameter(uint32_t field) {
+    assert(!NodeScheduler::isProcessing() && "process() must not write parameters");
+    if (log_) {
+        log_->recordSetParameter(*this, field);
+    }
+}
+
+void Node::markStructureChanged() {
+    assert(!NodeScheduler::isProcessing() && "process() must not edit the graph");
+    if (hash_queue_ && !hash_queued_) {
+        hash_queued_ = true;
+        hash_queue_->push_back(graph_handle_);
+    }
+}
+
+void Node::markDirty() {
+    assert(!NodeScheduler::isProcessing() && "process() must not write parameters");
+    if (dirty_) {
+        return;
+    }
+    dirty_ = true;
+    if (dirty_queue_) {
+        dirty_queue_->push_back(graph_handle_);
+    }
+}
+
+void Node::setTimeDependent(bool time_dependent) {
+    if (time_dependent_ == time_dependent) {
+        return;
+    }
+    time_dependent_ = time_dependent;
+    schedule_changed_ = true;
+    
+    // Queue unconditionally: the graph must see the trait change even if the
+    // node was already dirty
+    dirty_ = true;
+    if (dirty_queue_) {
+        dirty_queue_->push_back(graph_handle_);
+    }
+    if (log_) {
+        log_->recordSetTimeDependent(*this);
+    }
+}
+
+Parameter Node::addParameter(const std::string& name, osc::ParameterType type) {
+    return addParameter(AtomTable::intern(name), type);
+}
+
+Parameter Node::addParameter(Atom atom, osc::ParameterType type) {
+    size_t field_count = parameters_.getFieldCount();
+    uint32_t field = parameters_.addField(atom, type);
+    if (parameters_.getFieldCount() != field_count) {
+        markStructureChanged();
+        if (log_) {
+            log_->recordAddParameter(*this, field);
+        }
+    }
+    return Parameter(this, field);
+}
+
+Parameter Node::getParameter(const std::string& name) {
+    return getParameter(AtomTable::find(name));
 }
 
-void Node::addParameter(std::shared_ptr<Parameter> param) {
-    parameters_[param->getName()] = param;
+Parameter Node::getParameter(Atom atom) {
+    int field = parameters_.findField(atom);
+    return (field >= 0) ? Parameter(this, static_cast<uint32_t>(field)) : Parameter();
 }
 
-std::shared_ptr<Parameter> Node::getParameter(const std::string& name) {
-    auto it = parameters_.find(name);
-    return (it != parameters_.end()) ? it->second : nullptr;
+GenericNode::GenericNode(int id, const std::string& name, const std::string& type)
+    : Node(id, name, osc::stringToNodeType(type), AtomTable::intern(type)) {
 }
 
 // Connection implementation
@@ -218,76 +435,1383 @@ Connection::Connection(int id, int source_node_id, const std::string& source_out
       target_node_id_(target_node_id), target_input_(target_input) {
 }
 
+const char* connectionErrorToString(ConnectionError error) {
+    switch (error) {
+        case ConnectionError::NONE: return "none";
+        case ConnectionError::MISSING_NODE: return "node not found";
+        case ConnectionError::CYCLE: return "connection would create a cycle";
+    }
+    return "unknown";
+}
+
+namespace {
+
+// Hash value of a node whose hash is being computed; inputs that read it
+// are on a cycle
+constexpr uint64_t HASH_IN_PROGRESS = 1;
+
+// Same parameter layout and string values, i.e. the same structural hash
+bool sameStructure(const ParameterBlock& a, const ParameterBlock& b) {
+    if (a.getSchema() != b.getSchema()) {
+        return false;
+    }
+    for (uint32_t i = 0; i < a.getSchema()->getStringCount(); ++i) {
+        if (a.getString(i) != b.getString(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
 // NodeGraph implementation
-NodeGraph::NodeGraph() : next_node_id_(1), next_connection_id_(1) {
+NodeGraph::NodeGraph()
+    : next_node_id_(1), next_connection_id_(1), topology_dirty_(true), frame_stamp_(0),
+      track_changes_(false), structure_revision_(0), log_(nullptr),
+      scratch_resource_(std::pmr::get_default_resource()), next_order_(0), order_stamp_(0),
+      prune_dead_nodes_(false), live_count_(0), structure_hash_(0), live_structure_hash_(0) {
 }
 
-void NodeGraph::addNode(std::shared_ptr<Node> node) {
-    nodes_[node->getId()] = node;
-    next_node_id_ = std::max(next_node_id_, node->getId() + 1);
+NodeGraph::~NodeGraph() {
+    for (NodeEntry& entry : nodes_) {
+        detachNode(entry.node.get());
+    }
+}
+
+NodeHandle NodeGraph::addNode(std::shared_ptr<Node> node) {
+    int node_id = node->getId();
+    next_node_id_ = std::max(next_node_id_, node_id + 1);
+    topology_dirty_ = true;
+    structure_revision_++;
+    
+    auto it = node_ids_.find(node_id);
+    if (it != node_ids_.end()) {
+        NodeEntry* entry = nodes_.get(it->second);
+        bool live = entry->node->live_;
+        detachNode(entry->node.get());
+        entry->node = std::move(node);
+        entry->node->live_ = live;
+        attachNode(entry->node.get(), it->second);
+        invalidateHash(it->second);
+        updateLiveness(it->second);     // The new node may (not) be an output
+        if (log_) {
+            log_->recordAddNode(*entry->node);
+        }
+        return it->second;
+    }
+    
+    Node* raw = node.get();
+    NodeHandle handle = nodes_.insert({std::move(node), {}, {}});
+    node_ids_[node_id] = handle;
+    nodes_.get(handle)->order = next_order_++;
+    raw->live_ = false;
+    attachNode(raw, handle);
+    stale_hashes_.push_back(handle);
+    updateLiveness(handle);
+    if (log_) {
+        log_->recordAddNode(*raw);
+    }
+    return handle;
+}
+
+void NodeGraph::attachNode(Node* node, NodeHandle handle) {
+    // A node reports changes to the last graph it was added to
+    node->graph_handle_ = handle;
+    node->dirty_queue_ = &dirty_queue_;
+    node->log_ = log_;
+    node->hash_queue_ = &hash_queue_;
+    node->hash_queued_ = false;
+    node->dirty_ = true;
+    dirty_queue_.push_back(handle);
+}
+
+void NodeGraph::detachNode(Node* node) {
+    if (node && node->dirty_queue_ == &dirty_queue_) {
+        node->dirty_queue_ = nullptr;
+        node->graph_handle_ = {};
+        node->log_ = nullptr;
+        node->hash_queue_ = nullptr;
+    }
+}
+
+void NodeGraph::markNodeDirty(NodeHandle handle) {
+    if (NodeEntry* entry = nodes_.get(handle)) {
+        entry->node->markDirty();
+    }
 }
 
 void NodeGraph::removeNode(int node_id) {
-    // Remove all connections involving this node
-    auto conn_it = connections_.begin();
-    while (conn_it != connections_.end()) {
-        if (conn_it->second->getSourceNodeId() == node_id || 
-            conn_it->second->getTargetNodeId() == node_id) {
-            conn_it = connections_.erase(conn_it);
-        } else {
-            ++conn_it;
+    removeNode(findNode(node_id));
+}
+
+void NodeGraph::removeNode(NodeHandle handle) {
+    NodeEntry* entry = nodes_.get(handle);
+    if (!entry) {
+        return;
+    }
+    
+    // Remove all connections involving this node using its edge lists.
+    // eraseConnection edits the lists, so always take the last edge.
+    while (!entry->incoming.empty()) {
+        eraseConnection(entry->incoming.back().connection);
+    }
+    while (!entry->outgoing.empty()) {
+        eraseConnection(entry->outgoing.back().connection);
+    }
+    
+    int node_id = entry->node->getId();
+    if (track_changes_) {
+        removed_nodes_.emplace_back(handle, node_id);
+    }
+    node_ids_.erase(node_id);
+    structure_hash_ -= entry->hash_term;
+    if (entry->node->live_) {
+        entry->node->live_ = false;
+        live_count_--;
+        live_structure_hash_ -= entry->hash_term;
+    }
+    detachNode(entry->node.get());
+    nodes_.erase(handle);
+    topology_dirty_ = true;
+    structure_revision_++;
+    if (log_) {
+        log_->recordRemoveNode(node_id);
+    }
+}
+
+Node* NodeGraph::getNode(int node_id) const {
+    return getNode(findNode(node_id));
+}
+
+Node* NodeGraph::getNode(NodeHandle handle) const {
+    const NodeEntry* entry = nodes_.get(handle);
+    return entry ? entry->node.get() : nullptr;
+}
+
+NodeHandle NodeGraph::findNode(int node_id) const {
+    auto it = node_ids_.find(node_id);
+    return (it != node_ids_.end()) ? it->second : NodeHandle{};
+}
+
+ConnectionHandle NodeGraph::addConnection(const Connection& connection, ConnectionError* error) {
+    NodeHandle source = findNode(connection.getSourceNodeId());
+    NodeHandle target = findNode(connection.getTargetNodeId());
+    if (!source.isValid() || !target.isValid()) {
+        if (error) {
+            *error = ConnectionError::MISSING_NODE;
+        }
+        return {};
+    }
+    
+    // Re-using an ID replaces the old edge. It must not count towards a
+    // cycle, and stays in place if the new edge is rejected.
+    ConnectionHandle replaced = findConnection(connection.getId());
+    if (!reorderForConnection(source, target, replaced)) {
+        if (error) {
+            *error = ConnectionError::CYCLE;
         }
+        return {};
     }
+    eraseConnection(replaced);
     
-    // Remove the node
-    nodes_.erase(node_id);
+    ConnectionHandle handle = connections_.insert(connection);
+    connection_ids_[connection.getId()] = handle;
+    if (track_changes_) {
+        added_connections_.push_back(handle);
+    }
+    nodes_.get(source)->outgoing.push_back({handle, target});
+    nodes_.get(target)->incoming.push_back({handle, source});
+    next_connection_id_ = std::max(next_connection_id_, connection.getId() + 1);
+    structure_revision_++;
+    invalidateHash(target);
+    markNodeDirty(target);
+    if (nodes_.get(target)->node->live_) {
+        nodes_.get(source)->live_successors++;
+        updateLiveness(source);
+    }
+    if (log_) {
+        log_->recordAddConnection(connection);
+    }
+    if (error) {
+        *error = ConnectionError::NONE;
+    }
+    return handle;
 }
 
-std::shared_ptr<Node> NodeGraph::getNode(int node_id) {
-    auto it = nodes_.find(node_id);
-    return (it != nodes_.end()) ? it->second : nullptr;
+bool NodeGraph::reorderForConnection(NodeHandle source, NodeHandle target, ConnectionHandle replaced) {
+    if (source == target) {
+        return false;
+    }
+    NodeEntry* source_entry = nodes_.get(source);
+    NodeEntry* target_entry = nodes_.get(target);
+    if (source_entry->order < target_entry->order) {
+        return true;
+    }
+    
+    // The new edge points backwards in the order. Only nodes ranked between
+    // target and source can be affected: search forward from the target
+    // through them (reaching the source means a cycle), and backward from
+    // the source.
+    const uint64_t lower = target_entry->order;
+    const uint64_t upper = source_entry->order;
+    if (++order_stamp_ == 0) {
+        for (NodeEntry& entry : nodes_) {
+            entry.order_stamp = 0;
+        }
+        order_stamp_ = 1;
+    }
+    
+    order_forward_.clear();
+    order_stack_.assign(1, target);
+    target_entry->order_stamp = order_stamp_;
+    while (!order_stack_.empty()) {
+        NodeHandle handle = order_stack_.back();
+        order_stack_.pop_back();
+        order_forward_.push_back(handle);
+        for (const Edge& edge : nodes_.get(handle)->outgoing) {
+            if (edge.connection == replaced) {
+                continue;
+            }
+            if (edge.peer == source) {
+                return false;
+            }
+            NodeEntry* peer = nodes_.get(edge.peer);
+            if (peer->order_stamp != order_stamp_ && peer->order < upper) {
+                peer->order_stamp = order_stamp_;
+                order_stack_.push_back(edge.peer);
+            }
+        }
+    }
+    
+    order_backward_.clear();
+    order_stack_.assign(1, source);
+    source_entry->order_stamp = order_stamp_;
+    while (!order_stack_.empty()) {
+        NodeHandle handle = order_stack_.back();
+        order_stack_.pop_back();
+        order_backward_.push_back(handle);
+        for (const Edge& edge : nodes_.get(handle)->incoming) {
+            if (edge.connection == replaced) {
+                continue;
+            }
+            NodeEntry* peer = nodes_.get(edge.peer);
+            if (peer->order_stamp != order_stamp_ && peer->order > lower) {
+                peer->order_stamp = order_stamp_;
+                order_stack_.push_back(edge.peer);
+            }
+        }
+    }
+    
+    // Hand the ranks of both sets back out, the source's ancestors first,
+    // keeping the relative order within each set
+    auto by_order = [this](NodeHandle a, NodeHandle b) {
+        return nodes_.get(a)->order < nodes_.get(b)->order;
+    };
+    std::sort(order_forward_.begin(), order_forward_.end(), by_order);
+    std::sort(order_backward_.begin(), order_backward_.end(), by_order);
+    order_pool_.clear();
+    for (NodeHandle handle : order_backward_) {
+        order_pool_.push_back(nodes_.get(handle)->order);
+    }
+    for (NodeHandle handle : order_forward_) {
+        order_pool_.push_back(nodes_.get(handle)->order);
+    }
+    std::sort(order_pool_.begin(), order_pool_.end());
+    size_t next = 0;
+    for (NodeHandle handle : order_backward_) {
+        nodes_.get(handle)->order = order_pool_[next++];
+    }
+    for (NodeHandle handle : order_forward_) {
+        nodes_.get(handle)->order = order_pool_[next++];
+    }
+    if (!topology_dirty_) {
+        patchTopologicalOrder();
+    }
+    return true;
 }
 
-void NodeGraph::addConnection(std::shared_ptr<Connection> connection) {
-    connections_[connection->getId()] = connection;
-    next_connection_id_ = std::max(next_connection_id_, connection->getId() + 1);
+void NodeGraph::patchTopologicalOrder() {
+    // The re-ranked nodes took over each other's ranks, so together they
+    // still hold the same positions in the order. Only those positions are
+    // rewritten, in the new rank order: the source's ancestors, then the
+    // target's descendants.
+    order_positions_.clear();
+    for (NodeHandle handle : order_backward_) {
+        order_positions_.push_back(position_of_dense_[nodes_.denseIndex(handle)]);
+    }
+    for (NodeHandle handle : order_forward_) {
+        order_positions_.push_back(position_of_dense_[nodes_.denseIndex(handle)]);
+    }
+    std::sort(order_positions_.begin(), order_positions_.end());
+    
+    size_t next = 0;
+    auto place = [this, &next](NodeHandle handle) {
+        uint32_t position = order_positions_[next++];
+        uint32_t dense = static_cast<uint32_t>(nodes_.denseIndex(handle));
+        order_dense_[position] = dense;
+        position_of_dense_[dense] = position;
+        topological_order_[position] = nodes_[dense].node.get();
+    };
+    for (NodeHandle handle : order_backward_) {
+        place(handle);
+    }
+    for (NodeHandle handle : order_forward_) {
+        place(handle);
+    }
+    
+    // Time-dependent nodes among them may have moved too
+    auto moved = [this](uint32_t position) {
+        return std::binary_search(order_positions_.begin(), order_positions_.end(), position);
+    };
+    time_dependent_positions_.erase(std::remove_if(time_dependent_positions_.begin(),
+                                                   time_dependent_positions_.end(), moved),
+                                    time_dependent_positions_.end());
+    for (uint32_t position : order_positions_) {
+        if (topological_order_[position]->isTimeDependent()) {
+            time_dependent_positions_.push_back(position);
+        }
+    }
 }
 
 void NodeGraph::removeConnection(int connection_id) {
-    connections_.erase(connection_id);
+    removeConnection(findConnection(connection_id));
+}
+
+void NodeGraph::removeConnection(ConnectionHandle handle) {
+    const Connection* connection = connections_.get(handle);
+    if (!connection) {
+        return;
+    }
+    
+    int connection_id = connection->getId();
+    eraseConnection(handle);
+    if (log_) {
+        log_->recordRemoveConnection(connection_id);
+    }
+}
+
+void NodeGraph::eraseConnection(ConnectionHandle handle) {
+    const Connection* connection = connections_.get(handle);
+    if (!connection) {
+        return;
+    }
+    
+    NodeHandle source_handle = findNode(connection->getSourceNodeId());
+    NodeEntry* source = nodes_.get(source_handle);
+    if (source) {
+        unlinkEdge(source->outgoing, handle);
+    }
+    NodeHandle target_handle = findNode(connection->getTargetNodeId());
+    bool target_live = false;
+    if (NodeEntry* target = nodes_.get(target_handle)) {
+        unlinkEdge(target->incoming, handle);
+        target->node->markDirty();
+        invalidateHash(target_handle);
+        target_live = target->node->live_;
+    }
+    if (track_changes_) {
+        removed_connections_.emplace_back(handle, connection->getId());
+    }
+    
+    // Dropping an edge keeps the topological order valid
+    connection_ids_.erase(connection->getId());
+    connections_.erase(handle);
+    structure_revision_++;
+    
+    if (target_live) {
+        if (source) {
+            source->live_successors--;
+            updateLiveness(source_handle);
+        }
+    }
+}
+
+bool NodeGraph::isLive(NodeHandle handle) const {
+    const NodeEntry* entry = nodes_.get(handle);
+    return entry && entry->node->live_;
+}
+
+void NodeGraph::updateLiveness(NodeHandle handle) {
+    // A node is live if it is an output or feeds a live node. Graphs are
+    // acyclic, so a node never keeps itself live, and only the nodes whose
+    // live target count crossed zero are visited.
+    live_stack_.push_back(handle);
+    while (!live_stack_.empty()) {
+        NodeHandle current = live_stack_.back();
+        live_stack_.pop_back();
+        NodeEntry* entry = nodes_.get(current);
+        if (!entry) {
+            continue;
+        }
+        Node* node = entry->node.get();
+        bool live = node->getType() == osc::NodeType::OUTPUT || entry->live_successors > 0;
+        if (live == node->live_) {
+            continue;
+        }
+        
+        node->live_ = live;
+        if (live) {
+            live_count_++;
+            live_structure_hash_ += entry->hash_term;
+        } else {
+            live_count_--;
+            live_structure_hash_ -= entry->hash_term;
+        }
+        for (const Edge& edge : entry->incoming) {
+            NodeEntry* source = nodes_.get(edge.peer);
+            if (live) {
+                if (source->live_successors++ == 0) {
+                    live_stack_.push_back(edge.peer);
+                }
+            } else {
+                if (--source->live_successors == 0) {
+                    live_stack_.push_back(edge.peer);
+                }
+            }
+        }
+        node->markDirty();
+    }
+}
+
+void NodeGraph::unlinkEdge(std::vector<Edge>& edges, ConnectionHandle connection) {
+    auto pos = std::find_if(edges.begin(), edges.end(),
+                            [&](const Edge& edge) { return edge.connection == connection; });
+    if (pos != edges.end()) {
+        // Edge order carries no meaning, so swap-and-pop
+        *pos = edges.back();
+        edges.pop_back();
+    }
+}
+
+const Connection* NodeGraph::getConnection(int connection_id) const {
+    return getConnection(findConnection(connection_id));
+}
+
+const Connection* NodeGraph::getConnection(ConnectionHandle handle) const {
+    return connections_.get(handle);
 }
 
-std::shared_ptr<Connection> NodeGraph::getConnection(int connection_id) {
-    auto it = connections_.find(connection_id);
-    return (it != connections_.end()) ? it->second : nullptr;
+ConnectionHandle NodeGraph::findConnection(int connection_id) const {
+    auto it = connection_ids_.find(connection_id);
+    return (it != connection_ids_.end()) ? it->second : ConnectionHandle{};
+}
+
+ConnectionHandle NodeGraph::findConnection(int source_node_id, const std::string& source_output,
+                                           int target_node_id, const std::string& target_input) const {
+    for (const Edge& edge : getOutgoingConnections(source_node_id)) {
+        const Connection* connection = getConnection(edge.connection);
+        if (connection->getTargetNodeId() == target_node_id &&
+            connection->getSourceOutput() == source_output &&
+            connection->getTargetInput() == target_input) {
+            return edge.connection;
+        }
+    }
+    return ConnectionHandle{};
+}
+
+const std::vector<Edge>& NodeGraph::getIncomingConnections(int node_id) const {
+    return getIncomingConnections(findNode(node_id));
+}
+
+const std::vector<Edge>& NodeGraph::getOutgoingConnections(int node_id) const {
+    return getOutgoingConnections(findNode(node_id));
+}
+
+const std::vector<Edge>& NodeGraph::getIncomingConnections(NodeHandle handle) const {
+    static const std::vector<Edge> empty;
+    const NodeEntry* entry = nodes_.get(handle);
+    return entry ? entry->incoming : empty;
+}
+
+const std::vector<Edge>& NodeGraph::getOutgoingConnections(NodeHandle handle) const {
+    static const std::vector<Edge> empty;
+    const NodeEntry* entry = nodes_.get(handle);
+    return entry ? entry->outgoing : empty;
 }
 
 void NodeGraph::clear() {
+    if (track_changes_) {
+        for (size_t i = 0; i < connections_.size(); ++i) {
+            removed_connections_.emplace_back(connections_.handleAt(i), connections_[i].getId());
+        }
+    }
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (track_changes_) {
+            removed_nodes_.emplace_back(nodes_.handleAt(i), nodes_[i].node->getId());
+        }
+        detachNode(nodes_[i].node.get());
+    }
+    dirty_queue_.clear();
+    hash_queue_.clear();
+    stale_hashes_.clear();
+    structure_hash_ = 0;
+    live_structure_hash_ = 0;
+    live_count_ = 0;
     nodes_.clear();
     connections_.clear();
+    node_ids_.clear();
+    connection_ids_.clear();
     next_node_id_ = 1;
     next_connection_id_ = 1;
+    next_order_ = 0;
+    topology_dirty_ = true;
+    structure_revision_++;
+    if (log_) {
+        log_->recordClear();
+    }
+}
+
+void NodeGraph::setLog(GraphLog* log) {
+    log_ = log;
+    for (NodeEntry& entry : nodes_) {
+        entry.node->log_ = log;
+    }
+    if (log_) {
+        log_->attach(this);
+    }
+}
+
+uint64_t NodeGraph::getNodeHash(int node_id) const {
+    return getNodeHash(findNode(node_id));
+}
+
+uint64_t NodeGraph::getNodeHash(NodeHandle handle) const {
+    drainHashQueue();
+    updateHash(handle);
+    const NodeEntry* entry = nodes_.get(handle);
+    return entry ? entry->hash : 0;
+}
+
+uint64_t NodeGraph::getStructureHash() const {
+    drainHashQueue();
+    for (NodeHandle handle : stale_hashes_) {
+        updateHash(handle);
+    }
+    stale_hashes_.clear();
+    return structure_hash_;
+}
+
+uint64_t NodeGraph::getLiveStructureHash() const {
+    getStructureHash();
+    return live_structure_hash_;
+}
+
+void NodeGraph::getCanonicalOrder(std::vector<NodeHandle>& out) const {
+    out.clear();
+    if (live_count_ == 0) {
+        return;
+    }
+    getStructureHash();     // Every hash up to date
+    
+    // Nodes of equal hash and role are interchangeable; IDs only make the
+    // order repeatable
+    auto before = [this](NodeHandle a, NodeHandle b) {
+        const NodeEntry* x = nodes_.get(a);
+        const NodeEntry* y = nodes_.get(b);
+        return x->hash != y->hash ? x->hash < y->hash : x->node->getId() < y->node->getId();
+    };
+    
+    std::vector<NodeHandle> stack;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        if (nodes_[i].node->getType() == osc::NodeType::OUTPUT) {
+            stack.push_back(nodes_.handleAt(i));
+        }
+    }
+    // Popped from the back, so sorted in reverse
+    std::sort(stack.begin(), stack.end(), [&](NodeHandle a, NodeHandle b) { return before(b, a); });
+    
+    std::vector<uint8_t> visited(nodes_.size(), 0);
+    std::vector<const Edge*> inputs;
+    while (!stack.empty()) {
+        NodeHandle handle = stack.back();
+        stack.pop_back();
+        size_t dense = nodes_.denseIndex(handle);
+        if (visited[dense]) {
+            continue;
+        }
+        visited[dense] = 1;
+        out.push_back(handle);
+        
+        inputs.clear();
+        for (const Edge& edge : nodes_[dense].incoming) {
+            inputs.push_back(&edge);
+        }
+        std::sort(inputs.begin(), inputs.end(), [&](const Edge* a, const Edge* b) {
+            const Connection& x = *connections_.get(a->connection);
+            const Connection& y = *connections_.get(b->connection);
+            if (int order = x.getTargetInput().compare(y.getTargetInput())) {
+                return order > 0;
+            }
+            if (int order = x.getSourceOutput().compare(y.getSourceOutput())) {
+                return order > 0;
+            }
+            return before(b->peer, a->peer);
+        });
+        for (const Edge* edge : inputs) {
+            stack.push_back(edge->peer);
+        }
+    }
+}
+
+void NodeGraph::drainHashQueue() const {
+    for (NodeHandle handle : hash_queue_) {
+        if (const NodeEntry* entry = nodes_.get(handle)) {
+            entry->node->hash_queued_ = false;
+            invalidateHash(handle);
+        }
+    }
+    hash_queue_.clear();
+}
+
+void NodeGraph::invalidateHash(NodeHandle handle) const {
+    // Everything downstream of a stale hash is stale too, so the walk stops
+    // at nodes that already are
+    hash_stack_.push_back(handle);
+    while (!hash_stack_.empty()) {
+        const NodeEntry* entry = nodes_.get(hash_stack_.back());
+        NodeHandle current = hash_stack_.back();
+        hash_stack_.pop_back();
+        if (!entry || entry->hash == 0) {
+            continue;
+        }
+        entry->hash = 0;
+        stale_hashes_.push_back(current);
+        for (const Edge& edge : entry->outgoing) {
+            hash_stack_.push_back(edge.peer);
+        }
+    }
+    
+    // Nodes recomputed by getNodeHash() stay listed until the next
+    // getStructureHash(); keep the list bounded if that never comes
+    if (stale_hashes_.size() > 2 * nodes_.size() + 64) {
+        auto fresh = [this](NodeHandle stale) {
+            const NodeEntry* entry = nodes_.get(stale);
+            return !entry || entry->hash != 0;
+        };
+        stale_hashes_.erase(std::remove_if(stale_hashes_.begin(), stale_hashes_.end(), fresh),
+                            stale_hashes_.end());
+        std::sort(stale_hashes_.begin(), stale_hashes_.end(),
+                  [](NodeHandle a, NodeHandle b) { return a.index < b.index; });
+        stale_hashes_.erase(std::unique(stale_hashes_.begin(), stale_hashes_.end()), stale_hashes_.end());
+    }
+}
+
+void NodeGraph::updateHash(NodeHandle handle) const {
+    // Depth-first over stale inputs without recursion, so long chains
+    // cannot overflow the stack. A node is entered once (marked in
+    // progress) to push its stale inputs and finished on its second visit.
+    hash_stack_.push_back(handle);
+    while (!hash_stack_.empty()) {
+        const NodeEntry* entry = nodes_.get(hash_stack_.back());
+        if (!entry || entry->hash > HASH_IN_PROGRESS) {
+            hash_stack_.pop_back();
+            continue;
+        }
+        if (entry->hash == 0) {
+            entry->hash = HASH_IN_PROGRESS;
+            bool waiting = false;
+            for (const Edge& edge : entry->incoming) {
+                if (nodes_.get(edge.peer)->hash == 0) {
+                    hash_stack_.push_back(edge.peer);
+                    waiting = true;
+                }
+            }
+            if (waiting) {
+                continue;
+            }
+        }
+        
+        entry->hash = computeHash(*entry);
+        uint64_t term = hashMix(entry->hash);
+        structure_hash_ += term - entry->hash_term;
+        if (entry->node->live_) {
+            live_structure_hash_ += term - entry->hash_term;
+        }
+        entry->hash_term = term;
+        hash_stack_.pop_back();
+    }
+}
+
+uint64_t NodeGraph::computeHash(const NodeEntry& entry) const {
+    const Node& node = *entry.node;
+    const ParameterBlock& parameters = node.getParameters();
+    
+    uint64_t hash = hashString(node.getTypeName());
+    for (size_t i = 0; i < parameters.getFieldCount(); ++i) {
+        const ParameterSchema::Field& field = parameters.getField(i);
+        hash = hashCombine(hash, hashString(AtomTable::name(field.atom)));
+        hash = hashCombine(hash, static_cast<uint64_t>(field.type));
+        if (field.type == osc::ParameterType::STRING) {
+            hash = hashCombine(hash, hashString(parameters.getString(field.slot)));
+        }
+    }
+    
+    // Summing the input terms makes the hash independent of edge order
+    uint64_t inputs = 0;
+    for (const Edge& edge : entry.incoming) {
+        const Connection& connection = *connections_.get(edge.connection);
+        uint64_t input = hashCombine(hashString(connection.getTargetInput()),
+                                     hashString(connection.getSourceOutput()));
+        inputs += hashMix(hashCombine(input, nodes_.get(edge.peer)->hash));
+    }
+    hash = hashCombine(hash, inputs);
+    
+    // 0 and HASH_IN_PROGRESS are reserved
+    return (hash > HASH_IN_PROGRESS) ? hash : hash + 2;
+}
+
+const std::vector<Node*>& NodeGraph::getTopologicalOrder() const {
+    if (topology_dirty_) {
+        rebuildTopologicalOrder();
+        topology_dirty_ = false;
+    }
+    return topological_order_;
+}
+
+void NodeGraph::rebuildTopologicalOrder() const {
+    // The ranks addConnection maintains are a topological order already;
+    // sorting by them keeps the cache consistent with the ranks, which lets
+    // connection edits patch it (see patchTopologicalOrder)
+    const size_t count = nodes_.size();
+    order_dense_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        order_dense_[i] = static_cast<uint32_t>(i);
+    }
+    std::sort(order_dense_.begin(), order_dense_.end(), [this](uint32_t a, uint32_t b) {
+        return nodes_[a].order < nodes_[b].order;
+    });
+    topological_order_.resize(count);
+    for (size_t position = 0; position < count; ++position) {
+        topological_order_[position] = nodes_[order_dense_[position]].node.get();
+    }
+    
+    position_of_dense_.resize(count);
+    time_dependent_positions_.clear();
+    for (uint32_t position = 0; position < count; ++position) {
+        position_of_dense_[order_dense_[position]] = position;
+        if (topological_order_[position]->isTimeDependent()) {
+            time_dependent_positions_.push_back(position);
+        }
+    }
+}
+
+const std::vector<Node*>& NodeGraph::collectDirtyNodes() {
+    // A changed time-dependent trait invalidates the cached schedule
+    for (NodeHandle handle : dirty_queue_) {
+        NodeEntry* entry = nodes_.get(handle);
+        if (entry && entry->node->schedule_changed_) {
+            entry->node->schedule_changed_ = false;
+            topology_dirty_ = true;
+        }
+    }
+    getTopologicalOrder();
+    
+    const size_t count = topological_order_.size();
+    if (visit_stamp_.size() != count) {
+        visit_stamp_.assign(count, 0);
+    }
+    if (++frame_stamp_ == 0) {
+        std::fill(visit_stamp_.begin(), visit_stamp_.end(), 0);
+        frame_stamp_ = 1;
+    }
+    
+    // Min-heap of topological positions: popping in order yields the cone
+    // downstream of the seeds already sorted, without touching other nodes
+    dirty_nodes_.clear();
+    dirty_heap_.clear();
+    auto visit = [this](uint32_t position) {
+        if (visit_stamp_[position] != frame_stamp_) {
+            visit_stamp_[position] = frame_stamp_;
+            Node* node = topological_order_[position];
+            if (prune_dead_nodes_ && !node->live_) {
+                node->dirty_ = false;   // Marked dirty again when it turns live
+                return;
+            }
+            dirty_heap_.push_back(position);
+            std::push_heap(dirty_heap_.begin(), dirty_heap_.end(), std::greater<uint32_t>());
+        }
+    };
+    
+    changed_nodes_.clear();
+    for (NodeHandle handle : dirty_queue_) {
+        if (nodes_.contains(handle)) {
+            uint32_t position = position_of_dense_[nodes_.denseIndex(handle)];
+            Node* node = topological_order_[position];
+            if (visit_stamp_[position] != frame_stamp_ && (node->live_ || !prune_dead_nodes_)) {
+                changed_nodes_.push_back(node);
+            }
+            visit(position);
+        }
+    }
+    dirty_queue_.clear();
+    for (uint32_t position : time_dependent_positions_) {
+        visit(position);
+    }
+    
+    while (!dirty_heap_.empty()) {
+        std::pop_heap(dirty_heap_.begin(), dirty_heap_.end(), std::greater<uint32_t>());
+        uint32_t position = dirty_heap_.back();
+        dirty_heap_.pop_back();
+        
+        const NodeEntry& entry = nodes_[order_dense_[position]];
+        entry.node->dirty_ = false;
+        dirty_nodes_.push_back(entry.node.get());
+        for (const Edge& edge : entry.outgoing) {
+            visit(position_of_dense_[nodes_.denseIndex(edge.peer)]);
+        }
+    }
+    
+    return dirty_nodes_;
+}
+
+void NodeGraph::takeChanges(Changes& changes) {
+    changes.changed.clear();
+    for (NodeHandle handle : dirty_queue_) {
+        NodeEntry* entry = nodes_.get(handle);
+        if (entry && entry->node->dirty_) {
+            entry->node->dirty_ = false;
+            changes.changed.push_back(handle);
+        }
+    }
+    dirty_queue_.clear();
+    
+    changes.removed.clear();
+    changes.removed.swap(removed_nodes_);
+    changes.connected.clear();
+    changes.connected.swap(added_connections_);
+    changes.disconnected.clear();
+    changes.disconnected.swap(removed_connections_);
+}
+
+void NodeGraph::applyVersion(const GraphVersion& version) {
+    if (version.isReset()) {
+        clear();
+    }
+    for (int node_id : version.getRemovedNodes()) {
+        removeNode(node_id);
+    }
+    
+    for (uint32_t slot : version.getChangedSlots()) {
+        const NodeState* state = version.getNode(slot);
+        if (!state) {
+            continue;
+        }
+        
+        // Nodes are rebuilt only when they turned into a different kind of node
+        Node* node = getNode(state->id);
+        if (!node || node->getTypeId() != state->type_id || node->getName() != state->name) {
+            std::shared_ptr<Node> created = createNode(state->id, state->name, AtomTable::name(state->type_id));
+            if (!created) {
+                continue;
+            }
+            node = created.get();
+            addNode(std::move(created));
+        }
+        bool structure_changed = !sameStructure(node->parameters_, state->parameters);
+        node->parameters_ = state->parameters;
+        if (structure_changed) {
+            node->markStructureChanged();
+        }
+        node->setPosition(state->x, state->y);
+        node->setTimeDependent(state->time_dependent);
+        node->markDirty();
+    }
+    
+    // Only the edges that changed: removals first, so the additions never
+    // meet an edge the writer already dropped (and cannot close a cycle)
+    for (int connection_id : version.getRemovedConnections()) {
+        removeConnection(connection_id);
+    }
+    for (uint32_t slot : version.getChangedConnectionSlots()) {
+        if (const Connection* connection = version.getConnection(slot)) {
+            addConnection(*connection);
+        }
+    }
+}
+
+std::shared_ptr<Node> NodeGraph::createNode(int id, const std::string& name, const std::string& type) const {
+    if (node_factory_) {
+        return node_factory_(id, name, type);
+    }
+    return std::make_shared<GenericNode>(id, name, type);
+}
+
+namespace {
+
+constexpr int JSON_FORMAT_VERSION = 1;
+
+void writeParameterValue(JsonWriter& writer, Parameter param) {
+    float v[4];
+    switch (param.getType()) {
+        case osc::ParameterType::INT:
+            writer.value(param.getIntValue());
+            return;
+        case osc::ParameterType::FLOAT:
+            writer.value(param.getFloatValue());
+            return;
+        case osc::ParameterType::STRING:
+            writer.value(param.getStringValue());
+            return;
+        case osc::ParameterType::BOOL:
+            writer.value(param.getBoolValue());
+            return;
+        case osc::ParameterType::VEC2:
+            param.getVec2Value(v[0], v[1]);
+            break;
+        case osc::ParameterType::VEC3:
+            param.getVec3Value(v[0], v[1], v[2]);
+            break;
+        case osc::ParameterType::VEC4:
+        case osc::ParameterType::COLOR:
+            param.getVec4Value(v[0], v[1], v[2], v[3]);
+            break;
+    }
+    writer.beginArray();
+    for (uint32_t i = 0; i < parameterComponents(param.getType()); ++i) {
+        writer.value(v[i]);
+    }
+    writer.endArray();
+}
+
+bool readParameterValue(JsonReader& reader, Parameter param, std::string& scratch) {
+    switch (param.getType()) {
+        case osc::ParameterType::INT: {
+            int value;
+            if (!reader.readInt(value)) return false;
+            param.setValue(value);
+            return true;
+        }
+        case osc::ParameterType::FLOAT: {
+            float value;
+            if (!reader.readFloat(value)) return false;
+            param.setValue(value);
+            return true;
+        }
+        case osc::ParameterType::STRING:
+            if (!reader.readString(scratch)) return false;
+            param.setValue(scratch);
+            return true;
+        case osc::ParameterType::BOOL: {
+            bool value;
+            if (!reader.readBool(value)) return false;
+            param.setValue(value);
+            return true;
+        }
+        default:
+            break;
+    }
+    
+    float v[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    int count = 0;
+    if (!reader.beginArray()) return false;
+    while (reader.nextElement()) {
+        if (count >= 4 || !reader.readFloat(v[count++])) return false;
+    }
+    if (reader.failed()) return false;
+    
+    switch (param.getType()) {
+        case osc::ParameterType::VEC2: param.setValue(v[0], v[1]); break;
+        case osc::ParameterType::VEC3: param.setValue(v[0], v[1], v[2]); break;
+        default: param.setValue(v[0], v[1], v[2], v[3]); break;
+    }
+    return true;
 }
 
-std::vector<std::shared_ptr<Node>> NodeGraph::getTopologicalOrder() const {
-    // Simple topological sort implementation
-    // For now, just return nodes in order of their IDs
-    // TODO: Implement proper topological sorting based on connections
-    std::vector<std::shared_ptr<Node>> result;
-    for (const auto& pair : nodes_) {
-        result.push_back(pair.second);
+// Scratch strings shared by the parse helpers so a load does not allocate
+// per node for keys and names
+struct ParseScratch {
+    std::string key;
+    std::string text;
+    std::string name;
+    std::string type;
+};
+
+bool readParameters(JsonReader& reader, Node& node, ParseScratch& scratch) {
+    if (!reader.beginArray()) return false;
+    while (reader.nextElement()) {
+        if (!reader.beginObject()) return false;
+        
+        Parameter param;
+        Atom atom = INVALID_ATOM;
+        bool have_type = false;
+        osc::ParameterType type = osc::ParameterType::FLOAT;
+        while (reader.nextKey(scratch.key)) {
+            if (scratch.key == "name") {
+                if (!reader.readString(scratch.text)) return false;
+                atom = AtomTable::intern(scratch.text);
+            } else if (scratch.key == "type") {
+                if (!reader.readString(scratch.text)) return false;
+                type = osc::stringToParameterType(scratch.text);
+                have_type = true;
+            } else if (scratch.key == "value") {
+                if (atom == INVALID_ATOM || !have_type) {
+                    return false;  // name and type must precede the value
+                }
+                param = node.addParameter(atom, type);
+                if (param.getType() != type || !readParameterValue(reader, param, scratch.text)) {
+                    return false;
+                }
+            } else if (!reader.skipValue()) {
+                return false;
+            }
+        }
+        if (reader.failed()) return false;
+        
+        // A parameter without a value still belongs to the schema
+        if (!param && atom != INVALID_ATOM) {
+            node.addParameter(atom, type);
+        }
     }
-    return result;
+    return !reader.failed();
 }
 
+} // namespace
+
 std::string NodeGraph::toJSON() const {
-    // TODO: Implement JSON serialization
-    return "{}";
+    std::string json;
+    JsonWriter writer(json);
+    writeJSON(writer);
+    return json;
+}
+
+void NodeGraph::writeJSON(std::ostream& stream) const {
+    JsonWriter writer(stream);
+    writeJSON(writer);
+    writer.flush();
+}
+
+void NodeGraph::writeJSON(JsonWriter& writer) const {
+    writer.beginObject();
+    writer.key("version");
+    writer.value(JSON_FORMAT_VERSION);
+    
+    writer.key("nodes");
+    writer.beginArray();
+    for (const NodeEntry& entry : nodes_) {
+        Node& node = *entry.node;
+        float x, y;
+        node.getPosition(x, y);
+        
+        writer.beginObject();
+        writer.key("id");
+        writer.value(node.getId());
+        writer.key("name");
+        writer.value(node.getName());
+        writer.key("type");
+        writer.value(node.getTypeName());
+        writer.key("x");
+        writer.value(x);
+        writer.key("y");
+        writer.value(y);
+        if (node.isTimeDependent()) {
+            writer.key("time_dependent");
+            writer.value(true);
+        }
+        
+        writer.key("params");
+        writer.beginArray();
+        for (size_t i = 0; i < node.getParameterCount(); ++i) {
+            Parameter param = node.getParameterAt(i);
+            writer.beginObject();
+            writer.key("name");
+            writer.value(param.getName());
+            writer.key("type");
+            writer.value(osc::parameterTypeToString(param.getType()));
+            writer.key("value");
+            writeParameterValue(writer, param);
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.endObject();
+    }
+    writer.endArray();
+    
+    writer.key("connections");
+    writer.beginArray();
+    for (const Connection& connection : connections_) {
+        writer.beginObject();
+        writer.key("id");
+        writer.value(connection.getId());
+        writer.key("source");
+        writer.value(connection.getSourceNodeId());
+        writer.key("output");
+        writer.value(connection.getSourceOutput());
+        writer.key("target");
+        writer.value(connection.getTargetNodeId());
+        writer.key("input");
+        writer.value(connection.getTargetInput());
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
 }
 
 bool NodeGraph::fromJSON(const std::string& json) {
-    // TODO: Implement JSON deserialization
-    return false;
+    return fromJSON(json.data(), json.size());
+}
+
+bool NodeGraph::fromJSON(const char* data, size_t size) {
+    clear();
+    
+    JsonReader reader(data, size);
+    ParseScratch scratch;
+    std::vector<Connection> deferred;  // Connections seen before their nodes
+    
+    auto readNodes = [&]() {
+        if (!reader.beginArray()) return false;
+        while (reader.nextElement()) {
+            if (!reader.beginObject()) return false;
+            
+            int id = -1;
+            float x = 0.0f, y = 0.0f;
+            bool time_dependent = false;
+            scratch.name.clear();
+            scratch.type.clear();
+            std::shared_ptr<Node> node;
+            
+            while (reader.nextKey(scratch.key)) {
+                bool ok = true;
+                if (scratch.key == "id") {
+                    ok = reader.readInt(id);
+                } else if (scratch.key == "name") {
+                    ok = reader.readString(scratch.name);
+                } else if (scratch.key == "type") {
+                    ok = reader.readString(scratch.type);
+                } else if (scratch.key == "x") {
+                    ok = reader.readFloat(x);
+                } else if (scratch.key == "y") {
+                    ok = reader.readFloat(y);
+                } else if (scratch.key == "time_dependent") {
+                    ok = reader.readBool(time_dependent);
+                } else if (scratch.key == "params") {
+                    // id, name and type must precede params
+                    if (id < 0 || node) return false;
+                    node = createNode(id, scratch.name, scratch.type);
+                    ok = node && readParameters(reader, *node, scratch);
+                } else {
+                    ok = reader.skipValue();
+                }
+                if (!ok) return false;
+            }
+            if (reader.failed() || id < 0) return false;
+            
+            if (!node) {
+                node = createNode(id, scratch.name, scratch.type);
+                if (!node) return false;
+            }
+            node->setPosition(x, y);
+            if (time_dependent) {
+                node->setTimeDependent(true);
+            }
+            addNode(std::move(node));
+        }
+        return !reader.failed();
+    };
+    
+    auto readConnections = [&]() {
+        if (!reader.beginArray()) return false;
+        std::string output, input;
+        while (reader.nextElement()) {
+            if (!reader.beginObject()) return false;
+            int id = -1, source = -1, target = -1;
+            output.clear();
+            input.clear();
+            while (reader.nextKey(scratch.key)) {
+                bool ok = true;
+                if (scratch.key == "id") {
+                    ok = reader.readInt(id);
+                } else if (scratch.key == "source") {
+                    ok = reader.readInt(source);
+                } else if (scratch.key == "output") {
+                    ok = reader.readString(output);
+                } else if (scratch.key == "target") {
+                    ok = reader.readInt(target);
+                } else if (scratch.key == "input") {
+                    ok = reader.readString(input);
+                } else {
+                    ok = reader.skipValue();
+                }
+                if (!ok) return false;
+            }
+            if (reader.failed() || id < 0) return false;
+            
+            Connection connection(id, source, output, target, input);
+            if (!addConnection(connection).isValid()) {
+                deferred.push_back(std::move(connection));
+            }
+        }
+        return !reader.failed();
+    };
+    
+    bool ok = reader.beginObject();
+    while (ok && reader.nextKey(scratch.key)) {
+        if (scratch.key == "version") {
+            int version = 0;
+            ok = reader.readInt(version) && version <= JSON_FORMAT_VERSION;
+        } else if (scratch.key == "nodes") {
+            ok = readNodes();
+        } else if (scratch.key == "connections") {
+            ok = readConnections();
+        } else {
+            ok = reader.skipValue();
+        }
+    }
+    ok = ok && !reader.failed() && reader.atEnd();
+    
+    for (const Connection& connection : deferred) {
+        if (!ok) break;
+        ok = addConnection(connection).isValid();
+    }
+    
+    if (!ok) {
+        std::cerr << "Failed to parse node graph JSON"
+                  << (reader.failed() ? ": " + reader.getError() : std::string()) << std::endl;
+        clear();
+        return false;
+    }
+    return true;
+}
+
+bool NodeGraph::saveSnapshot(const std::string& path) const {
+    return GraphSnapshot::write(*this, path);
+}
+
+bool NodeGraph::loadSnapshot(const std::string& path) {
+    GraphSnapshot snapshot;
+    if (!snapshot.open(path)) {
+        clear();
+        return false;
+    }
+    return loadSnapshot(snapshot);
+}
+
+bool NodeGraph::loadSnapshot(const GraphSnapshot& snapshot) {
+    clear();
+    if (!snapshot.isOpen()) {
+        return false;
+    }
+    
+    // Parameter names are interned on first use, once per distinct string
+    std::vector<Atom> atoms(snapshot.getStringCount(), INVALID_ATOM);
+    auto atomAt = [&](uint32_t index) {
+        std::string_view name;
+        if (index < atoms.size() && atoms[index] == INVALID_ATOM && snapshot.getString(index, name)) {
+            atoms[index] = AtomTable::intern(std::string(name));
+        }
+        return index < atoms.size() ? atoms[index] : INVALID_ATOM;
+    };
+    
+    // Nodes with the same parameter layout share one schema instead of each
+    // building (and copying) its own field by field
+    std::unordered_map<std::string, std::shared_ptr<const ParameterSchema>> schemas;
+    std::string layout;
+    auto sharedSchema = [&](const snapshot::NodeRecord& record) -> std::shared_ptr<const ParameterSchema> {
+        layout.clear();
+        for (uint32_t p = 0; p < record.parameter_count; ++p) {
+            const snapshot::ParameterRecord& param = snapshot.getParameter(record.first_parameter + p);
+            layout.append(reinterpret_cast<const char*>(&param.name), sizeof(param.name));
+            layout.append(reinterpret_cast<const char*>(&param.type), sizeof(param.type));
+        }
+        
+        auto it = schemas.find(layout);
+        if (it == schemas.end()) {
+            auto schema = std::make_shared<ParameterSchema>();
+            for (uint32_t p = 0; p < record.parameter_count; ++p) {
+                const snapshot::ParameterRecord& param = snapshot.getParameter(record.first_parameter + p);
+                Atom atom = atomAt(param.name);
+                if (atom == INVALID_ATOM || param.type > static_cast<uint32_t>(osc::ParameterType::COLOR)) {
+                    return nullptr;
+                }
+                schema->addField(atom, static_cast<osc::ParameterType>(param.type));
+            }
+            it = schemas.emplace(layout, std::move(schema)).first;
+        }
+        return it->second;
+    };
+    
+    auto loadNodes = [&]() {
+        const size_t parameter_count = snapshot.getParameterCount();
+        std::string_view name, type, text;
+        for (size_t n = 0; n < snapshot.getNodeCount(); ++n) {
+            const snapshot::NodeRecord& record = snapshot.getNode(n);
+            if (!snapshot.getString(record.name, name) || !snapshot.getString(record.type, type) ||
+                record.first_parameter > parameter_count ||
+                record.parameter_count > parameter_count - record.first_parameter) {
+                return false;
+            }
+            
+            std::shared_ptr<Node> node = createNode(record.id, std::string(name), std::string(type));
+            if (!node) {
+                return false;
+            }
+            
+            ParameterBlock& block = node->parameters_;
+            if (block.getFieldCount() == 0 && record.parameter_count > 0) {
+                auto schema = sharedSchema(record);
+                if (!schema) {
+                    return false;
+                }
+                block = ParameterBlock(std::move(schema));
+            }
+            for (uint32_t p = 0; p < record.parameter_count; ++p) {
+                const snapshot::ParameterRecord& param = snapshot.getParameter(record.first_parameter + p);
+                Atom atom = atomAt(param.name);
+                if (atom == INVALID_ATOM || param.type > static_cast<uint32_t>(osc::ParameterType::COLOR)) {
+                    return false;
+                }
+                
+                auto param_type = static_cast<osc::ParameterType>(param.type);
+                const ParameterSchema::Field& field = block.getField(block.addField(atom, param_type));
+                if (field.type != param_type) {
+                    return false;
+                }
+                if (param_type == osc::ParameterType::STRING) {
+                    if (!snapshot.getString(static_cast<uint32_t>(param.value.i[0]), text)) {
+                        return false;
+                    }
+                    block.getString(field.slot).assign(text.data(), text.size());
+                } else {
+                    block.getSlot(field.slot) = param.value;
+                }
+            }
+            
+            node->setPosition(record.x, record.y);
+            if (record.flags & snapshot::NODE_TIME_DEPENDENT) {
+                node->setTimeDependent(true);
+            }
+            addNode(std::move(node));
+        }
+        return true;
+    };
+    
+    auto loadConnections = [&]() {
+        std::string_view output, input;
+        for (size_t c = 0; c < snapshot.getConnectionCount(); ++c) {
+            const snapshot::ConnectionRecord& record = snapshot.getConnection(c);
+            if (!snapshot.getString(record.source_output, output) ||
+                !snapshot.getString(record.target_input, input)) {
+                return false;
+            }
+            Connection connection(record.id, record.source_node, std::string(output),
+                                  record.target_node, std::string(input));
+            if (!addConnection(connection).isValid()) {
+                return false;
+            }
+        }
+        return true;
+    };
+    
+    nodes_.reserve(snapshot.getNodeCount());
+    node_ids_.reserve(snapshot.getNodeCount());
+    connections_.reserve(snapshot.getConnectionCount());
+    connection_ids_.reserve(snapshot.getConnectionCount());
+    if (!loadNodes() || !loadConnections()) {
+        std::cerr << "Invalid record in graph snapshot" << std::endl;
+        clear();
+        return false;
+    }
+    return true;
 }
 
 } // namespace gfx
@@ -1,9 +1,16 @@
 #pragma once
 
 #include <string>
+#include <functional>
+#include <iosfwd>
 #include <map>
+#include <unordered_map>
 #include <memory>
+#include <memory_resource>
 #include <vector>
+#include "SlotMap.h"
+#include "Atom.h"
+#include "ParameterBlock.h"
 #include "../osc/OSCMessages.h"
 
 namespace gfx {
@@ -11,15 +18,34 @@ namespace gfx {
 // Forward declarations
 class Node;
 class Connection;
+class NodeGraph;
+class JsonWriter;
+class GraphSnapshot;
+class GraphVersion;
+class GraphLog;
+class GraphLogReplayer;
 
-// Parameter value holder
+// Handles into the graph's slot maps. They detect stale references: once a
+// node or connection is removed its handle never resolves again.
+struct NodeEntry;
+using NodeHandle = SlotHandle<NodeEntry>;
+using ConnectionHandle = SlotHandle<Connection>;
+
+// Lightweight view of one parameter inside a node's ParameterBlock. Views
+// are cheap to copy and stay valid as long as the owning node is alive. A
+// default-constructed view is null and converts to false. Writes through a
+// view mark the owning node dirty.
 class Parameter {
 public:
-    Parameter(const std::string& name, osc::ParameterType type);
+    Parameter() : node_(nullptr), field_(0) {}
+    Parameter(Node* node, uint32_t field) : node_(node), field_(field) {}
+    
+    explicit operator bool() const { return node_ != nullptr; }
     
     // Getters
-    const std::string& getName() const { return name_; }
-    osc::ParameterType getType() const { return type_; }
+    Atom getId() const { return field().atom; }
+    const std::string& getName() const { return AtomTable::name(field().atom); }
+    osc::ParameterType getType() const { return field().type; }
     
     // Type-specific setters
     void setValue(int value);
@@ -43,52 +69,116 @@ public:
     std::string toString() const;
     void fromString(const std::string& str);
     
-private:
-    std::string name_;
-    osc::ParameterType type_;
+    // Typed writes for high-rate input such as OSC controllers. Values are
+    // converted to the parameter's type without strings or exceptions (ints
+    // are clamped to their range); returns false if the component count
+    // does not fit the type or an int parameter is given NaN.
+    bool assign(const float* values, int count);
+    bool assign(int value);
+    
+    // One component of a numeric value as float (ints and bools converted),
+    // e.g. for automation; 0 / false if the component does not exist
+    float getComponent(uint32_t component) const;
+    bool assignComponent(uint32_t component, float value);
     
-    // Union for storing different types
-    union {
-        int int_value;
-        float float_value;
-        bool bool_value;
-        float vec_values[4]; // For vec2, vec3, vec4
-    } data_;
+private:
+    const ParameterSchema::Field& field() const;
+    ParameterSlot& writeSlot();
+    const ParameterSlot& slot() const;
     
-    std::string string_value_; // Separate storage for strings
+    Node* node_;
+    uint32_t field_;
 };
 
 // Node base class
 class Node {
 public:
     Node(int id, const std::string& name, osc::NodeType type);
+    Node(int id, const std::string& name, osc::NodeType type, Atom type_id);
     virtual ~Node() = default;
     
-    // Basic info
+    // Basic info. The type ID is the interned type name the node was
+    // created with (e.g. "color"); getType() is its broad category. Without
+    // an explicit type ID the category name is used.
     int getId() const { return id_; }
     const std::string& getName() const { return name_; }
     osc::NodeType getType() const { return type_; }
+    Atom getTypeId() const { return type_id_; }
+    const std::string& getTypeName() const { return AtomTable::name(type_id_); }
     
-    // Parameters
-    void addParameter(std::shared_ptr<Parameter> param);
-    std::shared_ptr<Parameter> getParameter(const std::string& name);
-    const std::map<std::string, std::shared_ptr<Parameter>>& getParameters() const { return parameters_; }
+    // Parameters. Names are interned into atoms; lookups by atom are O(1).
+    Parameter addParameter(const std::string& name, osc::ParameterType type);
+    Parameter addParameter(Atom atom, osc::ParameterType type);
+    Parameter getParameter(const std::string& name);
+    Parameter getParameter(Atom atom);
+    Parameter getParameterAt(size_t index) { return Parameter(this, static_cast<uint32_t>(index)); }
+    size_t getParameterCount() const { return parameters_.getFieldCount(); }
+    const ParameterBlock& getParameters() const { return parameters_; }
     
     // Position (for visual representation)
-    void setPosition(float x, float y) { pos_x_ = x; pos_y_ = y; }
+    void setPosition(float x, float y);
     void getPosition(float& x, float& y) const { x = pos_x_; y = pos_y_; }
     
-    // Processing (to be implemented by derived classes)
+    // Processing (to be implemented by derived classes). May run on a pool
+    // thread and must not write parameters or edit the graph (see
+    // NodeScheduler).
     virtual void process() = 0;
     virtual void initialize() {}
     virtual void cleanup() {}
     
+    // Change tracking. Parameter writes and connection edits mark a node
+    // dirty; the graph then re-processes it and everything downstream of it
+    // on the next frame. Time-dependent nodes are processed every frame.
+    void markDirty();
+    bool isDirty() const { return dirty_; }
+    void setTimeDependent(bool time_dependent);
+    bool isTimeDependent() const { return time_dependent_; }
+    
+    // Whether the node is an output or feeds one, i.e. contributes to what
+    // is rendered; maintained by the graph the node belongs to
+    bool isLive() const { return live_; }
+    
+    // Handle of this node in the graph it was added to (invalid if none)
+    NodeHandle getGraphHandle() const { return graph_handle_; }
+    
 protected:
     int id_;
     std::string name_;
     osc::NodeType type_;
-    std::map<std::string, std::shared_ptr<Parameter>> parameters_;
+    Atom type_id_;
+    ParameterBlock parameters_;
     float pos_x_, pos_y_;
+    
+private:
+    friend class Parameter;
+    friend class NodeGraph;
+    friend class GraphLogReplayer;
+    
+    void logParameter(uint32_t field);
+    void markStructureChanged();               // Input to the structural hash changed
+    
+    bool dirty_;
+    bool time_dependent_;
+    bool schedule_changed_;                    // Time-dependent trait changed since last frame
+    bool live_;                                // Reaches an output node (see NodeGraph::isLive)
+    NodeHandle graph_handle_;                  // Handle in the graph that owns the dirty queue
+    std::vector<NodeHandle>* dirty_queue_;     // Owning graph's queue of newly dirty nodes
+                                               // (validated against the graph when drained)
+    GraphLog* log_;                            // Owning graph's operation log, if any
+    bool hash_queued_;                         // Queued in hash_queue_ since the last hash query
+    std::vector<NodeHandle>* hash_queue_;      // Owning graph's queue of nodes whose hash changed
+};
+
+// Concrete node without CPU-side processing. Used for nodes loaded from
+// files or mirrored from the engine when no specialised type is needed.
+class GenericNode : public Node {
+public:
+    using Node::Node;
+    
+    // Keeps the type name as given; the category is derived from it
+    GenericNode(int id, const std::string& name, const std::string& type);
+    
+    void process() override {}
 };
 
 // Connection between nodes
@@ -111,37 +201,285 @@ private:
     std::string target_input_;
 };
 
+// Why NodeGraph::addConnection() rejected a connection
+enum class ConnectionError {
+    NONE,
+    MISSING_NODE,       // Source or target node does not exist
+    CYCLE               // The connection would close a cycle
+};
+
+const char* connectionErrorToString(ConnectionError error);
+
+// One side of a connection as seen from a node. For incoming edges peer is
+// the source node, for outgoing edges it is the target node.
+struct Edge {
+    ConnectionHandle connection;
+    NodeHandle peer;
+};
+
+// Per-node record in the graph's dense node storage
+struct NodeEntry {
+    std::shared_ptr<Node> node;
+    std::vector<Edge> incoming;
+    std::vector<Edge> outgoing;
+    mutable uint64_t hash = 0;          // Structural hash, 0 while stale (see getNodeHash)
+    mutable uint64_t hash_term = 0;     // This node's share of the graph's structure hash
+    uint64_t order = 0;                 // Rank in the graph's dynamic topological order
+    uint32_t order_stamp = 0;           // Visit mark for order maintenance
+    uint32_t live_successors = 0;       // Outgoing edges into live nodes
+};
+
 // Graph that holds nodes and connections
 class NodeGraph {
 public:
+    using NodeMap = SlotMap<NodeEntry>;
+    using ConnectionMap = SlotMap<Connection>;
+    
     NodeGraph();
-    ~NodeGraph() = default;
+    ~NodeGraph();
     
-    // Node management
-    void addNode(std::shared_ptr<Node> node);
+    // Not copyable: a copy would share the original's nodes, which point at
+    // the original's dirty queue and log. Copy through toJSON/fromJSON.
+    NodeGraph(const NodeGraph&) = delete;
+    NodeGraph& operator=(const NodeGraph&) = delete;
+    
+    // Node management. Adding a node whose ID already exists replaces it in
+    // place and keeps its connections.
+    NodeHandle addNode(std::shared_ptr<Node> node);
     void removeNode(int node_id);
-    std::shared_ptr<Node> getNode(int node_id);
-    const std::map<int, std::shared_ptr<Node>>& getNodes() const { return nodes_; }
+    void removeNode(NodeHandle handle);
+    Node* getNode(int node_id) const;
+    Node* getNode(NodeHandle handle) const;
+    NodeHandle findNode(int node_id) const;
+    const NodeMap& getNodes() const { return nodes_; }
     
-    // Connection management
-    void addConnection(std::shared_ptr<Connection> connection);
+    // Connection management. Returns an invalid handle if either endpoint
+    // does not exist or the connection would close a cycle; error (if
+    // given) says which.
+    //
+    // Cycles are rejected online: the graph keeps every node ranked so that
+    // sources rank before targets (Pearce-Kelly). A connection that already
+    // agrees with the ranking is accepted in O(1); otherwise only the nodes
+    // ranked between its endpoints are searched and re-ranked, and only
+    // their entries in the cached topological order are rewritten.
+    ConnectionHandle addConnection(const Connection& connection, ConnectionError* error = nullptr);
     void removeConnection(int connection_id);
-    std::shared_ptr<Connection> getConnection(int connection_id);
-    const std::map<int, std::shared_ptr<Connection>>& getConnections() const { return connections_; }
+    void removeConnection(ConnectionHandle handle);
+    const Connection* getConnection(int connection_id) const;
+    const Connection* getConnection(ConnectionHandle handle) const;
+    ConnectionHandle findConnection(int connection_id) const;
+    // An ID above every connection this graph has held, however it was added
+    // (loaded, replayed or connected)
+    int allocateConnectionId() { return next_connection_id_++; }
+    ConnectionHandle findConnection(int source_node_id, const std::string& source_output,
+                                    int target_node_id, const std::string& target_input) const;
+    const ConnectionMap& getConnections() const { return connections_; }
+    
+    // Adjacency queries: edges feeding into / driven by a node.
+    // Views stay valid until the next node or connection edit.
+    const std::vector<Edge>& getIncomingConnections(int node_id) const;
+    const std::vector<Edge>& getOutgoingConnections(int node_id) const;
+    const std::vector<Edge>& getIncomingConnections(NodeHandle handle) const;
+    const std::vector<Edge>& getOutgoingConnections(NodeHandle handle) const;
     
     // Graph operations
     void clear();
-    std::vector<std::shared_ptr<Node>> getTopologicalOrder() const;
     
-    // Serialization
+    // Dependency order over connections (sources before targets), i.e. the
+    // nodes sorted by rank. The order is cached: it is re-sorted after nodes
+    // are added or removed, and patched in place by connection edits, so
+    // per-frame callers iterate it without allocating or touching refcounts.
+    const std::vector<Node*>& getTopologicalOrder() const;
+    
+    // Collect the nodes that need processing this frame: every dirty node,
+    // everything downstream of one, and all time-dependent nodes, in
+    // topological order. Only the affected cone is visited. Dirty flags are
+    // cleared; the returned buffer is reused between calls.
+    const std::vector<Node*>& collectDirtyNodes();
+    
+    // Nodes in the last collectDirtyNodes() result that were marked dirty
+    // themselves (parameter writes, node edits) rather than only being
+    // downstream of one or time-dependent
+    const std::vector<Node*>& getChangedNodes() const { return changed_nodes_; }
+    
+    // Live set: output nodes and every node with a path to one. It is kept
+    // up to date on each node and connection edit by walking upstream from
+    // the nodes whose count of live targets crossed zero, so parking or
+    // reattaching a subgraph costs its size, not the graph's. Nodes entering
+    // or leaving the set are marked dirty, so they are processed (or
+    // republished) with their current state.
+    //
+    // With dead-node pruning enabled, collectDirtyNodes() leaves out nodes
+    // outside the live set; everything downstream of such a node is outside
+    // it too. Pruning is off by default since a graph without output nodes
+    // has no live nodes.
+    bool isLive(NodeHandle handle) const;
+    size_t getLiveNodeCount() const { return live_count_; }
+    void setDeadNodePruning(bool enabled) { prune_dead_nodes_ = enabled; }
+    bool getDeadNodePruning() const { return prune_dead_nodes_; }
+    
+    // Serialization. The writer streams the graph without building it in
+    // memory; the parser is single-pass and writes straight into new nodes,
+    // parameters and connections. fromJSON replaces the current contents and
+    // leaves the graph empty on failure.
     std::string toJSON() const;
+    void writeJSON(std::ostream& stream) const;
     bool fromJSON(const std::string& json);
+    bool fromJSON(const char* data, size_t size);
+    
+    // Binary snapshots (see GraphSnapshot). loadSnapshot reads records
+    // straight from the mapped file without parsing, copying numeric values
+    // as whole slots and strings into the nodes; like fromJSON it replaces
+    // the current contents and leaves the graph empty on failure.
+    bool saveSnapshot(const std::string& path) const;
+    bool loadSnapshot(const GraphSnapshot& snapshot);
+    bool loadSnapshot(const std::string& path);
+    
+    // Change log for publishing the graph to other threads (see
+    // GraphPublisher). With tracking enabled, takeChanges() reports the nodes
+    // added or changed, the nodes removed, and the connections added and
+    // removed since the previous call (re-using a connection ID shows as
+    // both); the structure revision counts node and connection edits. It
+    // consumes the same queue as collectDirtyNodes(), so a graph uses one or
+    // the other.
+    struct Changes {
+        std::vector<NodeHandle> changed;
+        std::vector<std::pair<NodeHandle, int>> removed;   // Handle and node ID
+        std::vector<ConnectionHandle> connected;
+        std::vector<std::pair<ConnectionHandle, int>> disconnected;   // Handle and connection ID
+    };
+    void setChangeTracking(bool enabled) { track_changes_ = enabled; }
+    void takeChanges(Changes& changes);
+    uint64_t getStructureRevision() const { return structure_revision_; }
+    
+    // Bring this graph in line with a published version: the render side
+    // keeps its own graph and applies the changes carried by each version
+    void applyVersion(const GraphVersion& version);
+    
+    // Memory for temporaries of the topological sort and applyVersion, e.g.
+    // a FrameArena owned by the thread that uses the graph. Defaults to the
+    // heap (std::pmr::get_default_resource()).
+    void setScratchResource(std::pmr::memory_resource* resource) { scratch_resource_ = resource; }
+    std::pmr::memory_resource* getScratchResource() const { return scratch_resource_; }
+    
+    // Structural (Merkle) hashes. A node's hash covers its type, parameter
+    // layout and string parameter values, plus the hashes of the nodes
+    // feeding it and the ports they connect through. Numeric values are
+    // uniforms and do not count. Node IDs and names do not count either, so
+    // an identical subgraph hashes the same in any graph and any session.
+    // Hashes are cached; after an edit only the changed nodes and their
+    // downstream cone are recomputed, on the next query.
+    uint64_t getNodeHash(NodeHandle handle) const;
+    uint64_t getNodeHash(int node_id) const;
+    
+    // Key for anything generated from the whole graph (e.g. the shader
+    // program): the sum of every node's hash, which covers the connections
+    // through the input terms. It does not depend on node IDs, so generated
+    // code must refer to nodes by canonical position (see getCanonicalOrder)
+    // for equal keys to mean equal code.
+    uint64_t getStructureHash() const;
+    
+    // Like getStructureHash(), but covering only live nodes and the
+    // connections between them, so edits to parked subgraphs leave it alone
+    uint64_t getLiveStructureHash() const;
+    
+    // Live nodes in canonical order: output nodes by hash, each followed
+    // depth-first by the nodes feeding it, ordered by port names and hash.
+    // Positions depend only on the live structure, so graphs with the same
+    // live structure hash agree on them whatever their IDs.
+    void getCanonicalOrder(std::vector<NodeHandle>& out) const;
+    
+    // Operation log (see GraphLog). While a log is attached, every node,
+    // connection and parameter edit is recorded after it is applied.
+    void setLog(GraphLog* log);
+    GraphLog* getLog() const { return log_; }
+    
+    // Creates nodes during deserialization; defaults to GenericNode (see
+    // NodeRegistry::getFactory for registered node kinds)
+    using NodeFactory = std::function<std::shared_ptr<Node>(int id, const std::string& name,
+                                                            const std::string& type)>;
+    void setNodeFactory(NodeFactory factory) { node_factory_ = std::move(factory); }
+    std::shared_ptr<Node> createNode(int id, const std::string& name, const std::string& type) const;
     
 private:
-    std::map<int, std::shared_ptr<Node>> nodes_;
-    std::map<int, std::shared_ptr<Connection>> connections_;
+    NodeMap nodes_;
+    ConnectionMap connections_;
+    
+    // Side indices keeping the integer ID API working
+    std::unordered_map<int, NodeHandle> node_ids_;
+    std::unordered_map<int, ConnectionHandle> connection_ids_;
+    
     int next_node_id_;
     int next_connection_id_;
+    NodeFactory node_factory_;
+    
+    // Cached topological order, rebuilt lazily when topology_dirty_ is set.
+    // order_dense_ maps positions to dense node indices and position_of_dense_
+    // maps back; time_dependent_positions_ lists nodes that run every frame.
+    // Connection edits never set topology_dirty_ (see patchTopologicalOrder).
+    mutable std::vector<Node*> topological_order_;
+    mutable std::vector<uint32_t> order_dense_;
+    mutable std::vector<uint32_t> position_of_dense_;
+    mutable std::vector<uint32_t> time_dependent_positions_;
+    mutable bool topology_dirty_;
+    
+    // Dirty propagation state, reused across frames to avoid allocation
+    std::vector<NodeHandle> dirty_queue_;
+    std::vector<Node*> dirty_nodes_;
+    std::vector<Node*> changed_nodes_;
+    std::vector<uint32_t> dirty_heap_;
+    std::vector<uint32_t> visit_stamp_;
+    uint32_t frame_stamp_;
+    
+    // Change log (see takeChanges)
+    bool track_changes_;
+    uint64_t structure_revision_;
+    std::vector<std::pair<NodeHandle, int>> removed_nodes_;
+    std::vector<ConnectionHandle> added_connections_;
+    std::vector<std::pair<ConnectionHandle, int>> removed_connections_;
+    
+    GraphLog* log_;
+    std::pmr::memory_resource* scratch_resource_;
+    
+    // Dynamic topological order (see addConnection). Ranks only grow, so
+    // new nodes go last; scratch buffers are reused between connects.
+    uint64_t next_order_;
+    uint32_t order_stamp_;
+    std::vector<NodeHandle> order_stack_;
+    std::vector<NodeHandle> order_forward_;
+    std::vector<NodeHandle> order_backward_;
+    std::vector<uint64_t> order_pool_;
+    std::vector<uint32_t> order_positions_;
+    
+    // Live set (see isLive). live_structure_hash_ sums the hash terms of
+    // live nodes; connections count through their targets' hashes.
+    bool prune_dead_nodes_;
+    size_t live_count_;
+    std::vector<NodeHandle> live_stack_;
+    
+    // Structural hash state. hash_queue_ is filled by nodes and drained on
+    // the next hash query; stale_hashes_ lists the nodes whose hash was
+    // reset since then. structure_hash_ sums the hash terms of all nodes.
+    mutable std::vector<NodeHandle> hash_queue_;
+    mutable std::vector<NodeHandle> stale_hashes_;
+    mutable std::vector<NodeHandle> hash_stack_;
+    mutable uint64_t structure_hash_;
+    mutable uint64_t live_structure_hash_;
+    
+    void writeJSON(JsonWriter& writer) const;
+    void rebuildTopologicalOrder() const;
+    void eraseConnection(ConnectionHandle handle);   // removeConnection without logging
+    void unlinkEdge(std::vector<Edge>& edges, ConnectionHandle connection);
+    void markNodeDirty(NodeHandle handle);
+    bool reorderForConnection(NodeHandle source, NodeHandle target, ConnectionHandle replaced);
+    void patchTopologicalOrder();
+    void updateLiveness(NodeHandle handle);
+    void drainHashQueue() const;
+    void invalidateHash(NodeHandle handle) const;
+    void updateHash(NodeHandle handle) const;
+    uint64_t computeHash(const NodeEntry& entry) const;
+    void attachNode(Node* node, NodeHandle handle);
+    void detachNode(Node* node);
 };
 
 } // namespace gfx
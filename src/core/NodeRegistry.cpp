@@ -0,0 +1,211 @@
+#include "NodeRegistry.h"
+#include <cmath>
+
+namespace gfx {
+
+namespace {
+
+// Batch kernels are plain loops over columns without calls or branches, so
+// the compiler can vectorize them (-O3, i.e. Release builds)
+
+// Columns: frequency, amplitude, offset, phase, shape -> value
+// shape: 0 sine, 1 triangle, 2 saw, 3 square
+void lfoKernel(const BatchView& batch) {
+    const float* frequency = batch.parameters[0];
+    const float* amplitude = batch.parameters[1];
+    const float* offset = batch.parameters[2];
+    const float* phase = batch.parameters[3];
+    const float* shape = batch.parameters[4];
+    float* value = batch.outputs[0];
+    for (size_t i = 0; i < batch.count; ++i) {
+        float position = batch.time * frequency[i] + phase[i];
+        float cycle = position - static_cast<float>(static_cast<int32_t>(position));
+        cycle += (cycle < 0.0f) ? 1.0f : 0.0f;
+        
+        // Parabolic sine approximation (error < 0.001), shifted by half a cycle
+        float u = cycle - 0.5f;
+        float sine = 16.0f * u * std::fabs(u) - 8.0f * u;
+        sine += 0.225f * (sine * std::fabs(sine) - sine);
+        float triangle = 1.0f - 4.0f * std::fabs(u);
+        float saw = 2.0f * cycle - 1.0f;
+        float square = (cycle < 0.5f) ? 1.0f : -1.0f;
+        
+        // Selected by blending with 0/1 weights: a select between computed
+        // values would be compiled as a branch (floating point may trap)
+        float wave = sine;
+        wave += ((shape[i] >= 0.5f) ? 1.0f : 0.0f) * (triangle - wave);
+        wave += ((shape[i] >= 1.5f) ? 1.0f : 0.0f) * (saw - wave);
+        wave += ((shape[i] >= 2.5f) ? 1.0f : 0.0f) * (square - wave);
+        value[i] = offset[i] + amplitude[i] * wave;
+    }
+}
+
+// Columns: scale, offset; in -> value
+void remapKernel(const BatchView& batch) {
+    const float* scale = batch.parameters[0];
+    const float* offset = batch.parameters[1];
+    const float* in = batch.inputs[0];
+    float* value = batch.outputs[0];
+    for (size_t i = 0; i < batch.count; ++i) {
+        value[i] = in[i] * scale[i] + offset[i];
+    }
+}
+
+} // namespace
+
+// NodeKind implementation
+NodeKind& NodeKind::addInput(const std::string& name, osc::ParameterType type) {
+    inputs.push_back({AtomTable::intern(name), type});
+    return *this;
+}
+
+NodeKind& NodeKind::addOutput(const std::string& name, osc::ParameterType type) {
+    outputs.push_back({AtomTable::intern(name), type});
+    return *this;
+}
+
+NodeKind& NodeKind::addParameter(const std::string& name, osc::ParameterType type,
+                                 std::initializer_list<float> value) {
+    uint32_t field = defaults.addField(AtomTable::intern(name), type);
+    if (type == osc::ParameterType::STRING) {
+        return *this;
+    }
+
+    ParameterSlot& slot = defaults.getSlot(defaults.getField(field).slot);
+    bool integer = (type == osc::ParameterType::INT || type == osc::ParameterType::BOOL);
+    size_t component = 0;
+    for (float v : value) {
+        if (component == 4) {
+            break;
+        }
+        if (integer) {
+            slot.i[component] = static_cast<int32_t>(v);
+        } else {
+            slot.f[component] = v;
+        }
+        component++;
+    }
+    return *this;
+}
+
+NodeKind& NodeKind::addParameter(const std::string& name, const std::string& value) {
+    uint32_t field = defaults.addField(AtomTable::intern(name), osc::ParameterType::STRING);
+    defaults.getString(defaults.getField(field).slot) = value;
+    return *this;
+}
+
+// KindNode implementation
+KindNode::KindNode(int id, const std::string& name, const NodeKind& kind)
+    : Node(id, name, kind.category, kind.type_id), kind_(kind) {
+    parameters_ = kind.defaults;
+    setTimeDependent(kind.time_dependent);
+}
+
+void KindNode::process() {
+    if (kind_.evaluate) {
+        kind_.evaluate(*this);
+    }
+}
+
+// NodeRegistry implementation
+NodeKind& NodeRegistry::registerKind(const std::string& type, osc::NodeType category) {
+    Atom type_id = AtomTable::intern(type);
+    if (type_id >= kind_by_atom_.size()) {
+        kind_by_atom_.resize(type_id + 1, -1);
+    }
+
+    // Replacing keeps the address, so existing references stay valid
+    if (kind_by_atom_[type_id] < 0) {
+        kind_by_atom_[type_id] = static_cast<int32_t>(kinds_.size());
+        kinds_.push_back(std::make_unique<NodeKind>());
+    }
+    NodeKind& kind = *kinds_[kind_by_atom_[type_id]];
+    kind = NodeKind();
+    kind.type_id = type_id;
+    kind.category = category;
+    return kind;
+}
+
+std::shared_ptr<Node> NodeRegistry::createNode(const NodeKind& kind, int id, const std::string& name) const {
+    return std::make_shared<KindNode>(id, name, kind);
+}
+
+std::shared_ptr<Node> NodeRegistry::createNode(int id, const std::string& name, const std::string& type) const {
+    const NodeKind* kind = findKind(type);
+    if (kind) {
+        return createNode(*kind, id, name);
+    }
+    return std::make_shared<GenericNode>(id, name, type);
+}
+
+NodeGraph::NodeFactory NodeRegistry::getFactory() const {
+    return [this](int id, const std::string& name, const std::string& type) {
+        return createNode(id, name, type);
+    };
+}
+
+void registerBuiltinNodeKinds(NodeRegistry& registry) {
+    using osc::NodeType;
+    using osc::ParameterType;
+
+    NodeKind& color = registry.registerKind("color", NodeType::SOURCE);
+    color.addParameter("color", ParameterType::COLOR, {1.0f, 1.0f, 1.0f, 1.0f})
+         .addOutput("color", ParameterType::VEC4);
+    color.glsl =
+        "vec4 node_color(vec4 color) {\n"
+        "    return color;\n"
+        "}\n";
+
+    NodeKind& texture = registry.registerKind("texture", NodeType::SOURCE);
+    texture.addParameter("path", std::string())
+           .addParameter("scale", ParameterType::VEC2, {1.0f, 1.0f})
+           .addParameter("offset", ParameterType::VEC2)
+           .addInput("uv", ParameterType::VEC2)
+           .addOutput("color", ParameterType::VEC4);
+    texture.glsl =
+        "vec4 node_texture(sampler2D image, vec2 uv, vec2 scale, vec2 offset) {\n"
+        "    return texture(image, uv * scale + offset);\n"
+        "}\n";
+
+    // operation: 0 add, 1 subtract, 2 multiply, 3 mix by factor
+    NodeKind& math = registry.registerKind("math", NodeType::EFFECT);
+    math.addParameter("operation", ParameterType::INT, {0.0f})
+        .addParameter("factor", ParameterType::FLOAT, {0.5f})
+        .addInput("a", ParameterType::VEC4)
+        .addInput("b", ParameterType::VEC4)
+        .addOutput("result", ParameterType::VEC4);
+    math.glsl =
+        "vec4 node_math(vec4 a, vec4 b, int operation, float factor) {\n"
+        "    if (operation == 1) return a - b;\n"
+        "    if (operation == 2) return a * b;\n"
+        "    if (operation == 3) return mix(a, b, factor);\n"
+        "    return a + b;\n"
+        "}\n";
+
+    // Control kinds, evaluated on the CPU in batches
+    NodeKind& lfo = registry.registerKind("lfo", NodeType::GENERATOR);
+    lfo.addParameter("frequency", ParameterType::FLOAT, {1.0f})
+       .addParameter("amplitude", ParameterType::FLOAT, {1.0f})
+       .addParameter("offset", ParameterType::FLOAT)
+       .addParameter("phase", ParameterType::FLOAT)
+       .addParameter("shape", ParameterType::INT)
+       .addOutput("value", ParameterType::FLOAT);
+    lfo.batch_kernel = lfoKernel;
+    lfo.time_dependent = true;
+
+    NodeKind& remap = registry.registerKind("remap", NodeType::EFFECT);
+    remap.addParameter("scale", ParameterType::FLOAT, {1.0f})
+         .addParameter("offset", ParameterType::FLOAT)
+         .addInput("in", ParameterType::FLOAT)
+         .addOutput("value", ParameterType::FLOAT);
+    remap.batch_kernel = remapKernel;
+
+    NodeKind& output = registry.registerKind("output", NodeType::OUTPUT);
+    output.addInput("color", ParameterType::VEC4);
+    output.glsl =
+        "vec4 node_output(vec4 color) {\n"
+        "    return color;\n"
+        "}\n";
+}
+
+} // namespace gfx
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "NodeGraph.h"
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+// Input or output of a node kind
+struct NodePort {
+    Atom name;
+    osc::ParameterType type;
+};
+
+// Columnar view of a run of nodes of one kind, passed to batch kernels (see
+// NodeBatchProcessor). Every column holds one float per node; vector values
+// take one column per component and ints and bools are converted to float.
+// Parameter columns follow the kind's default fields, skipping strings;
+// input and output columns follow its ports.
+struct BatchView {
+    size_t count;
+    float time;                         // Seconds since the engine started
+    const float* const* parameters;
+    const float* const* inputs;         // Upstream outputs; 0 if unconnected
+    float* const* outputs;
+};
+
+// Evaluates every node of a BatchView. Kernels must only depend on the
+// view, since nodes that did not change may be evaluated again.
+using BatchKernel = void (*)(const BatchView& batch);
+
+// Description of one kind of node: its ports, parameters with their default
+// values, shader code and optional CPU work. Kinds are identified by their
+// interned type name, which is also what Node::getTypeId() returns for the
+// nodes created from them.
+struct NodeKind {
+    Atom type_id;
+    osc::NodeType category;
+    std::vector<NodePort> inputs;
+    std::vector<NodePort> outputs;
+
+    // Parameter schema and default values. Every node of this kind starts
+    // as a copy, sharing the schema, so setting a parameter never has to
+    // add a field.
+    ParameterBlock defaults;
+
+    // GLSL function implementing the node, named node_<type name>. Numeric
+    // parameters are uniforms named u_<position>_<parameter name> (see
+    // Pipeline). Empty for kinds evaluated on the CPU only.
+    std::string glsl;
+
+    // CPU work run from Node::process(), under the same rules; may be empty
+    std::function<void(Node&)> evaluate;
+
+    // CPU work for all nodes of this kind at once. Where the engine runs a
+    // NodeBatchProcessor, nodes of kinds with a kernel are evaluated by it
+    // instead of through process().
+    BatchKernel batch_kernel = nullptr;
+    bool time_dependent = false;
+
+    // Declaration helpers, chainable. Numeric defaults list the components
+    // of the value (ints and bools are converted); missing ones are zero.
+    NodeKind& addInput(const std::string& name, osc::ParameterType type);
+    NodeKind& addOutput(const std::string& name, osc::ParameterType type);
+    NodeKind& addParameter(const std::string& name, osc::ParameterType type,
+                           std::initializer_list<float> value = {});
+    NodeKind& addParameter(const std::string& name, const std::string& value);
+
+    const std::string& getTypeName() const { return AtomTable::name(type_id); }
+};
+
+// Node created from a registered kind
+class KindNode : public Node {
+public:
+    KindNode(int id, const std::string& name, const NodeKind& kind);
+
+    const NodeKind& getKind() const { return kind_; }
+    void process() override;
+
+private:
+    const NodeKind& kind_;
+};
+
+// Table of node kinds. Kinds are registered at startup and must not change
+// once nodes are created from them; after that the registry is read-only
+// and may be used from several threads. Lookups by type ID are a single
+// table index.
+class NodeRegistry {
+public:
+    // Add a kind, or replace the one with the same name; fill in the
+    // returned description before creating nodes of that kind
+    NodeKind& registerKind(const std::string& type, osc::NodeType category);
+
+    const NodeKind* findKind(Atom type_id) const {
+        return (type_id < kind_by_atom_.size() && kind_by_atom_[type_id] >= 0)
+            ? kinds_[kind_by_atom_[type_id]].get() : nullptr;
+    }
+    const NodeKind* findKind(const std::string& type) const { return findKind(AtomTable::find(type)); }
+    size_t getKindCount() const { return kinds_.size(); }
+    const NodeKind& getKindAt(size_t index) const { return *kinds_[index]; }
+
+    // Create a node of a registered kind. The string overload falls back to
+    // a GenericNode for unknown types, so graphs using them still load.
+    std::shared_ptr<Node> createNode(const NodeKind& kind, int id, const std::string& name) const;
+    std::shared_ptr<Node> createNode(int id, const std::string& name, const std::string& type) const;
+
+    // Factory for NodeGraph::setNodeFactory; the registry must outlive the graph
+    NodeGraph::NodeFactory getFactory() const;
+
+private:
+    std::vector<std::unique_ptr<NodeKind>> kinds_;   // Stable addresses for KindNode
+    std::vector<int32_t> kind_by_atom_;              // Direct table indexed by type ID
+};
+
+// Register the node kinds offered by the node editor, plus the control
+// kinds evaluated on the CPU (lfo, remap)
+void registerBuiltinNodeKinds(NodeRegistry& registry);
+
+} // namespace gfx
@@ -0,0 +1,261 @@
+#include "NodeScheduler.h"
+#include "NodeGraph.h"
+#include <algorithm>
+
+namespace gfx {
+
+namespace {
+
+constexpr uint32_t NO_TASK = 0xFFFFFFFFu;
+constexpr size_t DEFAULT_SERIAL_THRESHOLD = 64;
+
+// Set while this thread is inside Node::process() (see isProcessing)
+thread_local bool processing = false;
+
+struct ProcessingScope {
+    ProcessingScope() { processing = true; }
+    ~ProcessingScope() { processing = false; }
+};
+
+} // namespace
+
+NodeScheduler::NodeScheduler(size_t thread_count)
+    : mode_(Mode::PARALLEL), serial_threshold_(DEFAULT_SERIAL_THRESHOLD),
+      nodes_(nullptr), pending_capacity_(0),
+      queued_(0), remaining_(0), sleeping_(0), stop_(false), failed_(false) {
+
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Queue 0 belongs to the thread calling run()
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads_.emplace_back(&NodeScheduler::workerLoop, this, i);
+    }
+}
+
+NodeScheduler::~NodeScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        stop_ = true;
+    }
+    wait_cv_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void NodeScheduler::run(const NodeGraph& graph, const std::vector<Node*>& nodes) {
+    if (nodes.empty()) {
+        return;
+    }
+
+    Mode mode = mode_;
+    if (mode == Mode::PARALLEL && (queues_.size() < 2 || nodes.size() < serial_threshold_)) {
+        mode = Mode::SERIAL;
+    }
+    if (mode == Mode::SERIAL) {
+        runSerial(nodes);
+        return;
+    }
+
+    nodes_ = &nodes;
+    buildDependencies(graph, nodes);
+    if (mode == Mode::DETERMINISTIC) {
+        runDeterministic();
+    } else {
+        runParallel();
+    }
+    nodes_ = nullptr;
+
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void NodeScheduler::buildDependencies(const NodeGraph& graph, const std::vector<Node*>& nodes) {
+    const uint32_t count = static_cast<uint32_t>(nodes.size());
+    if (pending_capacity_ < count) {
+        pending_.reset(new std::atomic<uint32_t>[count]);
+        pending_capacity_ = count;
+    }
+    if (task_of_slot_.size() < graph.getNodes().capacity()) {
+        task_of_slot_.resize(graph.getNodes().capacity(), NO_TASK);
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        pending_[i].store(0, std::memory_order_relaxed);
+        task_of_slot_[nodes[i]->getGraphHandle().index] = i;
+    }
+
+    // Only edges between nodes of this batch count; upstream nodes outside
+    // it are already up to date
+    successor_offsets_.resize(count + 1);
+    successors_.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        successor_offsets_[i] = static_cast<uint32_t>(successors_.size());
+        for (const Edge& edge : graph.getOutgoingConnections(nodes[i]->getGraphHandle())) {
+            uint32_t successor = task_of_slot_[edge.peer.index];
+            if (successor != NO_TASK) {
+                successors_.push_back(successor);
+                pending_[successor].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    successor_offsets_[count] = static_cast<uint32_t>(successors_.size());
+
+    for (Node* node : nodes) {
+        task_of_slot_[node->getGraphHandle().index] = NO_TASK;
+    }
+
+    // Roots are collected before any task runs; once workers start, counters
+    // of other nodes can drop to zero and those are queued by the workers
+    ready_.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        if (pending_[i].load(std::memory_order_relaxed) == 0) {
+            ready_.push_back(i);
+        }
+    }
+}
+
+bool NodeScheduler::isProcessing() {
+    return processing;
+}
+
+void NodeScheduler::runSerial(const std::vector<Node*>& nodes) {
+    ProcessingScope scope;
+    for (Node* node : nodes) {
+        node->process();
+    }
+}
+
+void NodeScheduler::runDeterministic() {
+    ProcessingScope scope;
+    for (size_t head = 0; head < ready_.size(); ++head) {
+        uint32_t task = ready_[head];
+        (*nodes_)[task]->process();
+        for (uint32_t s = successor_offsets_[task]; s < successor_offsets_[task + 1]; ++s) {
+            if (pending_[successors_[s]].fetch_sub(1, std::memory_order_relaxed) == 1) {
+                ready_.push_back(successors_[s]);
+            }
+        }
+    }
+}
+
+void NodeScheduler::runParallel() {
+    const uint32_t count = static_cast<uint32_t>(nodes_->size());
+    failed_.store(false, std::memory_order_relaxed);
+    remaining_.store(count, std::memory_order_release);
+
+    // Spread the roots over all queues so every thread starts with work
+    for (size_t i = 0; i < ready_.size(); ++i) {
+        push(i % queues_.size(), ready_[i]);
+    }
+
+    // The calling thread works as worker 0 until the batch is finished
+    uint32_t task;
+    while (remaining_.load(std::memory_order_acquire) > 0) {
+        if (pop(0, task)) {
+            execute(0, task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        sleeping_.fetch_add(1);
+        wait_cv_.wait(lock, [this] { return queued_.load() > 0 || remaining_.load() == 0; });
+        sleeping_.fetch_sub(1);
+    }
+}
+
+void NodeScheduler::workerLoop(size_t worker) {
+    uint32_t task;
+    while (true) {
+        if (pop(worker, task)) {
+            execute(worker, task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+        sleeping_.fetch_add(1);
+        wait_cv_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+        sleeping_.fetch_sub(1);
+        if (stop_) {
+            return;
+        }
+    }
+}
+
+void NodeScheduler::push(size_t worker, uint32_t task) {
+    {
+        WorkQueue& queue = *queues_[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+        queued_.fetch_add(1);
+    }
+
+    // queued_ is published before sleeping_ is read, and sleepers register
+    // before re-checking queued_, so a wakeup cannot be lost
+    if (sleeping_.load() > 0) {
+        { std::lock_guard<std::mutex> lock(wait_mutex_); }
+        wait_cv_.notify_one();
+    }
+}
+
+bool NodeScheduler::pop(size_t worker, uint32_t& task) {
+    // Own queue first (most recently readied node, likely cache-warm)
+    {
+        WorkQueue& queue = *queues_[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Steal the oldest task from another thread
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        WorkQueue& queue = *queues_[(worker + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void NodeScheduler::execute(size_t worker, uint32_t task) {
+    if (!failed_.load(std::memory_order_relaxed)) {
+        try {
+            ProcessingScope scope;
+            (*nodes_)[task]->process();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+            failed_.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // Release successors even after a failure so the batch still drains
+    for (uint32_t s = successor_offsets_[task]; s < successor_offsets_[task + 1]; ++s) {
+        if (pending_[successors_[s]].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            push(worker, successors_[s]);
+        }
+    }
+
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        { std::lock_guard<std::mutex> lock(wait_mutex_); }
+        wait_cv_.notify_all();
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gfx {
+
+class Node;
+class NodeGraph;
+
+// Runs Node::process() for a batch of nodes on a work-stealing thread pool.
+// Each node waits on an atomic counter of its unfinished upstream nodes in
+// the batch and is queued as soon as that counter reaches zero, so
+// independent branches run concurrently without per-level barriers.
+//
+// process() implementations run on pool threads in parallel mode. They may
+// read the graph and keep results in their own members, but must not edit
+// the graph or any parameter, their own included: those edits mark nodes
+// dirty and log them through queues shared by the whole graph. Values meant
+// for other nodes are written after the run, on the calling thread (see
+// NodeBatchProcessor). Debug builds assert this in every mode.
+class NodeScheduler {
+public:
+    enum class Mode {
+        PARALLEL,       // Work-stealing pool; execution order varies between runs
+        DETERMINISTIC,  // Same dependency-counter scheduling on the calling thread,
+                        // in reproducible level order (for tests and debugging)
+        SERIAL          // Plain loop over the given order
+    };
+
+    // thread_count includes the calling thread; 0 uses all hardware threads
+    explicit NodeScheduler(size_t thread_count = 0);
+    ~NodeScheduler();
+
+    NodeScheduler(const NodeScheduler&) = delete;
+    NodeScheduler& operator=(const NodeScheduler&) = delete;
+
+    void setMode(Mode mode) { mode_ = mode; }
+    Mode getMode() const { return mode_; }
+
+    // Batches smaller than this run serially; dispatch would cost more than it saves
+    void setSerialThreshold(size_t node_count) { serial_threshold_ = node_count; }
+    size_t getSerialThreshold() const { return serial_threshold_; }
+
+    size_t getThreadCount() const { return queues_.size(); }
+
+    // True while the calling thread runs Node::process() for a scheduler
+    static bool isProcessing();
+
+    // Process nodes (a topologically ordered subset of graph, as returned by
+    // NodeGraph::collectDirtyNodes). Blocks until all nodes are done. The
+    // first exception thrown by a process() call is rethrown here; nodes not
+    // yet started when it was thrown are skipped.
+    void run(const NodeGraph& graph, const std::vector<Node*>& nodes);
+
+private:
+    // Per-thread task deque. The owner pushes and pops at the back; idle
+    // threads steal from the front.
+    // Deque blocks come from a pool, so a warmed-up queue stops allocating.
+    // Not a FrameArena: blocks are freed out of order and by other threads
+    // (under the mutex).
+    struct alignas(64) WorkQueue {
+        std::mutex mutex;
+        std::pmr::unsynchronized_pool_resource pool;
+        std::pmr::deque<uint32_t> tasks{&pool};
+    };
+
+    void buildDependencies(const NodeGraph& graph, const std::vector<Node*>& nodes);
+    void runSerial(const std::vector<Node*>& nodes);
+    void runDeterministic();
+    void runParallel();
+
+    void workerLoop(size_t worker);
+    void push(size_t worker, uint32_t task);
+    bool pop(size_t worker, uint32_t& task);
+    void execute(size_t worker, uint32_t task);
+
+    Mode mode_;
+    size_t serial_threshold_;
+
+    // Current batch: dependency counts and successor lists in CSR form
+    const std::vector<Node*>* nodes_;
+    std::unique_ptr<std::atomic<uint32_t>[]> pending_;
+    size_t pending_capacity_;
+    std::vector<uint32_t> successor_offsets_;
+    std::vector<uint32_t> successors_;
+    std::vector<uint32_t> task_of_slot_;   // Node slot index -> task index, scratch
+    std::vector<uint32_t> ready_;          // Roots; deterministic mode appends to it as a FIFO
+
+    // Thread pool
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+    std::atomic<size_t> queued_;           // Tasks sitting in any queue
+    std::atomic<size_t> remaining_;        // Tasks not yet finished in this batch
+    std::atomic<size_t> sleeping_;
+    bool stop_;
+
+    std::atomic<bool> failed_;             // A process() call threw; skip the rest
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
+
+} // namespace gfx
@@ -0,0 +1,88 @@
+#include "ParameterBlock.h"
+#include <cmath>
+#include <cstring>
+
+namespace gfx {
+
+uint32_t parameterComponents(osc::ParameterType type) {
+    switch (type) {
+        case osc::ParameterType::STRING:
+            return 0;
+        case osc::ParameterType::VEC2:
+            return 2;
+        case osc::ParameterType::VEC3:
+            return 3;
+        case osc::ParameterType::VEC4:
+        case osc::ParameterType::COLOR:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+bool parameterInt(float value, int32_t& out) {
+    if (std::isnan(value)) {
+        return false;
+    }
+    // -2^31 and 2^31 are exact floats; INT32_MAX is not
+    if (value >= 2147483648.0f) {
+        out = INT32_MAX;
+    } else if (value < -2147483648.0f) {
+        out = INT32_MIN;
+    } else {
+        out = static_cast<int32_t>(value);
+    }
+    return true;
+}
+
+// ParameterSchema implementation
+uint32_t ParameterSchema::addField(Atom atom, osc::ParameterType type) {
+    int existing = findField(atom);
+    if (existing >= 0) {
+        return static_cast<uint32_t>(existing);
+    }
+    
+    uint32_t slot = (type == osc::ParameterType::STRING) ? string_count_++ : slot_count_++;
+    uint32_t index = static_cast<uint32_t>(fields_.size());
+    fields_.push_back({atom, type, slot});
+    
+    if (atom >= field_by_atom_.size()) {
+        field_by_atom_.resize(atom + 1, -1);
+    }
+    field_by_atom_[atom] = static_cast<int32_t>(index);
+    return index;
+}
+
+// ParameterBlock implementation
+ParameterBlock::ParameterBlock() : ParameterBlock(std::make_shared<ParameterSchema>()) {
+}
+
+ParameterBlock::ParameterBlock(std::shared_ptr<const ParameterSchema> schema)
+    : schema_(std::move(schema)),
+      slots_(schema_->getSlotCount(), ParameterSlot{}),
+      strings_(schema_->getStringCount()) {
+}
+
+uint32_t ParameterBlock::addField(Atom atom, osc::ParameterType type) {
+    int existing = schema_->findField(atom);
+    if (existing >= 0) {
+        return static_cast<uint32_t>(existing);
+    }
+    
+    // Copy-on-write: other blocks may share this schema. A schema only this
+    // block holds is extended in place (schemas are always created mutable).
+    if (schema_.use_count() > 1) {
+        schema_ = std::make_shared<ParameterSchema>(*schema_);
+    }
+    uint32_t index = std::const_pointer_cast<ParameterSchema>(schema_)->addField(atom, type);
+    
+    slots_.resize(schema_->getSlotCount(), ParameterSlot{});
+    strings_.resize(schema_->getStringCount());
+    return index;
+}
+
+void ParameterBlock::copyTo(void* destination) const {
+    std::memcpy(destination, slots_.data(), byteSize());
+}
+
+} // namespace gfx
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Atom.h"
+#include "../osc/OSCMessages.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+// One numeric parameter value, laid out like a std140 vec4. Scalars use the
+// first component; ints and bools are stored as 32-bit integers.
+struct alignas(16) ParameterSlot {
+    union {
+        float f[4];
+        int32_t i[4];
+    };
+};
+
+// Number of values a parameter of this type keeps in its slot (0 for strings)
+uint32_t parameterComponents(osc::ParameterType type);
+
+// Float to the value an INT parameter stores: truncated like a cast, but
+// clamped to the int32 range rather than overflowing. False for NaN.
+bool parameterInt(float value, int32_t& out);
+
+// Describes the parameters of a node: their atoms, types and where each
+// value lives in the block. Schemas are shared between nodes with the same
+// layout and are treated as immutable once shared.
+class ParameterSchema {
+public:
+    struct Field {
+        Atom atom;
+        osc::ParameterType type;
+        uint32_t slot;  // Index into the numeric slots, or into the string table
+    };
+    
+    // Append a field; returns its index (or the existing index for a known atom)
+    uint32_t addField(Atom atom, osc::ParameterType type);
+    
+    // O(1) lookup; returns -1 if the atom is not part of this schema
+    int findField(Atom atom) const {
+        return (atom < field_by_atom_.size()) ? field_by_atom_[atom] : -1;
+    }
+    
+    size_t getFieldCount() const { return fields_.size(); }
+    const Field& getField(size_t index) const { return fields_[index]; }
+    uint32_t getSlotCount() const { return slot_count_; }
+    uint32_t getStringCount() const { return string_count_; }
+    
+private:
+    std::vector<Field> fields_;
+    std::vector<int32_t> field_by_atom_;  // Direct table indexed by atom
+    uint32_t slot_count_ = 0;
+    uint32_t string_count_ = 0;
+};
+
+// Packed parameter values for one node. Numeric values are contiguous and
+// 16-byte aligned so the whole block can be copied into a uniform buffer
+// with a single memcpy; strings are kept out of line.
+class ParameterBlock {
+public:
+    // The schema must have been created as a (non-const) ParameterSchema;
+    // blocks only share it read-only
+    ParameterBlock();
+    explicit ParameterBlock(std::shared_ptr<const ParameterSchema> schema);
+    
+    // Add a parameter, copying the schema first if it is shared
+    uint32_t addField(Atom atom, osc::ParameterType type);
+    
+    int findField(Atom atom) const { return schema_->findField(atom); }
+    size_t getFieldCount() const { return schema_->getFieldCount(); }
+    const ParameterSchema::Field& getField(size_t index) const { return schema_->getField(index); }
+    const std::shared_ptr<const ParameterSchema>& getSchema() const { return schema_; }
+    
+    ParameterSlot& getSlot(uint32_t slot) { return slots_[slot]; }
+    const ParameterSlot& getSlot(uint32_t slot) const { return slots_[slot]; }
+    std::string& getString(uint32_t index) { return strings_[index]; }
+    const std::string& getString(uint32_t index) const { return strings_[index]; }
+    
+    // Raw numeric storage for bulk copies (e.g. uniform buffer uploads)
+    const void* data() const { return slots_.data(); }
+    size_t byteSize() const { return slots_.size() * sizeof(ParameterSlot); }
+    void copyTo(void* destination) const;
+    
+private:
+    std::shared_ptr<const ParameterSchema> schema_;
+    std::vector<ParameterSlot> slots_;
+    std::vector<std::string> strings_;
+};
+
+} // namespace gfx
@@ -0,0 +1,72 @@
+#include "ParameterCoalescer.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cstring>
+
+namespace gfx {
+
+void ParameterCoalescer::set(int node_id, Atom parameter, const float* values, int count) {
+    Update& update = slot(node_id, parameter);
+    update.kind = Kind::FLOATS;
+    update.count = std::min(count, 4);
+    std::memcpy(update.values, values, update.count * sizeof(float));
+}
+
+void ParameterCoalescer::set(int node_id, Atom parameter, int value) {
+    Update& update = slot(node_id, parameter);
+    update.kind = Kind::INT;
+    update.int_value = value;
+}
+
+void ParameterCoalescer::set(int node_id, Atom parameter, const char* text) {
+    Update& update = slot(node_id, parameter);
+    update.kind = Kind::STRING;
+    update.text.assign(text);
+}
+
+void ParameterCoalescer::clear() {
+    if (count_ > 0) {
+        std::fill(index_.begin(), index_.end(), 0);
+    }
+    count_ = 0;
+    received_ = 0;
+}
+
+ParameterCoalescer::Update& ParameterCoalescer::slot(int node_id, Atom parameter) {
+    received_++;
+    if (2 * (count_ + 1) > index_.size()) {
+        rebuildIndex(std::max<size_t>(16, 2 * index_.size()));
+    }
+    
+    const uint64_t k = key(node_id, parameter);
+    const size_t mask = index_.size() - 1;
+    size_t i = hashMix(k) & mask;
+    for (; index_[i] != 0; i = (i + 1) & mask) {
+        Update& update = updates_[index_[i] - 1];
+        if (key(update.node_id, update.parameter) == k) {
+            return update;
+        }
+    }
+    
+    if (count_ == updates_.size()) {
+        updates_.emplace_back();
+    }
+    index_[i] = static_cast<uint32_t>(count_ + 1);
+    Update& update = updates_[count_++];
+    update.node_id = node_id;
+    update.parameter = parameter;
+    return update;
+}
+
+void ParameterCoalescer::rebuildIndex(size_t size) {
+    index_.assign(size, 0);
+    for (size_t u = 0; u < count_; ++u) {
+        size_t i = hashMix(key(updates_[u].node_id, updates_[u].parameter)) & (size - 1);
+        while (index_[i] != 0) {
+            i = (i + 1) & (size - 1);
+        }
+        index_[i] = static_cast<uint32_t>(u + 1);
+    }
+}
+
+} // namespace gfx
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Atom.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+// Parameter writes received between two flushes, keeping only the last
+// value written to each (node, parameter): a fader sending hundreds of
+// updates per frame costs one write. Updates keep the order in which their
+// key was first written. The owner flushes them before anything whose
+// outcome depends on parameter values (structural edits, saving) and once
+// per frame.
+//
+// Entries, their string buffers and the key table keep their capacity
+// across clear(), so steady streaming does not allocate.
+class ParameterCoalescer {
+public:
+    enum class Kind : uint8_t {
+        FLOATS,     // values[0, count)
+        INT,        // int_value
+        STRING      // text, parsed by the parameter
+    };
+    
+    struct Update {
+        int node_id = 0;
+        Atom parameter = INVALID_ATOM;
+        Kind kind = Kind::FLOATS;
+        int count = 0;
+        float values[4] = {};
+        int int_value = 0;
+        std::string text;
+    };
+    
+    ParameterCoalescer() = default;
+    
+    // Record a write, replacing an earlier one to the same parameter
+    void set(int node_id, Atom parameter, const float* values, int count);
+    void set(int node_id, Atom parameter, int value);
+    void set(int node_id, Atom parameter, const char* text);
+    
+    // Pending updates in first-write order, until clear()
+    const Update* begin() const { return updates_.data(); }
+    const Update* end() const { return updates_.data() + count_; }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    
+    // Writes recorded since the last clear(), including replaced ones
+    size_t getReceivedCount() const { return received_; }
+    
+    void clear();
+    
+private:
+    Update& slot(int node_id, Atom parameter);
+    void rebuildIndex(size_t size);
+    
+    static uint64_t key(int node_id, Atom parameter) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(node_id)) << 32) | parameter;
+    }
+    
+    std::vector<Update> updates_;       // The first count_ are pending
+    size_t count_ = 0;
+    size_t received_ = 0;
+    
+    // Open addressing over the pending keys: index into updates_ plus one,
+    // 0 for empty; at most half the slots are used
+    std::vector<uint32_t> index_;
+};
+
+} // namespace gfx
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace gfx {
+
+// Sparse array with structural sharing: a 32-way trie where set() copies
+// only the path from the root to the changed element, so copies of the array
+// share everything else. Copying an array is O(1) and a write is
+// O(log32 n), which makes it suitable for publishing immutable versions of
+// large tables where only a few entries change at a time.
+//
+// set() takes an edit token. Trie nodes created under the same token belong
+// to the array being built and are updated in place by later writes with
+// that token, so a batch of writes copies each shared path at most once.
+// Use a fresh token for every batch and stop writing to an array once it is
+// shared with readers.
+template <typename T>
+class PersistentArray {
+public:
+    PersistentArray() = default;
+
+    // Value at index, or a default-constructed T for unset entries
+    const T& get(size_t index) const {
+        if (!root_ || index >= capacity()) {
+            return empty();
+        }
+        const TrieNode* node = root_.get();
+        for (unsigned level = depth_; level > 0; --level) {
+            node = static_cast<const Inner*>(node)->children[(index >> (level * BITS)) & MASK].get();
+            if (!node) {
+                return empty();
+            }
+        }
+        return static_cast<const Leaf*>(node)->values[index & MASK];
+    }
+
+    void set(size_t index, T value, uint64_t edit) {
+        while (index >= capacity()) {
+            grow(edit);
+        }
+        root_ = setIn(root_, depth_, index, std::move(value), edit);
+    }
+
+    // Number of addressable entries before the trie needs another level
+    size_t capacity() const { return size_t(1) << ((depth_ + 1) * BITS); }
+
+private:
+    static constexpr unsigned BITS = 5;
+    static constexpr size_t WIDTH = size_t(1) << BITS;
+    static constexpr size_t MASK = WIDTH - 1;
+
+    struct TrieNode {
+        uint64_t edit = 0;    // Token of the batch that created this node
+    };
+    using NodePtr = std::shared_ptr<TrieNode>;
+
+    struct Inner : TrieNode {
+        std::array<NodePtr, WIDTH> children;
+    };
+
+    struct Leaf : TrieNode {
+        std::array<T, WIDTH> values;
+    };
+
+    static const T& empty() {
+        static const T value{};
+        return value;
+    }
+
+    // Node owned by the current edit, copying the shared one if needed
+    template <typename Kind>
+    static std::shared_ptr<Kind> editable(const NodePtr& node, uint64_t edit) {
+        if (node && node->edit == edit) {
+            return std::static_pointer_cast<Kind>(node);
+        }
+        auto copy = node ? std::make_shared<Kind>(static_cast<const Kind&>(*node)) : std::make_shared<Kind>();
+        copy->edit = edit;
+        return copy;
+    }
+
+    static NodePtr setIn(const NodePtr& node, unsigned level, size_t index, T value, uint64_t edit) {
+        if (level == 0) {
+            auto leaf = editable<Leaf>(node, edit);
+            leaf->values[index & MASK] = std::move(value);
+            return leaf;
+        }
+        auto inner = editable<Inner>(node, edit);
+        NodePtr& child = inner->children[(index >> (level * BITS)) & MASK];
+        child = setIn(child, level - 1, index, std::move(value), edit);
+        return inner;
+    }
+
+    void grow(uint64_t edit) {
+        if (root_) {
+            auto root = std::make_shared<Inner>();
+            root->edit = edit;
+            root->children[0] = std::move(root_);
+            root_ = std::move(root);
+        }
+        depth_++;
+    }
+
+    NodePtr root_;
+    unsigned depth_ = 0;    // Levels of inner nodes above the leaves
+};
+
+} // namespace gfx
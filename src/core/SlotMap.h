@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace gfx {
+
+// Generational handle into a SlotMap<T>. The generation is bumped every time
+// a slot is freed, so a handle to an erased element never resolves again even
+// after its slot has been reused.
+template <typename T>
+struct SlotHandle {
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool isValid() const { return index != INVALID_INDEX; }
+    uint64_t key() const { return (static_cast<uint64_t>(generation) << 32) | index; }
+
+    bool operator==(const SlotHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+    bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// Contiguous storage with O(1) insert, erase and lookup through generational
+// handles. Values are kept densely packed; erase moves the last value into
+// the hole, so iteration order is insertion order apart from erased slots.
+template <typename T>
+class SlotMap {
+public:
+    using Handle = SlotHandle<T>;
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    Handle insert(T value) {
+        uint32_t slot_index;
+        if (free_head_ != Handle::INVALID_INDEX) {
+            slot_index = free_head_;
+            free_head_ = slots_[slot_index].dense;
+        } else {
+            slot_index = static_cast<uint32_t>(slots_.size());
+            slots_.push_back({0, 0});
+        }
+
+        slots_[slot_index].dense = static_cast<uint32_t>(values_.size());
+        values_.push_back(std::move(value));
+        dense_to_slot_.push_back(slot_index);
+        return {slot_index, slots_[slot_index].generation};
+    }
+
+    bool erase(Handle handle) {
+        if (!contains(handle)) {
+            return false;
+        }
+
+        uint32_t dense = slots_[handle.index].dense;
+        uint32_t last = static_cast<uint32_t>(values_.size() - 1);
+        if (dense != last) {
+            values_[dense] = std::move(values_[last]);
+            dense_to_slot_[dense] = dense_to_slot_[last];
+            slots_[dense_to_slot_[dense]].dense = dense;
+        }
+        values_.pop_back();
+        dense_to_slot_.pop_back();
+
+        // Invalidate outstanding handles and push the slot on the free list
+        Slot& slot = slots_[handle.index];
+        slot.generation++;
+        slot.dense = free_head_;
+        free_head_ = handle.index;
+        return true;
+    }
+
+    bool contains(Handle handle) const {
+        return handle.index < slots_.size() &&
+               slots_[handle.index].generation == handle.generation &&
+               isLive(handle.index);
+    }
+
+    T* get(Handle handle) {
+        return contains(handle) ? &values_[slots_[handle.index].dense] : nullptr;
+    }
+
+    const T* get(Handle handle) const {
+        return contains(handle) ? &values_[slots_[handle.index].dense] : nullptr;
+    }
+
+    // Position of a live handle in the dense array (valid until the next erase)
+    size_t denseIndex(Handle handle) const { return slots_[handle.index].dense; }
+
+    // Handle of the value at a dense position
+    Handle handleAt(size_t dense_index) const {
+        uint32_t slot_index = dense_to_slot_[dense_index];
+        return {slot_index, slots_[slot_index].generation};
+    }
+
+    // Upper bound on slot indices, for callers keeping per-slot side tables
+    size_t capacity() const { return slots_.size(); }
+
+    size_t size() const { return values_.size(); }
+    bool empty() const { return values_.empty(); }
+
+    void reserve(size_t count) {
+        values_.reserve(count);
+        dense_to_slot_.reserve(count);
+        slots_.reserve(count);
+    }
+
+    void clear() {
+        // Keep generations so handles issued before clear() stay stale
+        for (uint32_t slot_index : dense_to_slot_) {
+            slots_[slot_index].generation++;
+            slots_[slot_index].dense = free_head_;
+            free_head_ = slot_index;
+        }
+        values_.clear();
+        dense_to_slot_.clear();
+    }
+
+    T& operator[](size_t dense_index) { return values_[dense_index]; }
+    const T& operator[](size_t dense_index) const { return values_[dense_index]; }
+
+    iterator begin() { return values_.begin(); }
+    iterator end() { return values_.end(); }
+    const_iterator begin() const { return values_.begin(); }
+    const_iterator end() const { return values_.end(); }
+
+private:
+    struct Slot {
+        uint32_t dense;       // Dense index while live, next free slot otherwise
+        uint32_t generation;
+    };
+
+    bool isLive(uint32_t slot_index) const {
+        uint32_t dense = slots_[slot_index].dense;
+        return dense < dense_to_slot_.size() && dense_to_slot_[dense] == slot_index;
+    }
+
+    std::vector<T> values_;
+    std::vector<uint32_t> dense_to_slot_;
+    std::vector<Slot> slots_;
+    uint32_t free_head_ = Handle::INVALID_INDEX;
+};
+
+} // namespace gfx
+
+namespace std {
+template <typename T>
+struct hash<gfx::SlotHandle<T>> {
+    size_t operator()(const gfx::SlotHandle<T>& handle) const {
+        return std::hash<uint64_t>()(handle.key());
+    }
+};
+} // namespace std
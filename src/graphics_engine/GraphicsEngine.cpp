@@ -1,19 +1,86 @@
 #include "GraphicsEngine.h"
+#include "../core/GraphSnapshot.h"
 #include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <charconv>
 #include <chrono>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <cstring>
 #include <thread>
+#include <utility>
 #include <lo/lo.h>
 
 namespace gfx {
 
+namespace {
+
+// Controllers stream parameter updates, so the queue holds a few frames of
+// them; each poll takes at most what the queue holds
+constexpr size_t OSC_QUEUE_CAPACITY = 4096;
+
+// Timed bundles held at once; more are dropped
+constexpr size_t MAX_PENDING_BUNDLES = 4096;
+
+// Sent once per coalesced parameter write, so the path is not rebuilt each time
+const std::string PARAMETER_UPDATED = "/engine/parameter/updated";
+
+// NTP timetag as 32.32 fixed point, for ordering and comparison
+uint64_t timetagValue(lo_timetag time) {
+    return (static_cast<uint64_t>(time.sec) << 32) | time.frac;
+}
+
+// Fields of the comma-separated notifications sent to the editor
+void appendField(std::pmr::string& message, int value) {
+    char digits[16];
+    message.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+}
+
+void appendField(std::pmr::string& message, const char* value) {
+    message.append(value);
+}
+
+template <typename First, typename... Rest>
+std::pmr::string formatMessage(std::pmr::memory_resource* resource, First first, Rest... rest) {
+    std::pmr::string message(resource);
+    appendField(message, first);
+    ((message.push_back(','), appendField(message, rest)), ...);
+    return message;
+}
+
+} // namespace
+
 GraphicsEngine::GraphicsEngine() 
-    : running_(false), should_render_(true), target_fps_(60.0f), frame_time_(1.0f/60.0f),
+    : applied_version_(0), render_version_(nullptr), batch_bind_count_(0), node_time_(0.0f), automation_bind_count_(0), bundle_sequence_(0), parameter_updates_received_(0), parameter_updates_applied_(0), running_(false), should_render_(true), target_fps_(60.0f), frame_time_(1.0f/60.0f),
+      steady_frame_(false), checkpoint_interval_(5.0f), graph_modified_(false),
       window_width_(800), window_height_(600) {
     
     osc_server_ = std::make_unique<OSCServer>(osc::ENGINE_PORT);
+    osc_server_->setDispatchMode(OSCServer::DispatchMode::QUEUED, OSC_QUEUE_CAPACITY);
+    osc_server_->setBatchedReceive(true);      // Where available; liblo receives otherwise
+    osc_server_->setBundleHandler([this](OSCBundle bundle) {
+        if (pending_bundles_.size() >= MAX_PENDING_BUNDLES) {
+            std::cerr << "Too many pending OSC bundles, dropping one with "
+                      << bundle.getMessageCount() << " messages" << std::endl;
+            return;
+        }
+        pending_bundles_.push_back({timetagValue(bundle.getTime()), bundle_sequence_++, std::move(bundle)});
+        std::push_heap(pending_bundles_.begin(), pending_bundles_.end(), std::greater<>());
+    });
     node_editor_client_ = std::make_unique<OSCClient>();
     code_interpreter_client_ = std::make_unique<OSCClient>();
+    registerBuiltinNodeKinds(node_registry_);
     node_graph_ = std::make_unique<NodeGraph>();
+    node_graph_->setNodeFactory(node_registry_.getFactory());
+    node_graph_->setLog(&graph_log_);
+    render_graph_ = std::make_unique<NodeGraph>();
+    render_graph_->setNodeFactory(node_registry_.getFactory());
+    render_graph_->setDeadNodePruning(true);
+    render_graph_->setScratchResource(frame_arena_.getResource());
+    batch_processor_ = std::make_unique<NodeBatchProcessor>(node_registry_);
+    scheduler_ = std::make_unique<NodeScheduler>();
 }
 
 GraphicsEngine::~GraphicsEngine() {
@@ -46,6 +113,7 @@ bool GraphicsEngine::initialize(int width, int height, const std::string& title)
     
     // Initialize pipeline
     pipeline_ = std::make_unique<Pipeline>();
+    pipeline_->setScratchResource(frame_arena_.getResource());
     if (!pipeline_->initialize(shader_manager_)) {
         std::cerr << "Failed to initialize Pipeline" << std::endl;
         return false;
@@ -93,11 +161,17 @@ void GraphicsEngine::run() {
         auto elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(
             current_time - last_frame_time).count();
         
-        // Poll window events
+        // Poll window events and OSC messages
         render_context_->pollEvents();
+        processOSCMessages();
         
         if (elapsed >= frame_time_ && should_render_) {
+            applyDueBundles();
+            flushParameterUpdates();
+            frame_stats_.parameter_updates_received = std::exchange(parameter_updates_received_, 0);
+            frame_stats_.parameter_updates_applied = std::exchange(parameter_updates_applied_, 0);
             renderFrame();
+            updateCheckpoint();
             last_frame_time = current_time;
         } else {
             // Sleep for a short time to avoid busy waiting
@@ -137,6 +211,11 @@ void GraphicsEngine::shutdown() {
         code_interpreter_client_->disconnect();
     }
     
+    // Let a checkpoint being written finish
+    if (checkpoint_write_.valid()) {
+        checkpoint_write_.wait();
+    }
+    
     // Clean up rendering resources
     pipeline_.reset();
     shader_manager_.reset();
@@ -149,36 +228,71 @@ void GraphicsEngine::shutdown() {
 }
 
 void GraphicsEngine::setupOSCHandlers() {
+    // Parameter updates are coalesced until the next frame; every other
+    // message first applies the updates received before it, so structural
+    // changes stay in order with them
+    auto ordered = [this](void (GraphicsEngine::*handler)(lo_message)) {
+        return [this, handler](const std::string& path, lo_message msg) {
+            flushParameterUpdates();
+            (this->*handler)(msg);
+        };
+    };
+    
     // Node management
     osc_server_->addHandler(osc::engine::CREATE_NODE, 
-        [this](const std::string& path, lo_message msg) { handleCreateNode(msg); });
+        ordered(&GraphicsEngine::handleCreateNode));
     
     osc_server_->addHandler(osc::engine::DELETE_NODE,
-        [this](const std::string& path, lo_message msg) { handleDeleteNode(msg); });
+        ordered(&GraphicsEngine::handleDeleteNode));
     
     osc_server_->addHandler(osc::engine::UPDATE_NODE,
-        [this](const std::string& path, lo_message msg) { handleUpdateNode(msg); });
+        ordered(&GraphicsEngine::handleUpdateNode));
     
-    osc_server_->addHandler(osc::engine::SET_PARAMETER,
-        [this](const std::string& path, lo_message msg) { handleSetParameter(msg); });
+    // Streamed at high rates, so read in place without an lo_message
+    osc_server_->addViewHandler(osc::engine::SET_PARAMETER,
+        [this](const OSCMessageView& message) { handleSetParameter(message); });
     
     // Connection management
     osc_server_->addHandler(osc::engine::CONNECT_NODES,
-        [this](const std::string& path, lo_message msg) { handleConnectNodes(msg); });
+        ordered(&GraphicsEngine::handleConnectNodes));
     
     osc_server_->addHandler(osc::engine::DISCONNECT_NODES,
-        [this](const std::string& path, lo_message msg) { handleDisconnectNodes(msg); });
+        ordered(&GraphicsEngine::handleDisconnectNodes));
+    
+    // Graph files
+    osc_server_->addHandler(osc::engine::SAVE_GRAPH,
+        ordered(&GraphicsEngine::handleSaveGraph));
+    
+    osc_server_->addHandler(osc::engine::LOAD_GRAPH,
+        ordered(&GraphicsEngine::handleLoadGraph));
+    
+    osc_server_->addHandler(osc::engine::SYNC_GRAPH,
+        ordered(&GraphicsEngine::handleSyncGraph));
+    
+    // History
+    osc_server_->addHandler(osc::engine::UNDO,
+        ordered(&GraphicsEngine::handleUndo));
+    
+    osc_server_->addHandler(osc::engine::REDO,
+        ordered(&GraphicsEngine::handleRedo));
+    
+    // Automation
+    osc_server_->addHandler(osc::engine::SET_AUTOMATION,
+        ordered(&GraphicsEngine::handleSetAutomation));
+    
+    osc_server_->addHandler(osc::engine::CLEAR_AUTOMATION,
+        ordered(&GraphicsEngine::handleClearAutomation));
     
     // Rendering
     osc_server_->addHandler(osc::engine::RENDER_FRAME,
-        [this](const std::string& path, lo_message msg) { handleRenderFrame(msg); });
+        ordered(&GraphicsEngine::handleRenderFrame));
     
     // Control
     osc_server_->addHandler(osc::engine::QUIT,
-        [this](const std::string& path, lo_message msg) { handleQuit(msg); });
+        ordered(&GraphicsEngine::handleQuit));
     
     osc_server_->addHandler(osc::common::PING,
-        [this](const std::string& path, lo_message msg) { handlePing(msg); });
+        ordered(&GraphicsEngine::handlePing));
 }
 
 void GraphicsEngine::handleCreateNode(lo_message msg) {
@@ -191,8 +305,9 @@ void GraphicsEngine::handleCreateNode(lo_message msg) {
         std::cout << "Created node: " << id << " (" << name << ", " << type << ")" << std::endl;
         
         // Notify other components
-        std::string message = std::to_string(id) + "," + std::string(name) + "," + std::string(type);
-        node_editor_client_->sendMessage(std::string("/engine/node/created"), message);
+        message_arena_.reset();
+        std::pmr::string message = formatMessage(message_arena_.getResource(), id, name, type);
+        node_editor_client_->sendMessage("/engine/node/created", message.c_str());
     }
 }
 
@@ -204,7 +319,9 @@ void GraphicsEngine::handleDeleteNode(lo_message msg) {
         std::cout << "Deleted node: " << id << std::endl;
         
         // Notify other components
-        node_editor_client_->sendMessage(std::string("/engine/node/deleted"), std::to_string(id));
+        message_arena_.reset();
+        std::pmr::string message = formatMessage(message_arena_.getResource(), id);
+        node_editor_client_->sendMessage("/engine/node/deleted", message.c_str());
     }
 }
 
@@ -213,19 +330,44 @@ void GraphicsEngine::handleUpdateNode(lo_message msg) {
     std::cout << "Handle update node (not implemented)" << std::endl;
 }
 
-void GraphicsEngine::handleSetParameter(lo_message msg) {
-    if (lo_message_get_argc(msg) >= 3) {
-        int node_id = lo_message_get_argv(msg)[0]->i;
-        const char* param_name = &lo_message_get_argv(msg)[1]->s;
-        const char* value = &lo_message_get_argv(msg)[2]->s;
-        
-        updateNodeParameter(node_id, param_name, value);
-        std::cout << "Updated parameter: node " << node_id << ", " << param_name << " = " << value << std::endl;
-        
-        // Notify other components
-        std::string message = std::to_string(node_id) + "," + std::string(param_name) + "," + std::string(value);
-        node_editor_client_->sendMessage(std::string("/engine/parameter/updated"), message);
+void GraphicsEngine::handleSetParameter(const OSCMessageView& message) {
+    int argc = message.getArgumentCount();
+    const char* types = message.getTypes();
+    if (argc < 3 || types[0] != 'i' || types[1] != 's') {
+        return;
     }
+    int node_id = message.getInt(0);
+    const char* param_name = message.getString(1);
+    
+    // Only the last value per node and parameter is written, when the
+    // updates are flushed (see flushParameterUpdates). Parameters are
+    // interned when nodes are created, so an unknown name fits no node.
+    // Typed values (f, i, ff, fff, ffff) skip string parsing. However many
+    // arrive, the editor hears back once per parameter per flush, with the
+    // value as written. They are logged, but a run of values into one
+    // parameter is a single log op and undo step (see GraphLog).
+    Atom parameter = AtomTable::find(param_name);
+    int count = argc - 2;
+    if (parameter != INVALID_ATOM) {
+        if (types[2] == 's' && count == 1) {
+            parameter_updates_.set(node_id, parameter, message.getString(2));
+            return;
+        }
+        if (count == 1 && types[2] == 'i') {
+            parameter_updates_.set(node_id, parameter, message.getInt(2));
+            return;
+        }
+        if (count <= 4 && std::strspn(types + 2, "f") == static_cast<size_t>(count)) {
+            float values[4];
+            for (int k = 0; k < count; ++k) {
+                values[k] = message.getFloat(2 + k);
+            }
+            parameter_updates_.set(node_id, parameter, values, count);
+            return;
+        }
+    }
+    std::cerr << "Invalid parameter update: node " << node_id << ", " << param_name
+              << " (" << types << ")" << std::endl;
 }
 
 void GraphicsEngine::handleConnectNodes(lo_message msg) {
@@ -235,33 +377,78 @@ void GraphicsEngine::handleConnectNodes(lo_message msg) {
         int target_id = lo_message_get_argv(msg)[2]->i;
         const char* target_input = &lo_message_get_argv(msg)[3]->s;
         
-        connectNodes(source_id, source_output, target_id, target_input);
+        ConnectionError error = connectNodes(source_id, source_output, target_id, target_input);
+        message_arena_.reset();
+        std::pmr::string message = formatMessage(message_arena_.getResource(),
+                                                 source_id, source_output, target_id, target_input);
+        if (error != ConnectionError::NONE) {
+            // Tell the editor why, so it can drop the connection it drew
+            message.push_back(',');
+            appendField(message, connectionErrorToString(error));
+            node_editor_client_->sendMessage("/engine/connection/rejected", message.c_str());
+            return;
+        }
         std::cout << "Connected nodes: " << source_id << "." << source_output 
                   << " -> " << target_id << "." << target_input << std::endl;
         
         // Notify other components
-        std::string message = std::to_string(source_id) + "," + std::string(source_output) + "," + 
-                             std::to_string(target_id) + "," + std::string(target_input);
-        node_editor_client_->sendMessage(std::string("/engine/connection/created"), message);
+        node_editor_client_->sendMessage("/engine/connection/created", message.c_str());
     }
 }
 
 void GraphicsEngine::handleDisconnectNodes(lo_message msg) {
-    if (lo_message_get_argc(msg) >= 1) {
-        int connection_id = lo_message_get_argv(msg)[0]->i;
-        
-        disconnectNodes(connection_id);
-        std::cout << "Disconnected connection: " << connection_id << std::endl;
-        
-        // Notify other components
-        node_editor_client_->sendMessage(std::string("/engine/connection/deleted"), std::to_string(connection_id));
+    // Either the engine's connection ID, or the endpoints (isis) for clients
+    // that do not know the engine's IDs
+    int argc = lo_message_get_argc(msg);
+    const char* types = lo_message_get_types(msg);
+    lo_arg** argv = lo_message_get_argv(msg);
+    int connection_id;
+    if (argc >= 4 && std::strncmp(types, "isis", 4) == 0) {
+        ConnectionHandle handle = node_graph_->findConnection(argv[0]->i, &argv[1]->s, argv[2]->i, &argv[3]->s);
+        if (!handle.isValid()) {
+            std::cerr << "No connection " << argv[0]->i << "." << &argv[1]->s << " -> "
+                      << argv[2]->i << "." << &argv[3]->s << std::endl;
+            return;
+        }
+        connection_id = node_graph_->getConnection(handle)->getId();
+    } else if (argc >= 1 && types[0] == 'i') {
+        connection_id = argv[0]->i;
+    } else {
+        return;
     }
+    
+    disconnectNodes(connection_id);
+    std::cout << "Disconnected connection: " << connection_id << std::endl;
+    
+    // Notify other components
+    message_arena_.reset();
+    std::pmr::string message = formatMessage(message_arena_.getResource(), connection_id);
+    node_editor_client_->sendMessage("/engine/connection/deleted", message.c_str());
 }
 
 void GraphicsEngine::handleRenderFrame(lo_message msg) {
     renderFrame();
 }
 
+void GraphicsEngine::handleSaveGraph(lo_message msg) {
+    if (lo_message_get_argc(msg) >= 1) {
+        const char* path = &lo_message_get_argv(msg)[0]->s;
+        if (saveGraph(path)) {
+            std::cout << "Saved graph to: " << path << std::endl;
+        }
+    }
+}
+
+void GraphicsEngine::handleLoadGraph(lo_message msg) {
+    if (lo_message_get_argc(msg) >= 1) {
+        const char* path = &lo_message_get_argv(msg)[0]->s;
+        if (loadGraph(path)) {
+            std::cout << "Loaded graph from: " << path << " (" << node_graph_->getNodes().size()
+                      << " nodes)" << std::endl;
+        }
+    }
+}
+
 void GraphicsEngine::handleQuit(lo_message msg) {
     std::cout << "Received quit message" << std::endl;
     running_ = false;
@@ -273,52 +460,315 @@ void GraphicsEngine::handlePing(lo_message msg) {
     code_interpreter_client_->sendMessage(std::string(osc::common::PONG));
 }
 
-void GraphicsEngine::createNode(int id, const std::string& name, const std::string& type) {
-    // TODO: Create actual node based on type
-    // For now, just add to the graph as a placeholder
-    osc::NodeType node_type = osc::stringToNodeType(type);
-    
-    // Create a simple node (this would be factory-based in a real implementation)
-    class SimpleNode : public Node {
-    public:
-        SimpleNode(int id, const std::string& name, osc::NodeType type) 
-            : Node(id, name, type) {}
-        void process() override {
-            // Simple processing placeholder
-        }
-    };
+void GraphicsEngine::handleUndo(lo_message msg) {
+    if (undo()) {
+        std::cout << "Undo (" << graph_log_.getCursor() << " ops)" << std::endl;
+        sendGraphSync();
+    }
+}
+
+void GraphicsEngine::handleRedo(lo_message msg) {
+    if (redo()) {
+        std::cout << "Redo (" << graph_log_.getCursor() << " ops)" << std::endl;
+        sendGraphSync();
+    }
+}
+
+void GraphicsEngine::handleSyncGraph(lo_message msg) {
+    sendGraphSync();
+}
+
+void GraphicsEngine::handleSetAutomation(lo_message msg) {
+    int argc = lo_message_get_argc(msg);
+    const char* types = lo_message_get_types(msg);
+    if (argc < 5 || std::strncmp(types, "isiib", 5) != 0) {
+        std::cerr << "Invalid automation message (" << types << ")" << std::endl;
+        return;
+    }
+    lo_arg** argv = lo_message_get_argv(msg);
+    int node_id = argv[0]->i;
+    const char* param_name = &argv[1]->s;
+    int component = argv[2]->i;
+    bool loop = (argv[3]->i & 1) != 0;
+    
+    // Keys are packed as time, value, control1, control2 (float32) and
+    // interpolation (int32) in host byte order
+    constexpr size_t KEYFRAME_SIZE = 5 * sizeof(float);
+    lo_blob blob = reinterpret_cast<lo_blob>(argv[4]);
+    const char* data = static_cast<const char*>(lo_blob_dataptr(blob));
+    size_t size = lo_blob_datasize(blob);
+    if (component < 0 || size % KEYFRAME_SIZE != 0) {
+        std::cerr << "Invalid automation for node " << node_id << ", " << param_name << std::endl;
+        return;
+    }
     
-    auto node = std::make_shared<SimpleNode>(id, name, node_type);
-    node_graph_->addNode(node);
+    std::vector<Keyframe> keys(size / KEYFRAME_SIZE);
+    for (size_t k = 0; k < keys.size(); ++k) {
+        const char* key = data + k * KEYFRAME_SIZE;
+        int32_t interpolation;
+        std::memcpy(&keys[k].time, key, sizeof(float));
+        std::memcpy(&keys[k].value, key + 4, sizeof(float));
+        std::memcpy(&keys[k].control1, key + 8, sizeof(float));
+        std::memcpy(&keys[k].control2, key + 12, sizeof(float));
+        std::memcpy(&interpolation, key + 16, sizeof(int32_t));
+        if (interpolation < 0 || interpolation > static_cast<int32_t>(Interpolation::BEZIER)) {
+            std::cerr << "Invalid automation interpolation " << interpolation << std::endl;
+            return;
+        }
+        keys[k].interpolation = static_cast<Interpolation>(interpolation);
+    }
+    setAutomation(node_id, param_name, static_cast<uint32_t>(component), std::move(keys), loop);
+}
+
+void GraphicsEngine::handleClearAutomation(lo_message msg) {
+    int argc = lo_message_get_argc(msg);
+    const char* types = lo_message_get_types(msg);
+    lo_arg** argv = lo_message_get_argv(msg);
+    if (argc == 0) {
+        clearAutomation();
+    } else if (argc == 1 && types[0] == 'i') {
+        clearAutomation(argv[0]->i);
+    } else if (argc == 2 && types[0] == 'i' && types[1] == 's') {
+        clearAutomation(argv[0]->i, &argv[1]->s);
+    }
+}
+
+void GraphicsEngine::createNode(int id, const std::string& name, const std::string& type) {
+    if (!node_registry_.findKind(type)) {
+        std::cerr << "Unknown node type '" << type << "', creating a generic node" << std::endl;
+    }
+    node_graph_->addNode(node_registry_.createNode(id, name, type));
+    graph_publisher_.publish(*node_graph_);
 }
 
 void GraphicsEngine::deleteNode(int id) {
     node_graph_->removeNode(id);
+    graph_publisher_.publish(*node_graph_);
 }
 
 void GraphicsEngine::updateNodeParameter(int node_id, const std::string& param_name, 
                                         const std::string& value) {
     auto node = node_graph_->getNode(node_id);
     if (node) {
-        auto param = node->getParameter(param_name);
+        Parameter param = node->getParameter(param_name);
         if (param) {
-            param->fromString(value);
+            param.fromString(value);
+            graph_publisher_.publish(*node_graph_);
         }
     }
 }
 
-void GraphicsEngine::connectNodes(int source_id, const std::string& source_output,
-                                 int target_id, const std::string& target_input) {
-    // Generate a connection ID
-    static int next_connection_id = 1;
-    auto connection = std::make_shared<Connection>(next_connection_id++, 
-                                                  source_id, source_output,
-                                                  target_id, target_input);
-    node_graph_->addConnection(connection);
+bool GraphicsEngine::setNodeParameter(int node_id, const std::string& param_name,
+                                      const float* values, int count) {
+    Node* node = node_graph_->getNode(node_id);
+    if (!node || !node->getParameter(param_name).assign(values, count)) {
+        return false;
+    }
+    graph_publisher_.publish(*node_graph_);
+    return true;
+}
+
+bool GraphicsEngine::setNodeParameter(int node_id, const std::string& param_name, int value) {
+    Node* node = node_graph_->getNode(node_id);
+    if (!node || !node->getParameter(param_name).assign(value)) {
+        return false;
+    }
+    graph_publisher_.publish(*node_graph_);
+    return true;
+}
+
+ConnectionError GraphicsEngine::connectNodes(int source_id, const std::string& source_output,
+                                             int target_id, const std::string& target_input) {
+    // IDs come from the graph, so they never collide with loaded or
+    // replayed connections
+    Connection connection(node_graph_->allocateConnectionId(), source_id, source_output, target_id, target_input);
+    ConnectionError error = ConnectionError::NONE;
+    if (!node_graph_->addConnection(connection, &error).isValid()) {
+        std::cerr << "Cannot connect nodes " << source_id << " -> " << target_id
+                  << ": " << connectionErrorToString(error) << std::endl;
+        return error;
+    }
+    graph_publisher_.publish(*node_graph_);
+    return ConnectionError::NONE;
 }
 
 void GraphicsEngine::disconnectNodes(int connection_id) {
     node_graph_->removeConnection(connection_id);
+    graph_publisher_.publish(*node_graph_);
+}
+
+bool GraphicsEngine::saveGraph(const std::string& path) {
+    if (GraphSnapshot::isSnapshotPath(path)) {
+        return node_graph_->saveSnapshot(path);
+    }
+    
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+    node_graph_->writeJSON(file);
+    return static_cast<bool>(file);
+}
+
+bool GraphicsEngine::loadGraph(const std::string& path) {
+    // Load into a fresh graph so a failed load keeps the current scene
+    auto graph = std::make_unique<NodeGraph>();
+    graph->setNodeFactory(node_registry_.getFactory());
+    bool loaded = false;
+    if (GraphSnapshot::isSnapshotPath(path)) {
+        loaded = graph->loadSnapshot(path);
+    } else {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (file) {
+            std::string json(static_cast<size_t>(file.tellg()), '\0');
+            file.seekg(0);
+            file.read(&json[0], static_cast<std::streamsize>(json.size()));
+            loaded = file && graph->fromJSON(json);
+        }
+    }
+    if (!loaded) {
+        std::cerr << "Failed to load graph from " << path << std::endl;
+        return false;
+    }
+    
+    // The load is a single undo step that replaces the whole graph
+    node_graph_ = std::move(graph);
+    node_graph_->setLog(&graph_log_);
+    graph_log_.recordGraph(*node_graph_);
+    graph_publisher_.reset();
+    graph_publisher_.publish(*node_graph_);
+    return true;
+}
+
+bool GraphicsEngine::undo() {
+    if (!graph_log_.undo(*node_graph_)) {
+        return false;
+    }
+    graph_publisher_.publish(*node_graph_);
+    return true;
+}
+
+bool GraphicsEngine::redo() {
+    if (!graph_log_.redo(*node_graph_)) {
+        return false;
+    }
+    graph_publisher_.publish(*node_graph_);
+    return true;
+}
+
+void GraphicsEngine::sendGraphSync() {
+    // Each chunk plus its address and arguments must fit one OSC packet
+    constexpr size_t CHUNK_SIZE = osc::MAX_BLOB_CHUNK;
+    
+    std::vector<uint8_t> stream;
+    graph_log_.writeCatchUp(stream);
+    for (size_t offset = 0; offset < stream.size(); offset += CHUNK_SIZE) {
+        size_t size = std::min(CHUNK_SIZE, stream.size() - offset);
+        if (!node_editor_client_->sendMessage(std::string(osc::node_editor::GRAPH_SYNC),
+                                              static_cast<int>(stream.size()),
+                                              static_cast<int>(offset),
+                                              stream.data() + offset, size)) {
+            return;
+        }
+    }
+}
+
+void GraphicsEngine::setCheckpoint(const std::string& path, float interval_seconds) {
+    checkpoint_path_ = path;
+    checkpoint_interval_ = interval_seconds;
+    last_checkpoint_ = std::chrono::steady_clock::now();
+    
+    // Recover the graph left behind by a previous run
+    if (!checkpoint_path_.empty() && std::ifstream(checkpoint_path_).good()) {
+        graph_log_.beginStep();
+        bool restored = node_graph_->loadSnapshot(checkpoint_path_);
+        graph_log_.endStep();
+        if (restored) {
+            std::cout << "Restored " << node_graph_->getNodes().size()
+                      << " nodes from checkpoint " << checkpoint_path_ << std::endl;
+            graph_publisher_.publish(*node_graph_);
+        }
+    }
+}
+
+void GraphicsEngine::updateCheckpoint() {
+    if (checkpoint_path_.empty() || !graph_modified_ || !render_version_) {
+        return;
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<float>(now - last_checkpoint_).count() < checkpoint_interval_) {
+        return;
+    }
+    
+    // The previous checkpoint is still being written; retry next frame
+    if (checkpoint_write_.valid() &&
+        checkpoint_write_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    
+    graph_modified_ = false;
+    last_checkpoint_ = now;
+    
+    // Neither the encoding nor the file I/O runs on the render thread. The
+    // copy shares the version's node states and connections, and outlives
+    // the version once the publisher retires it.
+    auto version = std::make_shared<const GraphVersion>(*render_version_);
+    checkpoint_write_ = std::async(std::launch::async, [version, path = checkpoint_path_]() {
+        std::vector<char> data;
+        GraphSnapshot::encode(*version, data);
+        if (!GraphSnapshot::writeFile(data, path)) {
+            std::cerr << "Failed to write checkpoint " << path << std::endl;
+        }
+    });
+}
+
+void GraphicsEngine::setAutomation(int node_id, const std::string& param_name, uint32_t component,
+                                   std::vector<Keyframe> keys, bool loop) {
+    AutomationEdit edit;
+    edit.clear = false;
+    edit.target = {node_id, AtomTable::intern(param_name), component};
+    edit.keys = std::move(keys);
+    edit.loop = loop;
+    
+    std::lock_guard<std::mutex> lock(automation_mutex_);
+    pending_automation_.push_back(std::move(edit));
+}
+
+void GraphicsEngine::clearAutomation(int node_id, const std::string& param_name) {
+    AutomationEdit edit;
+    edit.clear = true;
+    edit.target = {node_id, INVALID_ATOM, 0};
+    edit.loop = false;
+    if (!param_name.empty()) {
+        edit.target.parameter = AtomTable::find(param_name);
+        if (edit.target.parameter == INVALID_ATOM) {
+            return;     // Never interned, so never automated
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(automation_mutex_);
+    pending_automation_.push_back(std::move(edit));
+}
+
+size_t GraphicsEngine::applyAutomationEdits() {
+    {
+        std::lock_guard<std::mutex> lock(automation_mutex_);
+        automation_edits_.swap(pending_automation_);
+    }
+    for (AutomationEdit& edit : automation_edits_) {
+        if (!edit.clear) {
+            automation_.setTrack(edit.target, std::move(edit.keys), edit.loop, node_time_);
+        } else if (edit.target.node_id < 0) {
+            automation_.clear();
+        } else {
+            automation_.removeTracks(edit.target.node_id, edit.target.parameter);
+        }
+    }
+    size_t count = automation_edits_.size();
+    automation_edits_.clear();
+    return count;
 }
 
 void GraphicsEngine::renderFrame() {
@@ -328,16 +778,66 @@ void GraphicsEngine::renderFrame() {
     
     // Clear the screen
     render_context_->clear();
+    uint64_t allocations = getThreadAllocationCount();
+    bool steady = true;
+    
+    // Pick up the latest graph published by the OSC handlers (lock-free) and
+    // apply only the nodes that changed since the last frame
+    const GraphVersion* version = graph_publisher_.acquire();
+    render_version_ = version;
+    if (version->getNumber() != applied_version_) {
+        render_graph_->applyVersion(*version);
+        pipeline_->updateFromGraph(*version);
+        applied_version_ = version->getNumber();
+        graph_modified_ = true;
+        steady = false;
+    }
     
-    // Process all nodes in topological order (if node graph is valid)
-    if (node_graph_) {
+    // Process only dirty nodes, their downstream cone and time-dependent
+    // nodes, skipping nodes that feed no output. Kinds with a batch kernel
+    // run first, one call per kind and level; the other nodes run in
+    // parallel where independent.
+    if (render_graph_) {
         try {
-            auto nodes = node_graph_->getTopologicalOrder();
-            for (auto& node : nodes) {
-                if (node) {
-                    node->process();
+            auto process_start = std::chrono::steady_clock::now();
+            node_time_ += frame_time_;
+            
+            // Automation writes into the render graph, so automated nodes
+            // are processed below; their uniforms are uploaded right away.
+            // After a rebind the pipeline holds version values again.
+            if (applyAutomationEdits() > 0) {
+                steady = false;
+            }
+            frame_stats_.automation_tracks = automation_.getTrackCount();
+            if (automation_.getTrackCount() > 0) {
+                automation_.evaluate(node_time_);
+                automated_nodes_.clear();
+                bool rebound = (pipeline_->getBindCount() != automation_bind_count_);
+                if (rebound) {
+                    steady = false;
                 }
+                automation_.apply(*render_graph_, automated_nodes_, rebound);
+                pipeline_->uploadParameters(automated_nodes_);
+                automation_bind_count_ = pipeline_->getBindCount();
             }
+            
+            const auto& nodes = render_graph_->collectDirtyNodes();
+            unbatched_nodes_.clear();
+            
+            // Batched outputs connected to parameters are written into them
+            // before the other nodes run and uploaded like automation
+            bool rebound = (pipeline_->getBindCount() != batch_bind_count_);
+            batch_processor_->run(*render_graph_, nodes, node_time_, unbatched_nodes_, rebound);
+            pipeline_->uploadParameters(batch_processor_->getWrittenNodes());
+            batch_bind_count_ = pipeline_->getBindCount();
+            frame_stats_.nodes_total = render_graph_->getNodes().size();
+            frame_stats_.nodes_live = render_graph_->getLiveNodeCount();
+            frame_stats_.nodes_processed = nodes.size();
+            frame_stats_.nodes_batched = batch_processor_->getBatchedNodeCount();
+            frame_stats_.kernel_calls = batch_processor_->getKernelCalls();
+            scheduler_->run(*render_graph_, unbatched_nodes_);
+            frame_stats_.process_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - process_start).count();
         } catch (const std::exception& e) {
             std::cerr << "Error processing nodes: " << e.what() << std::endl;
         }
@@ -352,6 +852,101 @@ void GraphicsEngine::renderFrame() {
     
     // Swap buffers to display the frame
     render_context_->swapBuffers();
+    frame_arena_.reset();
+    
+    // A frame without structural edits, following another one, finds every
+    // buffer warmed up and its scratch memory in the arena
+    frame_stats_.allocations = getThreadAllocationCount() - allocations;
+#ifdef GFX_COUNT_ALLOCATIONS
+    if (steady && steady_frame_ && frame_stats_.allocations > 0) {
+        std::cerr << "Steady-state frame made " << frame_stats_.allocations << " heap allocations" << std::endl;
+        assert(frame_stats_.allocations == 0);
+    }
+#endif
+    steady_frame_ = steady;
+}
+
+void GraphicsEngine::processOSCMessages() {
+    osc_server_->poll(OSC_QUEUE_CAPACITY);
+}
+
+void GraphicsEngine::applyDueBundles() {
+    lo_timetag now;
+    lo_timetag_now(&now);
+    uint64_t presentation = timetagValue(now) + static_cast<uint64_t>(frame_time_ * 4294967296.0);
+    
+    size_t applied = 0;
+    while (!pending_bundles_.empty() && pending_bundles_.front().time <= presentation) {
+        std::pop_heap(pending_bundles_.begin(), pending_bundles_.end(), std::greater<>());
+        osc_server_->dispatch(pending_bundles_.back().bundle);
+        pending_bundles_.pop_back();
+        applied++;
+    }
+    frame_stats_.bundles_applied = applied;
+    frame_stats_.bundles_pending = pending_bundles_.size();
+}
+
+void GraphicsEngine::flushParameterUpdates() {
+    if (parameter_updates_.empty()) {
+        return;
+    }
+    
+    size_t applied = 0;
+    for (const ParameterCoalescer::Update& update : parameter_updates_) {
+        Node* node = node_graph_->getNode(update.node_id);
+        Parameter param = node ? node->getParameter(update.parameter) : Parameter();
+        bool written = false;
+        if (param) {
+            switch (update.kind) {
+                case ParameterCoalescer::Kind::FLOATS:
+                    written = param.assign(update.values, update.count);
+                    break;
+                case ParameterCoalescer::Kind::INT:
+                    written = param.assign(update.int_value);
+                    break;
+                case ParameterCoalescer::Kind::STRING:
+                    try {
+                        param.fromString(update.text);
+                        written = true;
+                    } catch (const std::exception&) {
+                        // Not a value of the parameter's type
+                    }
+                    break;
+            }
+        }
+        const std::string& param_name = AtomTable::name(update.parameter);
+        if (!written) {
+            std::cerr << "Invalid parameter update: node " << update.node_id << ", " << param_name << std::endl;
+            continue;
+        }
+        applied++;
+        
+        // Notify other components, in the type the value arrived as
+        switch (update.kind) {
+            case ParameterCoalescer::Kind::FLOATS:
+                node_editor_client_->sendMessage(PARAMETER_UPDATED, update.node_id, param_name,
+                                                 update.values, update.count);
+                break;
+            case ParameterCoalescer::Kind::INT:
+                node_editor_client_->sendMessage(PARAMETER_UPDATED, update.node_id, param_name,
+                                                 update.int_value);
+                break;
+            case ParameterCoalescer::Kind::STRING:
+                std::cout << "Updated parameter: node " << update.node_id << ", " << param_name
+                          << " = " << update.text << std::endl;
+                node_editor_client_->sendMessage(PARAMETER_UPDATED, update.node_id, param_name,
+                                                 update.text);
+                break;
+        }
+    }
+    
+    // One version for all of them
+    if (applied > 0) {
+        graph_publisher_.publish(*node_graph_);
+    }
+    parameter_updates_received_ += parameter_updates_.getReceivedCount();
+    parameter_updates_applied_ += applied;
+    parameter_updates_.clear();
 }
 
 void GraphicsEngine::renderingLoop() {
@@ -7,8 +7,19 @@
 #include "../osc/OSCClient.h"
 #include "../osc/OSCMessages.h"
 #include "../core/NodeGraph.h"
+#include "../core/NodeRegistry.h"
+#include "../core/NodeBatch.h"
+#include "../core/Automation.h"
+#include "../core/ParameterCoalescer.h"
+#include "../core/GraphVersion.h"
+#include "../core/GraphLog.h"
+#include "../core/NodeScheduler.h"
+#include "../core/FrameArena.h"
 #include <memory>
 #include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
 #include <thread>
 
 namespace gfx {
@@ -47,29 +58,119 @@ public:
     void handleCreateNode(lo_message msg);
     void handleDeleteNode(lo_message msg);
     void handleUpdateNode(lo_message msg);
-    void handleSetParameter(lo_message msg);
+    void handleSetParameter(const OSCMessageView& message);
     void handleConnectNodes(lo_message msg);
     void handleDisconnectNodes(lo_message msg);
     void handleRenderFrame(lo_message msg);
+    void handleSaveGraph(lo_message msg);
+    void handleLoadGraph(lo_message msg);
     void handleQuit(lo_message msg);
     void handlePing(lo_message msg);
+    void handleUndo(lo_message msg);
+    void handleRedo(lo_message msg);
+    void handleSyncGraph(lo_message msg);
+    void handleSetAutomation(lo_message msg);
+    void handleClearAutomation(lo_message msg);
     
-    // Node management
+    // Node management. Graph edits run in OSC handlers, polled by the main
+    // loop between frames, and reach the render loop as published graph
+    // versions. Nodes are created from the
+    // node registry, with their kind's parameters already in place.
     void createNode(int id, const std::string& name, const std::string& type);
     void deleteNode(int id);
     void updateNodeParameter(int node_id, const std::string& param_name, 
                            const std::string& value);
     
-    // Connection management
-    void connectNodes(int source_id, const std::string& source_output,
-                     int target_id, const std::string& target_input);
+    /**
+     * @brief Write typed parameter values without string formatting or parsing
+     * 
+     * Used by /engine/node/param/set messages with f, i, ff, fff or ffff
+     * value arguments.
+     * 
+     * @return false if the node or parameter does not exist or the values do not fit its type
+     */
+    bool setNodeParameter(int node_id, const std::string& param_name, const float* values, int count);
+    bool setNodeParameter(int node_id, const std::string& param_name, int value);
+    
+    // Connection management. Connections that would close a cycle are rejected.
+    ConnectionError connectNodes(int source_id, const std::string& source_output,
+                                 int target_id, const std::string& target_input);
     void disconnectNodes(int connection_id);
     
+    // Graph files (binary snapshot for .gfxg, JSON otherwise)
+    bool saveGraph(const std::string& path);
+    bool loadGraph(const std::string& path);
+    
+    /**
+     * @brief Enable periodic crash-recovery checkpoints
+     * @param path Snapshot file, restored on startup if it exists; empty disables checkpoints
+     * @param interval_seconds Minimum time between checkpoints of a modified graph
+     */
+    void setCheckpoint(const std::string& path, float interval_seconds = 5.0f);
+    
+    // Edit history. Every graph edit is recorded in the graph log; undo and
+    // redo step through it.
+    bool undo();
+    bool redo();
+    
+    /**
+     * @brief Send the current graph to the node editor as a GraphLog op stream
+     * 
+     * Lets an editor that started after the engine catch up without replaying
+     * the session. The stream goes out in /editor/graph/sync chunks.
+     */
+    void sendGraphSync();
+    
+    /**
+     * @brief Automate one component of a numeric parameter
+     * 
+     * The track is evaluated by the render loop every frame and starts at
+     * the frame that picks it up; the values are not recorded in the graph
+     * log. Replaces an existing track of the same component; no keys
+     * removes it.
+     * 
+     * @param component 0 for scalars; x, y, z, w for vectors and colors
+     * @param loop Repeat from the first to the last key
+     */
+    void setAutomation(int node_id, const std::string& param_name, uint32_t component,
+                       std::vector<Keyframe> keys, bool loop);
+    
+    /**
+     * @brief Remove automation tracks
+     * @param node_id Node whose tracks to remove; -1 removes all tracks
+     * @param param_name Parameter whose tracks to remove; empty for all of the node's
+     */
+    void clearAutomation(int node_id = -1, const std::string& param_name = std::string());
+    
     // Rendering
     void renderFrame();
     
+    /**
+     * @brief Per-frame processing statistics
+     */
+    struct FrameStats {
+        size_t nodes_total = 0;        ///< Nodes in the graph
+        size_t nodes_live = 0;         ///< Nodes that are or feed an output
+        size_t nodes_processed = 0;    ///< Nodes that needed processing this frame
+        size_t nodes_batched = 0;      ///< Of those, nodes evaluated by batch kernels
+        size_t kernel_calls = 0;       ///< Batch kernel calls (one per kind and level)
+        size_t automation_tracks = 0;  ///< Automation tracks evaluated
+        size_t bundles_applied = 0;    ///< Timed OSC bundles applied for this frame
+        size_t bundles_pending = 0;    ///< Timed OSC bundles held for later frames
+        size_t parameter_updates_received = 0; ///< Parameter messages received since the last frame
+        size_t parameter_updates_applied = 0;  ///< Parameter writes left after coalescing them
+        double process_ms = 0.0;       ///< Wall time spent evaluating nodes
+        uint64_t allocations = 0;      ///< Heap allocations made by the rendering thread (GFX_COUNT_ALLOCATIONS builds)
+    };
+    
+    /**
+     * @brief Node scheduler, e.g. to switch to deterministic or serial execution
+     */
+    NodeScheduler& getScheduler() { return *scheduler_; }
+    
     // Status
     bool isRunning() const { return running_; }
+    const FrameStats& getFrameStats() const { return frame_stats_; }
 
 private:
     /**
@@ -78,10 +179,36 @@ private:
     void setupOSCHandlers();
     
     /**
-     * @brief Process OSC messages in main loop
+     * @brief Run the handlers of OSC messages queued since the last call
+     * 
+     * The OSC server queues messages instead of handling them on its
+     * receive thread, so handlers run here, on the main loop's thread
+     * between frames. Bundles with a timetag are held instead (see
+     * applyDueBundles).
      */
     void processOSCMessages();
     
+    /**
+     * @brief Apply the held OSC bundles that are due for the next frame
+     * 
+     * A bundle is applied before the first frame presented at or after its
+     * timetag, all of its messages at once, so clients can send bundles
+     * ahead of time and keep network jitter out of tempo-synced changes.
+     * The next frame is taken to be presented one frame time from now.
+     */
+    void applyDueBundles();
+    
+    /**
+     * @brief Write the parameter updates coalesced since the last flush
+     * 
+     * Parameter messages only record the latest value per node and
+     * parameter. This writes them in the order each was first received,
+     * publishes one graph version and echoes string values to the editor.
+     * Runs before each frame and before every other engine message, so
+     * structural edits stay ordered with the updates sent before them.
+     */
+    void flushParameterUpdates();
+    
     /**
      * @brief Main rendering loop
      */
@@ -92,6 +219,44 @@ private:
      */
     void renderingLoop();
     
+    /**
+     * @brief Write a checkpoint if the graph changed and the interval elapsed
+     * 
+     * The version last applied to the render graph is copied (sharing its
+     * node states) and encoded and written on a background thread; while a
+     * write is still running no new one starts.
+     */
+    void updateCheckpoint();
+    
+    /**
+     * @brief Apply automation edits queued by OSC handlers
+     * @return Number of edits applied
+     */
+    size_t applyAutomationEdits();
+    
+    /**
+     * @brief Automation edit made by an OSC handler, applied by the render loop
+     */
+    struct AutomationEdit {
+        bool clear;                     ///< Remove tracks instead of setting one
+        Automation::Target target;      ///< Clear: node -1 for all tracks, INVALID_ATOM parameter for all of a node's
+        std::vector<Keyframe> keys;     ///< Set: keys of the track
+        bool loop;                      ///< Set: repeat the keys
+    };
+    
+    /**
+     * @brief Timed OSC bundle waiting for its frame
+     */
+    struct PendingBundle {
+        uint64_t time;                  ///< Timetag as 32.32 fixed-point NTP seconds
+        uint64_t sequence;              ///< Arrival order, for bundles with equal timetags
+        OSCBundle bundle;
+        
+        bool operator>(const PendingBundle& other) const {
+            return time != other.time ? time > other.time : sequence > other.sequence;
+        }
+    };
+    
     std::unique_ptr<RenderContext> render_context_;     ///< OpenGL context and window management
     std::shared_ptr<ShaderManager> shader_manager_;     ///< LYGIA-based shader compilation
     std::unique_ptr<Pipeline> pipeline_;                ///< Rendering pipeline management
@@ -99,12 +264,45 @@ private:
     std::unique_ptr<OSCClient> node_editor_client_;     ///< OSC client for node editor communication
     std::unique_ptr<OSCClient> code_interpreter_client_; ///< OSC client for code interpreter communication
     
-    std::unique_ptr<NodeGraph> node_graph_;             ///< Current node graph state
+    NodeRegistry node_registry_;                        ///< Node kinds; read-only after construction
+    std::unique_ptr<NodeGraph> node_graph_;             ///< Graph edited by OSC handlers
+    GraphLog graph_log_;                                ///< Edits of node_graph_, for undo and editor catch-up
+    GraphPublisher graph_publisher_;                    ///< Hands node_graph_ versions to the render loop
+    std::unique_ptr<NodeGraph> render_graph_;           ///< Render loop's copy, updated from published versions
+    uint64_t applied_version_;                          ///< Version last applied to render_graph_
+    const GraphVersion* render_version_;                ///< Version acquired this frame; valid until the next acquire()
+    std::unique_ptr<NodeBatchProcessor> batch_processor_; ///< Evaluates nodes of kinds with a batch kernel
+    std::unique_ptr<NodeScheduler> scheduler_;          ///< Runs Node::process() across cores
+    std::vector<Node*> unbatched_nodes_;                ///< Nodes left for the scheduler, reused per frame
+    uint64_t batch_bind_count_;                         ///< Pipeline bind count the batch outputs were uploaded for
+    float node_time_;                                   ///< Seconds of frames processed, passed to batch kernels
+    Automation automation_;                             ///< Parameter automation tracks (render thread)
+    std::vector<Node*> automated_nodes_;                ///< Nodes written by automation, reused per frame
+    uint64_t automation_bind_count_;                    ///< Pipeline bind count the automated values were uploaded for
+    std::mutex automation_mutex_;                       ///< Guards pending_automation_
+    std::vector<AutomationEdit> pending_automation_;    ///< Edits waiting for the next frame
+    std::vector<AutomationEdit> automation_edits_;      ///< Edits being applied, reused per frame
+    std::vector<PendingBundle> pending_bundles_;        ///< Timed OSC bundles, a min-heap on time and arrival
+    uint64_t bundle_sequence_;                          ///< Bundles received so far
+    ParameterCoalescer parameter_updates_;              ///< Last value per node and parameter since the last flush
+    size_t parameter_updates_received_;                 ///< Parameter messages received since the last frame
+    size_t parameter_updates_applied_;                  ///< Parameter writes made for them since the last frame
     std::atomic<bool> running_;                         ///< Main loop running state
     std::thread rendering_thread_;                      ///< Background rendering thread
     bool should_render_;                                  ///< Flag to control rendering
     float target_fps_;                                   ///< Target frames per second for rendering
     float frame_time_;                                   ///< Time per frame in seconds
+    FrameStats frame_stats_;                             ///< Statistics of the last rendered frame
+    FrameArena frame_arena_;                             ///< Scratch memory of the frame being rendered, reset after it
+    FrameArena message_arena_;                           ///< Scratch memory of the OSC message being handled
+    bool steady_frame_;                                  ///< Last frame applied no version, edit or rebind
+    
+    // Crash recovery
+    std::string checkpoint_path_;                        ///< Checkpoint snapshot file (empty = disabled)
+    float checkpoint_interval_;                          ///< Seconds between checkpoints
+    std::chrono::steady_clock::time_point last_checkpoint_; ///< Time of the last checkpoint
+    bool graph_modified_;                                ///< Render graph changed since the last checkpoint
+    std::future<void> checkpoint_write_;                 ///< Checkpoint file write in progress, if any
     
     // Window properties
     int window_width_;                                  ///< Current window width
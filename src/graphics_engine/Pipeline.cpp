@@ -1,18 +1,27 @@
 #include "Pipeline.h"
 #include "ShaderManager.h"
 #include <GL/glew.h>
+#include <charconv>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 
 namespace gfx {
 
 Pipeline::Pipeline()
-    : shader_program_(0)
+    : graph_version_(nullptr)
+    , shader_program_(0)
+    , program_key_(0)
     , vao_(0)
     , vbo_(0)
     , ebo_(0)
     , initialized_(false)
-    , total_time_(0.0f) {
+    , total_time_(0.0f)
+    , bind_count_(0)
+    , scratch_resource_(std::pmr::get_default_resource())
+    , time_location_(-1)
+    , delta_time_location_(-1)
+    , resolution_location_(-1) {
 }
 
 Pipeline::~Pipeline() {
@@ -54,13 +63,63 @@ void Pipeline::shutdown() {
     initialized_ = false;
 }
 
-bool Pipeline::updateFromNodeGraph(const NodeGraph& nodeGraph) {
+bool Pipeline::updateFromGraph(const GraphVersion& version) {
     if (!initialized_) {
         return false;
     }
     
-    node_graph_ = nodeGraph;
-    return generateShader();
+    graph_version_ = &version;
+    if (version.getLiveStructureHash() != program_key_) {
+        if (generateShader()) {
+            return true;
+        }
+        // Keep the old program, but its bindings must follow the new slots
+        bindUniforms();
+        return false;
+    }
+    if (version.isReset() || version.hasStructureChanged()) {
+        // Same program, but nodes may have moved to different slots
+        bindUniforms();
+        return true;
+    }
+    if (shader_program_ == 0) {
+        return true;
+    }
+    
+    // Only nodes that changed since the last version need new uniform values
+    shader_manager_->useProgram(shader_program_);
+    for (uint32_t slot : version.getChangedSlots()) {
+        const NodeState* state = version.getNode(slot);
+        if (!state || !state->live) {
+            continue;
+        }
+        if (slot >= bound_schemas_.size() || bound_schemas_[slot] != state->parameters.getSchema().get()) {
+            // New parameters may map to new uniforms
+            bindUniforms();
+            return true;
+        }
+        uploadUniforms(slot, state->parameters);
+    }
+    return true;
+}
+
+void Pipeline::uploadParameters(const std::vector<Node*>& nodes) {
+    if (shader_program_ == 0 || nodes.empty()) {
+        return;
+    }
+    
+    shader_manager_->useProgram(shader_program_);
+    for (const Node* node : nodes) {
+        auto it = slot_by_node_id_.find(node->getId());
+        if (it == slot_by_node_id_.end()) {
+            continue;
+        }
+        const ParameterBlock& parameters = node->getParameters();
+        if (bound_schemas_[it->second] != parameters.getSchema().get()) {
+            continue;
+        }
+        uploadUniforms(it->second, parameters);
+    }
 }
 
 bool Pipeline::updateFromString(const std::string& pipelineData) {
@@ -94,36 +153,6 @@ void Pipeline::render(float deltaTime) {
     glBindVertexArray(0);
 }
 
-bool Pipeline::setParameter(int nodeId, const std::string& paramName, const std::string& value) {
-    if (!initialized_) {
-        return false;
-    }
-    
-    // TODO: Update node parameter in graph and regenerate shader if needed
-    std::cout << "Setting parameter: Node " << nodeId << ", " << paramName << " = " << value << std::endl;
-    
-    // For now, just try to set as uniform if shader is active
-    if (shader_program_ != 0) {
-        try {
-            float floatValue = std::stof(value);
-            shader_manager_->setUniform(paramName, floatValue);
-            return true;
-        } catch (const std::exception& e) {
-            // Try as int
-            try {
-                int intValue = std::stoi(value);
-                shader_manager_->setUniform(paramName, intValue);
-                return true;
-            } catch (const std::exception& e) {
-                // Could not parse as number
-                return false;
-            }
-        }
-    }
-    
-    return false;
-}
-
 std::string Pipeline::getPipelineString() const {
     // TODO: Serialize current node graph to string
     return "DefaultPipeline";
@@ -141,20 +170,27 @@ bool Pipeline::generateShader() {
     // Convert node graph to pipeline string for shader generation
     std::string pipelineString = getPipelineString();
     
-    // Generate new shader
-    unsigned int newProgram = shader_manager_->compileFromPipeline(pipelineString);
+    // Programs are cached by the live nodes' structure hash, so returning to
+    // a graph seen before (undo, reloading a patch) or editing nodes that
+    // reach no output skips the compile. A failed key is not retried until
+    // the structure changes again.
+    program_key_ = graph_version_ ? graph_version_->getLiveStructureHash() : 0;
+    unsigned int newProgram = shader_manager_->compileFromPipeline(pipelineString, program_key_);
     if (newProgram == 0) {
         std::cerr << "Failed to generate shader from pipeline" << std::endl;
         return false;
     }
     
-    // Delete old shader if exists
-    if (shader_program_ != 0) {
-        shader_manager_->deleteProgram(shader_program_);
-    }
-    
+    // The old program stays in the shader manager's cache
     shader_program_ = newProgram;
-    std::cout << "Generated new shader program: " << shader_program_ << std::endl;
+    std::cout << "Using shader program " << shader_program_ << " for pipeline "
+              << std::hex << program_key_ << std::dec << std::endl;
+    
+    // Uniform locations belong to the program, so resolve them once here
+    time_location_ = glGetUniformLocation(shader_program_, "u_time");
+    delta_time_location_ = glGetUniformLocation(shader_program_, "u_deltaTime");
+    resolution_location_ = glGetUniformLocation(shader_program_, "u_resolution");
+    bindUniforms();
     return true;
 }
 
@@ -222,9 +258,106 @@ void Pipeline::updateUniforms(float deltaTime) {
     }
     
     // Update standard uniforms
-    shader_manager_->setUniform("u_time", total_time_);
-    shader_manager_->setUniform("u_deltaTime", deltaTime);
-    shader_manager_->setUniform("u_resolution", 800.0f, 600.0f); // TODO: Get actual resolution
+    if (time_location_ != -1) {
+        glUniform1f(time_location_, total_time_);
+    }
+    if (delta_time_location_ != -1) {
+        glUniform1f(delta_time_location_, deltaTime);
+    }
+    if (resolution_location_ != -1) {
+        glUniform2f(resolution_location_, 800.0f, 600.0f); // TODO: Get actual resolution
+    }
+}
+
+void Pipeline::bindUniforms() {
+    uniform_bindings_.clear();
+    binding_offsets_.clear();
+    bound_schemas_.clear();
+    slot_by_node_id_.clear();
+    bind_count_++;
+    if (shader_program_ == 0 || !graph_version_) {
+        return;
+    }
+    
+    shader_manager_->useProgram(shader_program_);
+    const size_t slot_count = graph_version_->getSlotCount();
+    binding_offsets_.resize(slot_count + 1);
+    bound_schemas_.resize(slot_count, nullptr);
+    
+    // Uniforms are named by canonical position, as the program was generated
+    const std::vector<uint32_t>& canonical = graph_version_->getCanonicalSlots();
+    std::pmr::vector<uint32_t> position_of_slot(slot_count, UINT32_MAX, scratch_resource_);
+    for (uint32_t position = 0; position < canonical.size(); ++position) {
+        position_of_slot[canonical[position]] = position;
+    }
+    
+    std::pmr::string name(scratch_resource_);
+    for (uint32_t slot = 0; slot < slot_count; ++slot) {
+        binding_offsets_[slot] = static_cast<uint32_t>(uniform_bindings_.size());
+        const NodeState* state = graph_version_->getNode(slot);
+        if (!state || position_of_slot[slot] == UINT32_MAX) {
+            continue;
+        }
+        
+        const ParameterBlock& parameters = state->parameters;
+        bound_schemas_[slot] = parameters.getSchema().get();
+        slot_by_node_id_[state->id] = slot;
+        for (size_t i = 0; i < parameters.getFieldCount(); ++i) {
+            const ParameterSchema::Field& field = parameters.getField(i);
+            if (field.type == osc::ParameterType::STRING) {
+                continue;
+            }
+            // u_<position>_<name>, built in place instead of through temporaries
+            char position[16];
+            char* position_end = std::to_chars(position, position + sizeof(position), position_of_slot[slot]).ptr;
+            const std::string& field_name = AtomTable::name(field.atom);
+            name.assign("u_", 2);
+            name.append(position, position_end);
+            name.push_back('_');
+            name.append(field_name.data(), field_name.size());
+            GLint location = glGetUniformLocation(shader_program_, name.c_str());
+            if (location != -1) {
+                uniform_bindings_.push_back({field.slot, field.type, location});
+            }
+        }
+    }
+    binding_offsets_[slot_count] = static_cast<uint32_t>(uniform_bindings_.size());
+    
+    // A new program starts with default uniform values
+    for (uint32_t slot = 0; slot < slot_count; ++slot) {
+        const NodeState* state = graph_version_->getNode(slot);
+        if (state && state->live) {
+            uploadUniforms(slot, state->parameters);
+        }
+    }
+}
+
+void Pipeline::uploadUniforms(uint32_t slot, const ParameterBlock& parameters) {
+    for (uint32_t b = binding_offsets_[slot]; b < binding_offsets_[slot + 1]; ++b) {
+        const UniformBinding& binding = uniform_bindings_[b];
+        const ParameterSlot& value = parameters.getSlot(binding.value_slot);
+        switch (binding.type) {
+            case osc::ParameterType::INT:
+            case osc::ParameterType::BOOL:
+                glUniform1iv(binding.location, 1, value.i);
+                break;
+            case osc::ParameterType::FLOAT:
+                glUniform1fv(binding.location, 1, value.f);
+                break;
+            case osc::ParameterType::VEC2:
+                glUniform2fv(binding.location, 1, value.f);
+                break;
+            case osc::ParameterType::VEC3:
+                glUniform3fv(binding.location, 1, value.f);
+                break;
+            case osc::ParameterType::VEC4:
+            case osc::ParameterType::COLOR:
+                glUniform4fv(binding.location, 1, value.f);
+                break;
+            case osc::ParameterType::STRING:
+                break;
+        }
+    }
 }
 
 } // namespace gfx
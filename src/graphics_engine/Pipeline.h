@@ -1,8 +1,11 @@
 #pragma once
 
-#include "../core/NodeGraph.h"
+#include "../core/GraphVersion.h"
 #include <string>
 #include <memory>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
 
 namespace gfx {
 
@@ -13,6 +16,18 @@ class ShaderManager;
  * 
  * Manages the graphics pipeline state, node graph processing,
  * and coordinates between OSC messages and shader generation.
+ * 
+ * Numeric node parameters are bound to uniforms named
+ * u_<position>_<parameter name> (e.g. u_3_scale), where position is the
+ * node's place in the canonical order of the live nodes (see
+ * NodeGraph::getCanonicalOrder). Unlike node IDs, positions follow from the
+ * structure alone, so a cached program fits every graph with its key.
+ * Locations are looked up once per shader program; after that, changed
+ * parameters are uploaded straight from their ParameterBlock slots.
+ * 
+ * Only live nodes (outputs and the nodes feeding them, see
+ * NodeGraph::isLive) take part: the shader is keyed by their structure and
+ * nodes outside the live set get no uniforms.
  */
 class Pipeline {
 public:
@@ -32,11 +47,47 @@ public:
     void shutdown();
     
     /**
-     * @brief Update pipeline from node graph
-     * @param nodeGraph Node graph to process
+     * @brief Update pipeline from a published graph version
+     * 
+     * Only keeps a pointer to the version; the shader is regenerated only
+     * when the structure hash of the live nodes changed (see
+     * NodeGraph::getLiveStructureHash), and compiled only if the shader manager
+     * has no program for that hash yet. Parameters of the nodes that changed
+     * in this version are uploaded to their uniforms.
+     * 
+     * @param version Latest version acquired from the GraphPublisher; must
+     *        stay alive until the next update
      * @return true if update successful, false otherwise
      */
-    bool updateFromNodeGraph(const NodeGraph& nodeGraph);
+    bool updateFromGraph(const GraphVersion& version);
+    
+    /**
+     * @brief Upload parameters changed outside of graph versions
+     * 
+     * For values written on the render thread, e.g. by automation. Nodes
+     * are matched to the current version by id; nodes whose parameter
+     * layout is not bound yet are skipped.
+     * 
+     * @param nodes Nodes whose parameters changed
+     */
+    void uploadParameters(const std::vector<Node*>& nodes);
+    
+    /**
+     * @brief Get the number of times uniforms were bound
+     * 
+     * A rebind uploads every parameter from the current version, so values
+     * set through uploadParameters() have to be uploaded again.
+     */
+    uint64_t getBindCount() const { return bind_count_; }
+    
+    /**
+     * @brief Set the memory used for temporaries while binding uniforms
+     * 
+     * E.g. the render thread's FrameArena; defaults to the heap.
+     * 
+     * @param resource Resource that outlives the current frame
+     */
+    void setScratchResource(std::pmr::memory_resource* resource) { scratch_resource_ = resource; }
     
     /**
      * @brief Update pipeline from OSC message string
@@ -51,15 +102,6 @@ public:
      */
     void render(float deltaTime);
     
-    /**
-     * @brief Set pipeline parameter
-     * @param nodeId Target node ID
-     * @param paramName Parameter name
-     * @param value Parameter value
-     * @return true if parameter set successfully, false otherwise
-     */
-    bool setParameter(int nodeId, const std::string& paramName, const std::string& value);
-    
     /**
      * @brief Get current pipeline as string representation
      * @return Pipeline data as string
@@ -73,10 +115,10 @@ public:
     bool isReady() const;
     
     /**
-     * @brief Get current node graph
-     * @return Reference to current node graph
+     * @brief Get current graph version
+     * @return Version passed to the last update, or nullptr
      */
-    const NodeGraph& getNodeGraph() const { return node_graph_; }
+    const GraphVersion* getGraphVersion() const { return graph_version_; }
 
 private:
     /**
@@ -101,12 +143,45 @@ private:
      */
     void updateUniforms(float deltaTime);
     
+    /**
+     * @brief Look up uniform locations for all node parameters of the current version
+     */
+    void bindUniforms();
+    
+    /**
+     * @brief Upload the bound parameters of one node
+     * @param slot Node slot in the current graph version
+     * @param parameters Values to upload, laid out like the bound schema
+     */
+    void uploadUniforms(uint32_t slot, const ParameterBlock& parameters);
+    
+    /**
+     * @brief Parameter bound to a uniform of the current shader program
+     */
+    struct UniformBinding {
+        uint32_t value_slot;            ///< Slot in the node's ParameterBlock
+        osc::ParameterType type;        ///< Parameter type (selects glUniform*)
+        int location;                   ///< Uniform location in shader_program_
+    };
+    
     std::shared_ptr<ShaderManager> shader_manager_;  ///< Shader manager instance
-    NodeGraph node_graph_;                           ///< Current node graph
-    unsigned int shader_program_;                    ///< Current shader program ID
+    const GraphVersion* graph_version_;              ///< Current graph version (not owned)
+    unsigned int shader_program_;                    ///< Current shader program ID (owned by the shader manager's cache)
+    uint64_t program_key_;                           ///< Live structure hash shader_program_ was generated for
     unsigned int vao_, vbo_, ebo_;                  ///< Rendering quad geometry
     bool initialized_;                               ///< Initialization state
     float total_time_;                              ///< Total elapsed time
+    
+    // Uniform cache, rebuilt when the shader program or a node's parameter layout changes
+    std::vector<UniformBinding> uniform_bindings_;   ///< Bindings grouped by node slot
+    std::vector<uint32_t> binding_offsets_;          ///< First binding per node slot (CSR)
+    std::vector<const ParameterSchema*> bound_schemas_; ///< Parameter layout each slot was bound with
+    std::unordered_map<int, uint32_t> slot_by_node_id_; ///< Version slot of each bound node
+    uint64_t bind_count_;                           ///< Number of bindUniforms() calls
+    std::pmr::memory_resource* scratch_resource_;   ///< Memory for per-frame temporaries (not owned)
+    int time_location_;                             ///< u_time location
+    int delta_time_location_;                       ///< u_deltaTime location
+    int resolution_location_;                       ///< u_resolution location
 };
 
 } // namespace gfx
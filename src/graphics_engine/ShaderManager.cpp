@@ -8,7 +8,9 @@
 namespace gfx {
 
 ShaderManager::ShaderManager()
-    : current_program_(0)
+    : program_cache_size_(16)
+    , cache_clock_(0)
+    , current_program_(0)
     , initialized_(false) {
 }
 
@@ -46,6 +48,7 @@ void ShaderManager::shutdown() {
         }
     }
     active_programs_.clear();
+    program_cache_.clear();
     
     // Clear modules cache
     modules_.clear();
@@ -67,6 +70,38 @@ GLuint ShaderManager::compileFromPipeline(const std::string& nodeGraph) {
     return compileFromSource(vertexSource, fragmentSource);
 }
 
+GLuint ShaderManager::compileFromPipeline(const std::string& nodeGraph, uint64_t key) {
+    cache_clock_++;
+    for (CachedProgram& cached : program_cache_) {
+        if (cached.key == key) {
+            cached.last_used = cache_clock_;
+            return cached.program;
+        }
+    }
+    
+    GLuint program = compileFromPipeline(nodeGraph);
+    if (program == 0) {
+        return 0;
+    }
+    
+    if (program_cache_.size() >= program_cache_size_) {
+        auto oldest = std::min_element(program_cache_.begin(), program_cache_.end(),
+            [](const CachedProgram& a, const CachedProgram& b) { return a.last_used < b.last_used; });
+        deleteProgram(oldest->program);
+    }
+    program_cache_.push_back({key, program, cache_clock_});
+    return program;
+}
+
+void ShaderManager::setProgramCacheSize(size_t programs) {
+    program_cache_size_ = std::max<size_t>(programs, 1);
+    while (program_cache_.size() > program_cache_size_) {
+        auto oldest = std::min_element(program_cache_.begin(), program_cache_.end(),
+            [](const CachedProgram& a, const CachedProgram& b) { return a.last_used < b.last_used; });
+        deleteProgram(oldest->program);
+    }
+}
+
 GLuint ShaderManager::compileFromSource(const std::string& vertexSource, const std::string& fragmentSource) {
     // Compile vertex shader
     GLuint vertexShader = compileShader(vertexSource, GL_VERTEX_SHADER);
@@ -112,6 +147,12 @@ bool ShaderManager::hotReload(GLuint programId, const std::string& nodeGraph) {
         glDeleteProgram(programId);
         *it = newProgram;
         
+        // The new program was compiled from a different pipeline, so it
+        // must not be found under the old program's key
+        program_cache_.erase(std::remove_if(program_cache_.begin(), program_cache_.end(),
+            [programId](const CachedProgram& cached) { return cached.program == programId; }),
+            program_cache_.end());
+        
         if (current_program_ == programId) {
             current_program_ = newProgram;
             glUseProgram(newProgram);
@@ -132,6 +173,10 @@ void ShaderManager::deleteProgram(GLuint programId) {
             active_programs_.erase(it);
         }
         
+        program_cache_.erase(std::remove_if(program_cache_.begin(), program_cache_.end(),
+            [programId](const CachedProgram& cached) { return cached.program == programId; }),
+            program_cache_.end());
+        
         if (current_program_ == programId) {
             current_program_ = 0;
         }
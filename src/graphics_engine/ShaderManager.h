@@ -5,6 +5,7 @@
 #include <map>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 namespace gfx {
 
@@ -38,6 +39,24 @@ public:
      */
     GLuint compileFromPipeline(const std::string& nodeGraph);
     
+    /**
+     * @brief Compile shader from node graph pipeline, reusing programs by content key
+     * 
+     * A key seen before returns its cached program without compiling. The
+     * cache owns its programs and keeps the most recently used ones.
+     * 
+     * @param nodeGraph Pipeline graph as string representation
+     * @param key Content key of the pipeline (e.g. NodeGraph::getStructureHash())
+     * @return Shader program ID, 0 if failed
+     */
+    GLuint compileFromPipeline(const std::string& nodeGraph, uint64_t key);
+    
+    /**
+     * @brief Set the number of programs kept by compileFromPipeline(nodeGraph, key)
+     * @param programs Cache capacity (at least 1)
+     */
+    void setProgramCacheSize(size_t programs);
+    
     /**
      * @brief Compile shader from GLSL source code
      * @param vertexSource Vertex shader source
@@ -150,6 +169,18 @@ private:
     std::string lygia_path_;                        ///< Path to LYGIA library
     std::map<std::string, std::string> modules_;    ///< Cached LYGIA modules
     std::vector<GLuint> active_programs_;           ///< Active shader programs
+    
+    /**
+     * @brief Program compiled for a pipeline content key
+     */
+    struct CachedProgram {
+        uint64_t key;                               ///< Pipeline content key
+        GLuint program;                             ///< Linked program
+        uint64_t last_used;                         ///< Cache clock at last lookup
+    };
+    std::vector<CachedProgram> program_cache_;      ///< Programs by key, least recently used evicted
+    size_t program_cache_size_;                     ///< Maximum cached programs
+    uint64_t cache_clock_;                          ///< Lookup counter for LRU eviction
     GLuint current_program_;                        ///< Currently active program
     bool initialized_;                              ///< Initialization state
 };
@@ -1,5 +1,6 @@
 #include "GraphicsEngine.h"
 #include <iostream>
+#include <string>
 #include <signal.h>
 
 // Global engine instance for signal handling
@@ -23,6 +24,13 @@ int main(int argc, char* argv[]) {
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
     
+    // Optional crash-recovery checkpoint: --checkpoint <file.gfxg>
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--checkpoint") {
+            engine.setCheckpoint(argv[i + 1]);
+        }
+    }
+    
     // Run the engine
     engine.run();
     
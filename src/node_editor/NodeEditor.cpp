@@ -1,5 +1,11 @@
 #include "NodeEditor.h"
+#include "../core/GraphSnapshot.h"
+#include "../core/GraphLog.h"
+#include "../core/GraphDiff.h"
 #include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
 #include <thread>
 #include <chrono>
 #include <lo/lo.h>
@@ -17,6 +23,44 @@
 
 namespace gfx {
 
+namespace {
+
+// Send a parameter value with native OSC types; only string parameters go as text
+void sendParameter(OSCClient& client, int node_id, const Parameter& param) {
+    const std::string path(osc::engine::SET_PARAMETER);
+    float values[4];
+    switch (param.getType()) {
+        case osc::ParameterType::INT:
+            client.sendMessage(path, node_id, param.getName(), param.getIntValue());
+            break;
+        case osc::ParameterType::BOOL:
+            client.sendMessage(path, node_id, param.getName(), param.getBoolValue() ? 1 : 0);
+            break;
+        case osc::ParameterType::FLOAT:
+            values[0] = param.getFloatValue();
+            client.sendMessage(path, node_id, param.getName(), values, 1);
+            break;
+        case osc::ParameterType::VEC2:
+            param.getVec2Value(values[0], values[1]);
+            client.sendMessage(path, node_id, param.getName(), values, 2);
+            break;
+        case osc::ParameterType::VEC3:
+            param.getVec3Value(values[0], values[1], values[2]);
+            client.sendMessage(path, node_id, param.getName(), values, 3);
+            break;
+        case osc::ParameterType::VEC4:
+        case osc::ParameterType::COLOR:
+            param.getVec4Value(values[0], values[1], values[2], values[3]);
+            client.sendMessage(path, node_id, param.getName(), values, 4);
+            break;
+        case osc::ParameterType::STRING:
+            client.sendMessage(path, node_id, param.getName(), param.getStringValue());
+            break;
+    }
+}
+
+} // namespace
+
 NodeEditor::NodeEditor() 
     : window_(nullptr), imgui_context_(nullptr), 
       running_(false), engine_connected_(false), 
@@ -25,6 +69,7 @@ NodeEditor::NodeEditor()
       window_width_(1200), window_height_(800) {
     
     osc_server_ = std::make_unique<OSCServer>(osc::NODE_EDITOR_PORT);
+    osc_server_->setDispatchMode(OSCServer::DispatchMode::QUEUED);
     engine_client_ = std::make_unique<OSCClient>();
     code_interpreter_client_ = std::make_unique<OSCClient>();
     local_graph_ = std::make_unique<NodeGraph>();
@@ -69,6 +114,9 @@ bool NodeEditor::initialize(int width, int height, const std::string& title) {
     if (engine_client_->connect("localhost", osc::ENGINE_PORT)) {
         engine_connected_ = true;
         std::cout << "Connected to Graphics Engine" << std::endl;
+        
+        // Catch up with a graph the engine may already have
+        engine_client_->sendMessage(std::string(osc::engine::SYNC_GRAPH));
     } else {
         std::cout << "Graphics Engine not available (will retry)" << std::endl;
     }
@@ -155,6 +203,9 @@ void NodeEditor::run() {
         // Poll and handle events (inputs, window resize, etc.)
         glfwPollEvents();
         
+        // Engine notifications update local_graph_ here, never during the UI pass
+        osc_server_->poll();
+        
         // Start the Dear ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -192,6 +243,12 @@ void NodeEditor::renderUI() {
             if (ImGui::MenuItem("Load Graph")) {
                 loadGraph("graph.json");
             }
+            if (ImGui::MenuItem("Save Snapshot")) {
+                saveGraph("graph.gfxg");
+            }
+            if (ImGui::MenuItem("Load Snapshot")) {
+                loadGraph("graph.gfxg");
+            }
             ImGui::Separator();
             if (ImGui::MenuItem("Quit")) {
                 running_ = false;
@@ -269,9 +326,8 @@ void NodeEditor::renderNodeGraph() {
     }
     
     // Simple representation of nodes (this would be replaced with actual node editor)
-    auto& nodes = local_graph_->getNodes();
-    for (auto& node_pair : nodes) {
-        auto& node = node_pair.second;
+    for (const NodeEntry& entry : local_graph_->getNodes()) {
+        const Node* node = entry.node.get();
         
         // Simple node representation
         ImVec2 node_pos(origin.x + 50 + node->getId() * 150, origin.y + 50);
@@ -306,15 +362,14 @@ void NodeEditor::renderPropertiesPanel() {
         if (node) {
             ImGui::Text("Node: %s", node->getName().c_str());
             ImGui::Text("ID: %d", node->getId());
-            ImGui::Text("Type: %s", osc::nodeTypeToString(node->getType()).c_str());
+            ImGui::Text("Type: %s", node->getTypeName().c_str());
             
             ImGui::Separator();
             
             // Show parameters
-            auto& parameters = node->getParameters();
-            for (auto& param_pair : parameters) {
-                auto& param = param_pair.second;
-                ImGui::Text("%s: %s", param->getName().c_str(), param->toString().c_str());
+            for (size_t i = 0; i < node->getParameterCount(); ++i) {
+                Parameter param = node->getParameterAt(i);
+                ImGui::Text("%s: %s", param.getName().c_str(), param.toString().c_str());
             }
             
             ImGui::Separator();
@@ -405,10 +460,17 @@ void NodeEditor::setupOSCHandlers() {
     osc_server_->addHandler("/engine/connection/deleted",
         [this](const std::string& path, lo_message msg) { handleConnectionDeleted(msg); });
     
+    osc_server_->addHandler("/engine/connection/rejected",
+        [this](const std::string& path, lo_message msg) { handleConnectionRejected(msg); });
+    
     // Parameters
     osc_server_->addHandler("/engine/parameter/updated",
         [this](const std::string& path, lo_message msg) { handleParameterUpdated(msg); });
     
+    // Full graph (startup catch-up, undo, redo)
+    osc_server_->addHandler(osc::node_editor::GRAPH_SYNC,
+        [this](const std::string& path, lo_message msg) { handleGraphSync(msg); });
+    
     // Control
     osc_server_->addHandler(osc::node_editor::QUIT,
         [this](const std::string& path, lo_message msg) { handleQuit(msg); });
@@ -479,14 +541,33 @@ void NodeEditor::handleConnectionDeleted(lo_message msg) {
     }
 }
 
+void NodeEditor::handleConnectionRejected(lo_message msg) {
+    if (lo_message_get_argc(msg) >= 1) {
+        // source_id,source_output,target_id,target_input,reason
+        const char* message = &lo_message_get_argv(msg)[0]->s;
+        std::cerr << "Connection rejected by engine: " << message << std::endl;
+    }
+}
+
 void NodeEditor::handleParameterUpdated(lo_message msg) {
-    if (lo_message_get_argc(msg) >= 3) {
-        int node_id = lo_message_get_argv(msg)[0]->i;
-        const char* param_name = &lo_message_get_argv(msg)[1]->s;
-        const char* value = &lo_message_get_argv(msg)[2]->s;
+    // "iss", "isi", or "is" followed by 1-4 floats
+    int argc = lo_message_get_argc(msg);
+    const char* types = lo_message_get_types(msg);
+    if (argc >= 3 && types[0] == 'i' && types[1] == 's') {
+        lo_arg** argv = lo_message_get_argv(msg);
+        int node_id = argv[0]->i;
+        const char* param_name = &argv[1]->s;
         
-        std::cout << "Parameter updated in engine: node " << node_id 
-                  << ", " << param_name << " = " << value << std::endl;
+        std::cout << "Parameter updated in engine: node " << node_id << ", " << param_name << " =";
+        for (int k = 2; k < argc; ++k) {
+            switch (types[k]) {
+                case 's': std::cout << " " << &argv[k]->s; break;
+                case 'i': std::cout << " " << argv[k]->i; break;
+                case 'f': std::cout << " " << argv[k]->f; break;
+                default: break;
+            }
+        }
+        std::cout << std::endl;
         
         // Update local graph copy
         // TODO: Update parameter in local_graph_
@@ -506,6 +587,42 @@ void NodeEditor::handlePing(lo_message msg) {
     code_interpreter_client_->sendMessage(std::string(osc::common::PONG));
 }
 
+void NodeEditor::handleGraphSync(lo_message msg) {
+    if (lo_message_get_argc(msg) < 3 || std::strncmp(lo_message_get_types(msg), "iib", 3) != 0) {
+        return;
+    }
+    lo_arg** argv = lo_message_get_argv(msg);
+    int total = argv[0]->i;
+    int offset = argv[1]->i;
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(&argv[2]->blob.data);
+    int size = argv[2]->blob.size;
+    
+    // Chunks arrive in order; a lost chunk drops the stream until the next one starts
+    if (offset == 0) {
+        graph_sync_.clear();
+        graph_sync_.reserve(static_cast<size_t>(total));
+    }
+    if (offset != static_cast<int>(graph_sync_.size()) || size < 0 || offset + size > total) {
+        graph_sync_.clear();
+        return;
+    }
+    graph_sync_.insert(graph_sync_.end(), data, data + size);
+    if (static_cast<int>(graph_sync_.size()) < total) {
+        return;
+    }
+    
+    if (GraphLog::replay(*local_graph_, graph_sync_.data(), graph_sync_.size()) < 0) {
+        std::cerr << "Received malformed graph sync stream" << std::endl;
+    }
+    graph_sync_.clear();
+    
+    for (const NodeEntry& entry : local_graph_->getNodes()) {
+        next_node_id_ = std::max(next_node_id_, entry.node->getId() + 1);
+    }
+    std::cout << "Synced graph from engine (" << local_graph_->getNodes().size()
+              << " nodes)" << std::endl;
+}
+
 void NodeEditor::createNodeInEngine(const std::string& name, const std::string& type, float x, float y) {
     if (!engine_connected_) {
         std::cerr << "Not connected to engine" << std::endl;
@@ -551,7 +668,15 @@ void NodeEditor::disconnectNodesInEngine(int connection_id) {
         return;
     }
     
-    engine_client_->sendMessage(std::string(osc::engine::DISCONNECT_NODES), std::to_string(connection_id));
+    // The engine numbers connections itself, so name it by its endpoints
+    const Connection* connection = local_graph_->getConnection(connection_id);
+    if (!connection) {
+        std::cerr << "Unknown connection: " << connection_id << std::endl;
+        return;
+    }
+    engine_client_->sendMessage(std::string(osc::engine::DISCONNECT_NODES),
+                                connection->getSourceNodeId(), connection->getSourceOutput(),
+                                connection->getTargetNodeId(), connection->getTargetInput());
     std::cout << "Requested disconnection: " << connection_id << std::endl;
 }
 
@@ -569,13 +694,80 @@ void NodeEditor::updateParameterInEngine(int node_id, const std::string& param_n
 }
 
 void NodeEditor::saveGraph(const std::string& filename) {
-    // TODO: Implement graph saving
-    std::cout << "Save graph to: " << filename << " (not implemented)" << std::endl;
+    if (GraphSnapshot::isSnapshotPath(filename)) {
+        if (!local_graph_->saveSnapshot(filename)) {
+            return;
+        }
+    } else {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file) {
+            std::cerr << "Failed to open " << filename << " for writing" << std::endl;
+            return;
+        }
+        
+        local_graph_->writeJSON(file);
+        if (!file) {
+            std::cerr << "Failed to write graph to " << filename << std::endl;
+            return;
+        }
+    }
+    std::cout << "Saved graph to: " << filename << " (" << local_graph_->getNodes().size()
+              << " nodes)" << std::endl;
 }
 
 void NodeEditor::loadGraph(const std::string& filename) {
-    // TODO: Implement graph loading
-    std::cout << "Load graph from: " << filename << " (not implemented)" << std::endl;
+    // Load into a fresh graph so the engine only receives the difference
+    auto graph = std::make_unique<NodeGraph>();
+    bool loaded = false;
+    if (GraphSnapshot::isSnapshotPath(filename)) {
+        loaded = graph->loadSnapshot(filename);
+    } else {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (file) {
+            std::string json(static_cast<size_t>(file.tellg()), '\0');
+            file.seekg(0);
+            file.read(&json[0], static_cast<std::streamsize>(json.size()));
+            loaded = file && graph->fromJSON(json);
+        }
+    }
+    if (!loaded) {
+        std::cerr << "Failed to load graph from " << filename << std::endl;
+        return;
+    }
+    
+    GraphDiff diff = GraphDiff::compute(*local_graph_, *graph);
+    std::cout << "Loaded graph from: " << filename << " (" << graph->getNodes().size()
+              << " nodes, " << diff.size() << " changes)" << std::endl;
+    
+    // Send the edit script to the engine
+    if (engine_connected_) {
+        // The engine numbers connections itself, so they are named by endpoints
+        for (const Connection* connection : diff.removed_connections) {
+            engine_client_->sendMessage(std::string(osc::engine::DISCONNECT_NODES),
+                                        connection->getSourceNodeId(), connection->getSourceOutput(),
+                                        connection->getTargetNodeId(), connection->getTargetInput());
+        }
+        for (int node_id : diff.removed_nodes) {
+            engine_client_->sendMessage(std::string(osc::engine::DELETE_NODE), node_id);
+        }
+        for (Node* node : diff.added_nodes) {
+            engine_client_->sendMessage(std::string(osc::engine::CREATE_NODE), node->getId(),
+                                        node->getName(), node->getTypeName());
+        }
+        for (const GraphDiff::ParameterChange& change : diff.changed_parameters) {
+            sendParameter(*engine_client_, change.node->getId(), change.node->getParameterAt(change.field));
+        }
+        for (const Connection* connection : diff.added_connections) {
+            engine_client_->sendMessage(std::string(osc::engine::CONNECT_NODES),
+                                        connection->getSourceNodeId(), connection->getSourceOutput(),
+                                        connection->getTargetNodeId(), connection->getTargetInput());
+        }
+    }
+    
+    local_graph_ = std::move(graph);
+    for (const NodeEntry& entry : local_graph_->getNodes()) {
+        next_node_id_ = std::max(next_node_id_, entry.node->getId() + 1);
+    }
 }
 
 } // namespace gfx
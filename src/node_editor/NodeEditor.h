@@ -6,6 +6,7 @@
 #include "../core/NodeGraph.h"
 #include <memory>
 #include <atomic>
+#include <vector>
 
 // Forward declarations for ImGui and GLFW
 struct GLFWwindow;
@@ -49,9 +50,11 @@ public:
     void handleNodeDeleted(lo_message msg);
     void handleConnectionCreated(lo_message msg);
     void handleConnectionDeleted(lo_message msg);
+    void handleConnectionRejected(lo_message msg);
     void handleParameterUpdated(lo_message msg);
     void handleQuit(lo_message msg);
     void handlePing(lo_message msg);
+    void handleGraphSync(lo_message msg);
     
     // UI operations
     void createNodeInEngine(const std::string& name, const std::string& type, float x, float y);
@@ -119,6 +122,7 @@ private:
     std::unique_ptr<OSCClient> code_interpreter_client_; ///< OSC client for code interpreter
     
     std::unique_ptr<NodeGraph> local_graph_;            ///< Local copy of node graph for UI
+    std::vector<uint8_t> graph_sync_;                   ///< Graph sync stream received so far
     
     std::atomic<bool> running_;                         ///< Main loop running state
     bool engine_connected_;                             ///< Connection status to graphics engine
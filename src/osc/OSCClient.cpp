@@ -100,6 +100,21 @@ bool OSCClient::sendMessage(const std::string& path, const std::string& value) {
     return true;
 }
 
+bool OSCClient::sendMessage(const char* path, const char* value) {
+    if (!address_) {
+        std::cerr << "OSC Client not connected" << std::endl;
+        return false;
+    }
+    
+    int result = lo_send(address_, path, "s", value);
+    if (result == -1) {
+        std::cerr << "Failed to send OSC message: " << path << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
 bool OSCClient::sendMessage(const std::string& path, int i, float f) {
     if (!address_) {
         std::cerr << "OSC Client not connected" << std::endl;
@@ -160,6 +175,65 @@ bool OSCClient::sendMessage(const std::string& path, int i1, const std::string&
     return true;
 }
 
+bool OSCClient::sendMessage(const std::string& path, int i, const std::string& s, int value) {
+    if (!address_) {
+        std::cerr << "OSC Client not connected" << std::endl;
+        return false;
+    }
+    
+    int result = lo_send(address_, path.c_str(), "isi", i, s.c_str(), value);
+    if (result == -1) {
+        std::cerr << "Failed to send OSC message: " << path << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+bool OSCClient::sendMessage(const std::string& path, int i, const std::string& s, const float* values, int count) {
+    if (!address_) {
+        std::cerr << "OSC Client not connected" << std::endl;
+        return false;
+    }
+    
+    lo_message msg = lo_message_new();
+    lo_message_add_int32(msg, i);
+    lo_message_add_string(msg, s.c_str());
+    for (int k = 0; k < count; ++k) {
+        lo_message_add_float(msg, values[k]);
+    }
+    int result = lo_send_message(address_, path.c_str(), msg);
+    lo_message_free(msg);
+    if (result == -1) {
+        std::cerr << "Failed to send OSC message: " << path << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+bool OSCClient::sendMessage(const std::string& path, int i1, int i2, const void* data, size_t size) {
+    if (!address_) {
+        std::cerr << "OSC Client not connected" << std::endl;
+        return false;
+    }
+    
+    lo_blob blob = lo_blob_new(static_cast<int32_t>(size), data);
+    lo_message msg = lo_message_new();
+    lo_message_add_int32(msg, i1);
+    lo_message_add_int32(msg, i2);
+    lo_message_add_blob(msg, blob);
+    int result = lo_send_message(address_, path.c_str(), msg);
+    lo_message_free(msg);
+    lo_blob_free(blob);
+    if (result == -1) {
+        std::cerr << "Failed to send OSC message: " << path << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
 void OSCClient::errorHandler(int num, const char* msg, const char* path) {
     std::cerr << "OSC Client error " << num << " in path " << (path ? path : "unknown") 
               << ": " << msg << std::endl;
@@ -21,11 +21,19 @@ public:
     bool sendMessage(const std::string& path, int value);
     bool sendMessage(const std::string& path, float value);
     bool sendMessage(const std::string& path, const std::string& value);
+    bool sendMessage(const char* path, const char* value);     // Without string copies
     bool sendMessage(const std::string& path, int i, float f);
     bool sendMessage(const std::string& path, int i, float f, const std::string& s);
     bool sendMessage(const std::string& path, int i, const std::string& s1, const std::string& s2);
     bool sendMessage(const std::string& path, int i1, const std::string& s, int i2, const std::string& s2);
     
+    // Typed parameter values: "isi", or "is" followed by count floats (1-4)
+    bool sendMessage(const std::string& path, int i, const std::string& s, int value);
+    bool sendMessage(const std::string& path, int i, const std::string& s, const float* values, int count);
+    
+    // Binary payload: "iib"
+    bool sendMessage(const std::string& path, int i1, int i2, const void* data, size_t size);
+    
     // Get connection info
     std::string getHost() const { return host_; }
     int getPort() const { return port_; }
@@ -0,0 +1,229 @@
+#include "OSCEventLoop.h"
+#include <iostream>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+namespace gfx {
+
+namespace {
+
+// Source id of the wakeup eventfd; real sources start at 1
+constexpr uint64_t WAKE_SOURCE = 0;
+
+#if defined(__linux__)
+// Events taken per epoll_wait
+constexpr int MAX_EVENTS = 32;
+#else
+// Without a wakeup descriptor the loop notices stop() and new sources
+// within this many milliseconds
+constexpr int POLL_TIMEOUT_MS = 50;
+#endif
+
+} // namespace
+
+OSCEventLoop::OSCEventLoop()
+    : epoll_fd_(-1), wake_fd_(-1), running_(false), next_source_(WAKE_SOURCE + 1) {
+#if defined(__linux__)
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ >= 0 && wake_fd_ >= 0) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = WAKE_SOURCE;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) == 0) {
+            return;
+        }
+    }
+    std::cerr << "OSC event loop: failed to create epoll instance: " << std::strerror(errno) << std::endl;
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+#endif
+}
+
+OSCEventLoop::~OSCEventLoop() {
+    stop();
+#if defined(__linux__)
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+#endif
+}
+
+bool OSCEventLoop::start() {
+    if (running_) {
+        return true;
+    }
+#if defined(__linux__)
+    if (epoll_fd_ < 0) {
+        return false;
+    }
+#endif
+    running_ = true;
+    thread_ = std::thread(&OSCEventLoop::loopThread, this);
+    return true;
+}
+
+void OSCEventLoop::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    wake();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+uint64_t OSCEventLoop::addSource(int fd, ReadyCallback callback) {
+    if (fd < 0) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t source = next_source_++;
+#if defined(__linux__)
+    if (epoll_fd_ < 0) {
+        return 0;
+    }
+    // Level-triggered: a callback that leaves data behind is called again
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = source;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+        std::cerr << "OSC event loop: failed to watch descriptor " << fd << ": "
+                  << std::strerror(errno) << std::endl;
+        return 0;
+    }
+#endif
+    sources_[source] = {fd, std::move(callback)};
+    return source;
+}
+
+void OSCEventLoop::removeSource(uint64_t source) {
+    // Waits for the loop thread to finish its current callbacks; events
+    // already taken for this source find it gone and are skipped
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sources_.find(source);
+    if (it == sources_.end()) {
+        return;
+    }
+#if defined(__linux__)
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+#endif
+    sources_.erase(it);
+}
+
+void OSCEventLoop::wake() {
+#if defined(__linux__)
+    uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        std::cerr << "OSC event loop: failed to wake loop thread: " << std::strerror(errno) << std::endl;
+    }
+#endif
+}
+
+#if defined(__linux__)
+
+void OSCEventLoop::loopThread() {
+    epoll_event events[MAX_EVENTS];
+    while (running_) {
+        int count = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "OSC event loop: epoll_wait failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < count; ++i) {
+            uint64_t source = events[i].data.u64;
+            if (source == WAKE_SOURCE) {
+                uint64_t value;
+                while (read(wake_fd_, &value, sizeof(value)) > 0) {
+                }
+                continue;
+            }
+            auto it = sources_.find(source);
+            if (it != sources_.end()) {
+                it->second.callback();
+            }
+        }
+    }
+}
+
+#else
+
+void OSCEventLoop::loopThread() {
+#if defined(_WIN32)
+    using PollDescriptor = WSAPOLLFD;
+#else
+    using PollDescriptor = pollfd;
+#endif
+    std::vector<PollDescriptor> descriptors;
+    std::vector<uint64_t> ids;
+    while (running_) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            descriptors.clear();
+            ids.clear();
+            for (const auto& [id, source] : sources_) {
+                PollDescriptor descriptor = {};
+                descriptor.fd = source.fd;
+                descriptor.events = POLLIN;
+                descriptors.push_back(descriptor);
+                ids.push_back(id);
+            }
+        }
+
+#if defined(_WIN32)
+        int count = descriptors.empty() ? 0 :
+            WSAPoll(descriptors.data(), static_cast<ULONG>(descriptors.size()), POLL_TIMEOUT_MS);
+        if (descriptors.empty()) {
+            Sleep(POLL_TIMEOUT_MS);
+        }
+#else
+        int count = poll(descriptors.data(), descriptors.size(), POLL_TIMEOUT_MS);
+#endif
+        if (count <= 0) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < descriptors.size(); ++i) {
+            if (descriptors[i].revents & POLLIN) {
+                auto it = sources_.find(ids[i]);
+                if (it != sources_.end()) {
+                    it->second.callback();
+                }
+            }
+        }
+    }
+}
+
+#endif
+
+} // namespace gfx
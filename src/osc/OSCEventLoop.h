@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace gfx {
+
+// One thread waiting on any number of file descriptors, e.g. the sockets of
+// several OSC servers, and calling a source's callback as soon as its
+// descriptor becomes readable. On Linux it waits with epoll and is woken for
+// stop() through an eventfd, so stopping never waits for a timeout. Other
+// platforms fall back to poll() with a short timeout.
+class OSCEventLoop {
+public:
+    using ReadyCallback = std::function<void()>;
+
+    OSCEventLoop();
+    ~OSCEventLoop();
+
+    OSCEventLoop(const OSCEventLoop&) = delete;
+    OSCEventLoop& operator=(const OSCEventLoop&) = delete;
+
+    // Start/stop the loop thread; sources stay registered across restarts
+    bool start();
+    void stop();
+    bool isRunning() const { return running_; }
+
+    // Watch fd until removeSource(). The callback runs on the loop thread
+    // while fd is readable and must consume what is ready. Returns 0 on
+    // failure. Neither may be called from a callback; removeSource() returns
+    // once the source's callback is no longer running.
+    uint64_t addSource(int fd, ReadyCallback callback);
+    void removeSource(uint64_t source);
+
+private:
+    struct Source {
+        int fd;
+        ReadyCallback callback;
+    };
+
+    void loopThread();
+    void wake();
+
+    int epoll_fd_;      // -1 where epoll is not available
+    int wake_fd_;
+
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    // Held by the loop thread while it runs callbacks
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, Source> sources_;
+    uint64_t next_source_;
+};
+
+} // namespace gfx
@@ -0,0 +1,99 @@
+#include "OSCMessageView.h"
+
+namespace gfx {
+
+namespace {
+
+// Length of the padded OSC string at offset, or 0 if it is not terminated
+// within size. Strings are padded with NULs to a multiple of 4 bytes.
+size_t paddedStringLength(const char* data, size_t offset, size_t size) {
+    const void* end = std::memchr(data + offset, '\0', size - offset);
+    if (!end) {
+        return 0;
+    }
+    size_t length = static_cast<const char*>(end) - (data + offset);
+    size_t padded = (length + 4) & ~size_t(3);
+    return (offset + padded <= size) ? padded : 0;
+}
+
+} // namespace
+
+bool OSCMessageView::parse(const char* data, size_t size) {
+    data_ = data;
+    size_ = size;
+    address_ = nullptr;
+    types_ = nullptr;
+    count_ = 0;
+    
+    if (size < 4 || size % 4 != 0 || data[0] != '/') {
+        return false;
+    }
+    size_t offset = paddedStringLength(data, 0, size);
+    if (offset == 0) {
+        return false;
+    }
+    
+    // A message without type tags is allowed by OSC 1.0 but not sent by
+    // anything we talk to
+    if (offset >= size || data[offset] != ',') {
+        return false;
+    }
+    size_t types_length = paddedStringLength(data, offset, size);
+    if (types_length == 0) {
+        return false;
+    }
+    const char* types = data + offset + 1;
+    offset += types_length;
+    
+    int count = 0;
+    for (const char* type = types; *type; ++type, ++count) {
+        if (count == MAX_ARGUMENTS) {
+            return false;
+        }
+        offsets_[count] = static_cast<uint32_t>(offset);
+        
+        size_t length;
+        switch (*type) {
+            case 'i': case 'f': case 'c': case 'r': case 'm':
+                length = 4;
+                break;
+            case 'h': case 'd': case 't':
+                length = 8;
+                break;
+            case 's': case 'S':
+                length = (offset < size) ? paddedStringLength(data, offset, size) : 0;
+                if (length == 0) {
+                    return false;
+                }
+                break;
+            case 'b': {
+                if (offset + 4 > size) {
+                    return false;
+                }
+                // Widen before padding so a length near 2^32 cannot wrap
+                size_t blob_size = readUint32(data + offset);
+                if (blob_size > size - offset - 4) {
+                    return false;
+                }
+                length = 4 + ((blob_size + 3) & ~size_t(3));
+                break;
+            }
+            case 'T': case 'F': case 'N': case 'I': case '[': case ']':
+                length = 0;
+                break;
+            default:
+                return false;
+        }
+        if (offset + length > size) {
+            return false;
+        }
+        offset += length;
+    }
+    
+    address_ = data;
+    types_ = types;
+    count_ = count;
+    return true;
+}
+
+} // namespace gfx
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace gfx {
+
+// An OSC message decoded in place: the address, type tags and arguments
+// are read straight out of the datagram, which must outlive the view.
+// parse() only records where each argument starts; the accessors convert
+// from OSC's big-endian encoding when called. Nothing is allocated.
+//
+// Accessors do not check types; look at getType() first. Strings and blob
+// data point into the datagram.
+class OSCMessageView {
+public:
+    static constexpr int MAX_ARGUMENTS = 16;
+    
+    OSCMessageView() = default;
+    
+    // Returns false for anything but a well-formed message (bundles
+    // included) with at most MAX_ARGUMENTS arguments
+    bool parse(const char* data, size_t size);
+    
+    const char* getAddress() const { return address_; }
+    const char* getTypes() const { return types_; }     // Without the leading ','
+    int getArgumentCount() const { return count_; }
+    char getType(int index) const { return types_[index]; }
+    
+    // 'i', 'c', 'r', 'm' / 'f' / 'h' / 'd', 't'
+    int32_t getInt(int index) const { return static_cast<int32_t>(readUint32(argument(index))); }
+    float getFloat(int index) const;
+    int64_t getInt64(int index) const { return static_cast<int64_t>(readUint64(argument(index))); }
+    double getDouble(int index) const;
+    
+    // 's', 'S'
+    const char* getString(int index) const { return argument(index); }
+    
+    // 'b'
+    size_t getBlobSize(int index) const { return readUint32(argument(index)); }
+    const void* getBlobData(int index) const { return argument(index) + 4; }
+    
+    // The datagram
+    const char* getData() const { return data_; }
+    size_t getSize() const { return size_; }
+    
+private:
+    const char* argument(int index) const { return data_ + offsets_[index]; }
+    
+    static uint32_t readUint32(const char* p) {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+        return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+    }
+    
+    static uint64_t readUint64(const char* p) {
+        return (uint64_t(readUint32(p)) << 32) | readUint32(p + 4);
+    }
+    
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const char* address_ = nullptr;
+    const char* types_ = nullptr;
+    int count_ = 0;
+    uint32_t offsets_[MAX_ARGUMENTS] = {};      // From data_
+};
+
+inline float OSCMessageView::getFloat(int index) const {
+    uint32_t bits = readUint32(argument(index));
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline double OSCMessageView::getDouble(int index) const {
+    uint64_t bits = readUint64(argument(index));
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace gfx
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "../core/Hash.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace gfx {
@@ -10,50 +13,81 @@ constexpr int ENGINE_PORT = 57120;
 constexpr int NODE_EDITOR_PORT = 57121;
 constexpr int CODE_INTERPRETER_PORT = 57122;
 
-// Message paths for Engine
+// Largest OSC packet sent or received (liblo's default maximum message size)
+constexpr size_t MAX_PACKET_SIZE = 32768;
+
+// Blob bytes per message when data is split across messages, leaving the
+// rest of the packet for the address, type tags and other arguments
+constexpr size_t MAX_BLOB_CHUNK = 16 * 1024;
+static_assert(MAX_BLOB_CHUNK + 1024 <= MAX_PACKET_SIZE, "blob chunks must fit a packet with their framing");
+
+// OSC address with its hash (see hashString), computed at compile time for
+// the message paths below so dispatch tables never hash them at run time.
+// Converts to const char* wherever a plain path is expected.
+struct Address {
+    const char* path;
+    uint64_t hash;
+    
+    constexpr Address(const char* address) : path(address), hash(hashString(address)) {}
+    constexpr operator const char*() const { return path; }
+};
+
+// Message paths for Engine. Nodes have no addresses of their own: a node
+// is named by its id argument (e.g. SET_PARAMETER takes "is..."), so an
+// address pattern can select among these paths but not among nodes, and
+// /engine/node/*/param/set matches nothing. Per-node addresses would have
+// to be registered with the server as nodes come and go.
 namespace engine {
-    constexpr const char* STATUS = "/engine/status";
-    constexpr const char* QUIT = "/engine/quit";
-    constexpr const char* CREATE_NODE = "/engine/node/create";
-    constexpr const char* DELETE_NODE = "/engine/node/delete";
-    constexpr const char* UPDATE_NODE = "/engine/node/update";
-    constexpr const char* SET_PARAMETER = "/engine/node/param/set";
-    constexpr const char* GET_PARAMETER = "/engine/node/param/get";
-    constexpr const char* CONNECT_NODES = "/engine/connection/create";
-    constexpr const char* DISCONNECT_NODES = "/engine/connection/delete";
-    constexpr const char* RENDER_FRAME = "/engine/render";
+    constexpr Address STATUS = "/engine/status";
+    constexpr Address QUIT = "/engine/quit";
+    constexpr Address CREATE_NODE = "/engine/node/create";
+    constexpr Address DELETE_NODE = "/engine/node/delete";
+    constexpr Address UPDATE_NODE = "/engine/node/update";
+    constexpr Address SET_PARAMETER = "/engine/node/param/set";
+    constexpr Address GET_PARAMETER = "/engine/node/param/get";
+    constexpr Address CONNECT_NODES = "/engine/connection/create";
+    constexpr Address DISCONNECT_NODES = "/engine/connection/delete";
+    constexpr Address RENDER_FRAME = "/engine/render";
+    constexpr Address SAVE_GRAPH = "/engine/graph/save";
+    constexpr Address LOAD_GRAPH = "/engine/graph/load";
+    constexpr Address SYNC_GRAPH = "/engine/graph/sync";
+    constexpr Address UNDO = "/engine/undo";
+    constexpr Address REDO = "/engine/redo";
+    constexpr Address SET_AUTOMATION = "/engine/automation/set";
+    constexpr Address CLEAR_AUTOMATION = "/engine/automation/clear";
 }
 
 // Message paths for Node Editor
 namespace node_editor {
-    constexpr const char* STATUS = "/editor/status";
-    constexpr const char* QUIT = "/editor/quit";
-    constexpr const char* NODE_SELECTED = "/editor/node/selected";
-    constexpr const char* NODE_MOVED = "/editor/node/moved";
-    constexpr const char* CONNECTION_CREATED = "/editor/connection/created";
-    constexpr const char* CONNECTION_DELETED = "/editor/connection/deleted";
-    constexpr const char* PARAMETER_CHANGED = "/editor/parameter/changed";
-    constexpr const char* SAVE_GRAPH = "/editor/graph/save";
-    constexpr const char* LOAD_GRAPH = "/editor/graph/load";
+    constexpr Address STATUS = "/editor/status";
+    constexpr Address QUIT = "/editor/quit";
+    constexpr Address NODE_SELECTED = "/editor/node/selected";
+    constexpr Address NODE_MOVED = "/editor/node/moved";
+    constexpr Address CONNECTION_CREATED = "/editor/connection/created";
+    constexpr Address CONNECTION_DELETED = "/editor/connection/deleted";
+    constexpr Address PARAMETER_CHANGED = "/editor/parameter/changed";
+    constexpr Address SAVE_GRAPH = "/editor/graph/save";
+    constexpr Address LOAD_GRAPH = "/editor/graph/load";
+    constexpr Address GRAPH_SYNC = "/editor/graph/sync";
 }
 
 // Message paths for Code Interpreter
 namespace code_interpreter {
-    constexpr const char* STATUS = "/interpreter/status";
-    constexpr const char* QUIT = "/interpreter/quit";
-    constexpr const char* EXECUTE_CODE = "/interpreter/execute";
-    constexpr const char* EXECUTION_RESULT = "/interpreter/result";
-    constexpr const char* EXECUTION_ERROR = "/interpreter/error";
-    constexpr const char* REGISTER_FUNCTION = "/interpreter/function/register";
-    constexpr const char* CALL_FUNCTION = "/interpreter/function/call";
+    constexpr Address STATUS = "/interpreter/status";
+    constexpr Address QUIT = "/interpreter/quit";
+    constexpr Address EXECUTE_CODE = "/interpreter/execute";
+    constexpr Address EXECUTION_RESULT = "/interpreter/result";
+    constexpr Address EXECUTION_ERROR = "/interpreter/error";
+    constexpr Address REGISTER_FUNCTION = "/interpreter/function/register";
+    constexpr Address CALL_FUNCTION = "/interpreter/function/call";
 }
 
 // Common message paths (used by all components)
 namespace common {
-    constexpr const char* PING = "/ping";
-    constexpr const char* PONG = "/pong";
-    constexpr const char* ERROR = "/error";
-    constexpr const char* LOG = "/log";
+    constexpr Address PING = "/ping";
+    constexpr Address PONG = "/pong";
+    constexpr Address ERROR = "/error";
+    constexpr Address LOG = "/log";
 }
 
 // Node types
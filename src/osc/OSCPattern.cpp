@@ -0,0 +1,178 @@
+#include "OSCPattern.h"
+#include <algorithm>
+#include <cstring>
+
+namespace gfx {
+
+namespace {
+
+bool isSpecial(char c) {
+    return c == '?' || c == '*' || c == '[' || c == ']' || c == '{' || c == '}';
+}
+
+} // namespace
+
+bool OSCPattern::isPattern(const char* address) {
+    for (; *address; ++address) {
+        if (isSpecial(*address)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OSCPattern::compile(const std::string& pattern) {
+    pattern_.clear();
+    text_.clear();
+    tokens_.clear();
+    sets_.clear();
+    alternatives_.clear();
+
+    auto fail = [this]() {
+        text_.clear();
+        tokens_.clear();
+        sets_.clear();
+        alternatives_.clear();
+        return false;
+    };
+
+    const size_t size = pattern.size();
+    size_t i = 0;
+    while (i < size) {
+        char c = pattern[i];
+        if (c == '?') {
+            tokens_.push_back({TokenType::ANY_CHAR, 0, 0});
+            i++;
+        } else if (c == '*') {
+            // Consecutive stars match the same as one
+            if (tokens_.empty() || tokens_.back().type != TokenType::ANY_RUN) {
+                tokens_.push_back({TokenType::ANY_RUN, 0, 0});
+            }
+            i++;
+        } else if (c == '[') {
+            size_t close = pattern.find(']', i + 1);
+            if (close == std::string::npos) {
+                return fail();
+            }
+            std::bitset<256> set;
+            size_t j = i + 1;
+            bool negate = (j < close && pattern[j] == '!');
+            if (negate) {
+                j++;
+            }
+            for (; j < close; ++j) {
+                unsigned char first = static_cast<unsigned char>(pattern[j]);
+                if (j + 2 < close && pattern[j + 1] == '-') {
+                    unsigned char last = static_cast<unsigned char>(pattern[j + 2]);
+                    for (unsigned int k = std::min(first, last); k <= std::max(first, last); ++k) {
+                        set.set(k);
+                    }
+                    j += 2;
+                } else {
+                    set.set(first);
+                }
+            }
+            if (negate) {
+                set.flip();
+            }
+            set.reset('/');
+            set.reset(0);
+            tokens_.push_back({TokenType::CHAR_SET, static_cast<uint32_t>(sets_.size()), 0});
+            sets_.push_back(set);
+            i = close + 1;
+        } else if (c == '{') {
+            size_t close = pattern.find('}', i + 1);
+            if (close == std::string::npos) {
+                return fail();
+            }
+            uint32_t first = static_cast<uint32_t>(alternatives_.size());
+            size_t j = i + 1;
+            for (;;) {
+                size_t comma = std::min(pattern.find(',', j), close);
+                uint32_t begin = static_cast<uint32_t>(text_.size());
+                text_.append(pattern, j, comma - j);
+                alternatives_.push_back({begin, static_cast<uint32_t>(text_.size())});
+                if (comma == close) {
+                    break;
+                }
+                j = comma + 1;
+            }
+            tokens_.push_back({TokenType::ALTERNATIVES, first, static_cast<uint32_t>(alternatives_.size())});
+            i = close + 1;
+        } else if (c == ']' || c == '}') {
+            return fail();
+        } else {
+            size_t j = i;
+            while (j < size && !isSpecial(pattern[j])) {
+                j++;
+            }
+            uint32_t begin = static_cast<uint32_t>(text_.size());
+            text_.append(pattern, i, j - i);
+            tokens_.push_back({TokenType::LITERAL, begin, static_cast<uint32_t>(text_.size())});
+            i = j;
+        }
+    }
+
+    pattern_ = pattern;
+    return true;
+}
+
+bool OSCPattern::matches(const char* address) const {
+    if (pattern_.empty()) {
+        return false;
+    }
+    return matchFrom(0, address);
+}
+
+bool OSCPattern::matchFrom(size_t token, const char* address) const {
+    for (; token < tokens_.size(); ++token) {
+        const Token& current = tokens_[token];
+        switch (current.type) {
+            case TokenType::LITERAL: {
+                // strncmp stops at the end of a shorter address, which differs
+                size_t length = current.end - current.begin;
+                if (std::strncmp(address, text_.data() + current.begin, length) != 0) {
+                    return false;
+                }
+                address += length;
+                break;
+            }
+            case TokenType::ANY_CHAR:
+                if (*address == '\0' || *address == '/') {
+                    return false;
+                }
+                address++;
+                break;
+            case TokenType::CHAR_SET:
+                // Sets never contain '/' or the terminator
+                if (!sets_[current.begin].test(static_cast<unsigned char>(*address))) {
+                    return false;
+                }
+                address++;
+                break;
+            case TokenType::ALTERNATIVES:
+                for (uint32_t a = current.begin; a < current.end; ++a) {
+                    const Range& range = alternatives_[a];
+                    size_t length = range.end - range.begin;
+                    if (std::strncmp(address, text_.data() + range.begin, length) == 0 &&
+                        matchFrom(token + 1, address + length)) {
+                        return true;
+                    }
+                }
+                return false;
+            case TokenType::ANY_RUN:
+                // Try every split within the current address part
+                for (;; ++address) {
+                    if (matchFrom(token + 1, address)) {
+                        return true;
+                    }
+                    if (*address == '\0' || *address == '/') {
+                        return false;
+                    }
+                }
+        }
+    }
+    return *address == '\0';
+}
+
+} // namespace gfx
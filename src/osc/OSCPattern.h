@@ -0,0 +1,60 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gfx {
+
+// OSC 1.0 address pattern, compiled once and matched against addresses:
+//   ?          any single character
+//   *          any run of characters, possibly empty
+//   [a-z0-9]   one character from the set; [!...] negates it
+//   {foo,bar}  one of the listed strings
+// None of them match '/', so a pattern part only ever matches one address part.
+class OSCPattern {
+public:
+    OSCPattern() = default;
+
+    // True if the address contains pattern characters
+    static bool isPattern(const char* address);
+
+    // Returns false, leaving an empty pattern, for unbalanced [] or {}
+    bool compile(const std::string& pattern);
+
+    bool matches(const char* address) const;
+    bool matches(const std::string& address) const { return matches(address.c_str()); }
+
+    const std::string& getPattern() const { return pattern_; }
+
+private:
+    enum class TokenType : uint8_t {
+        LITERAL,        // text_[begin, end)
+        ANY_CHAR,
+        ANY_RUN,
+        CHAR_SET,       // sets_[set]
+        ALTERNATIVES    // alternatives_[begin, end), each a range of text_
+    };
+
+    struct Token {
+        TokenType type;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct Range {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    bool matchFrom(size_t token, const char* address) const;
+
+    std::string pattern_;
+    std::string text_;                      // Literal characters of all tokens
+    std::vector<Token> tokens_;
+    std::vector<std::bitset<256>> sets_;
+    std::vector<Range> alternatives_;
+};
+
+} // namespace gfx
@@ -1,10 +1,85 @@
 #include "OSCServer.h"
 #include <iostream>
 #include <cstring>
+#include <exception>
+
+#if defined(__linux__)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
 
 namespace gfx {
 
-OSCServer::OSCServer(int port) : port_(port), server_(nullptr), running_(false) {
+namespace {
+
+// Address patterns cached with the routes they match
+constexpr size_t MAX_CACHED_PATTERNS = 256;
+
+// Batched receive: datagrams taken per recvmmsg call, and the largest one
+// accepted
+constexpr size_t BATCH_DATAGRAMS = 64;
+constexpr size_t MAX_DATAGRAM_SIZE = osc::MAX_PACKET_SIZE;
+
+} // namespace
+
+#if defined(__linux__)
+
+struct OSCServer::BatchReceiver {
+    std::unique_ptr<char[]> buffers{new char[BATCH_DATAGRAMS * MAX_DATAGRAM_SIZE]};
+    iovec vectors[BATCH_DATAGRAMS];
+    mmsghdr headers[BATCH_DATAGRAMS];
+    
+    BatchReceiver() {
+        for (size_t i = 0; i < BATCH_DATAGRAMS; ++i) {
+            vectors[i].iov_base = buffers.get() + i * MAX_DATAGRAM_SIZE;
+            vectors[i].iov_len = MAX_DATAGRAM_SIZE;
+        }
+    }
+};
+
+#else
+
+struct OSCServer::BatchReceiver {
+};
+
+#endif
+
+OSCBundle& OSCBundle::operator=(OSCBundle&& other) noexcept {
+    if (this != &other) {
+        release();
+        swap(other);
+    }
+    return *this;
+}
+
+void OSCBundle::append(const char* path, lo_message msg) {
+    if (count_ == messages_.size()) {
+        messages_.emplace_back();
+    }
+    Message& message = messages_[count_++];
+    message.path.assign(path);
+    lo_message_incref(msg);
+    message.msg = msg;
+}
+
+void OSCBundle::release() {
+    for (size_t i = 0; i < count_; ++i) {
+        lo_message_free(messages_[i].msg);
+        messages_[i].msg = nullptr;
+    }
+    count_ = 0;
+}
+
+void OSCBundle::swap(OSCBundle& other) noexcept {
+    std::swap(time_, other.time_);
+    messages_.swap(other.messages_);
+    std::swap(count_, other.count_);
+}
+
+OSCServer::OSCServer(int port)
+    : port_(port), server_(nullptr), route_revision_(0), running_(false),
+      owns_event_loop_(false), event_source_(0), dispatch_mode_(DispatchMode::IMMEDIATE), queued_count_(0), dropped_count_(0),
+      reported_drops_(0), bundle_depth_(0), batched_receive_(false) {
 }
 
 OSCServer::~OSCServer() {
@@ -29,8 +104,47 @@ bool OSCServer::start() {
     // Add generic handler for all messages
     lo_server_add_method(server_, nullptr, nullptr, genericHandler, this);
     
+    // Queued mode groups the messages of a bundle. The owner schedules timed
+    // bundles itself, so liblo must hand them over on arrival instead of
+    // holding them in its own queue.
+    if (queue_) {
+        lo_server_add_bundle_handlers(server_, bundleStartHandler, bundleEndHandler, this);
+        if (bundle_handler_) {
+            lo_server_enable_queue(server_, 0, 1);
+        }
+    }
+    
+    // Batched receive reads the socket itself and hands liblo only what
+    // needs it, so liblo never gets to run its timed-bundle queue
+    if (batched_receive_) {
+        batch_ = std::make_unique<BatchReceiver>();
+        lo_server_enable_queue(server_, 0, 1);
+    }
+    
+    // Messages are received on the event loop thread as soon as the
+    // socket becomes readable
+    owns_event_loop_ = !event_loop_;
+    if (owns_event_loop_) {
+        event_loop_ = std::make_shared<OSCEventLoop>();
+    }
+    event_source_ = event_loop_->addSource(lo_server_get_socket_fd(server_), [this]() { receive(); });
+    if (!event_source_ || (owns_event_loop_ && !event_loop_->start())) {
+        std::cerr << "Failed to start OSC event loop for port " << port_ << std::endl;
+        if (event_source_) {
+            event_loop_->removeSource(event_source_);
+            event_source_ = 0;
+        }
+        if (owns_event_loop_) {
+            event_loop_.reset();
+            owns_event_loop_ = false;
+        }
+        lo_server_free(server_);
+        server_ = nullptr;
+        batch_.reset();
+        return false;
+    }
+    
     running_ = true;
-    server_thread_ = std::thread(&OSCServer::serverThread, this);
     
     std::cout << "OSC Server started on port " << port_ << std::endl;
     return true;
@@ -43,8 +157,13 @@ void OSCServer::stop() {
     
     running_ = false;
     
-    if (server_thread_.joinable()) {
-        server_thread_.join();
+    // Once removed, the loop thread no longer touches this server
+    event_loop_->removeSource(event_source_);
+    event_source_ = 0;
+    if (owns_event_loop_) {
+        event_loop_->stop();
+        event_loop_.reset();
+        owns_event_loop_ = false;
     }
     
     if (server_) {
@@ -52,15 +171,137 @@ void OSCServer::stop() {
         server_ = nullptr;
     }
     
+    // Release messages nobody polled for
+    if (queue_) {
+        while (queue_->tryPop([](Packet& packet) {
+            packet.bundle.release();
+            packet.raw = false;
+        })) {
+        }
+    }
+    bundle_.release();
+    bundle_depth_ = 0;
+    batch_.reset();
+    
     std::cout << "OSC Server stopped" << std::endl;
 }
 
-void OSCServer::addHandler(const std::string& path, MessageHandler handler) {
-    handlers_[path] = handler;
+bool OSCServer::setEventLoop(std::shared_ptr<OSCEventLoop> event_loop) {
+    if (running_) {
+        std::cerr << "OSC Server: event loop can only change before start()" << std::endl;
+        return false;
+    }
+    
+    event_loop_ = std::move(event_loop);
+    return true;
+}
+
+bool OSCServer::setBatchedReceive(bool enabled) {
+    if (running_) {
+        std::cerr << "OSC Server: batched receive can only change before start()" << std::endl;
+        return false;
+    }
+    
+#if defined(__linux__)
+    batched_receive_ = enabled;
+    return true;
+#else
+    batched_receive_ = false;
+    return !enabled;
+#endif
+}
+
+bool OSCServer::setDispatchMode(DispatchMode mode, size_t queue_capacity) {
+    if (running_) {
+        std::cerr << "OSC Server: dispatch mode can only change before start()" << std::endl;
+        return false;
+    }
+    
+    dispatch_mode_ = mode;
+    if (mode == DispatchMode::QUEUED) {
+        queue_ = std::make_unique<MpscQueue<Packet>>(queue_capacity);
+    } else {
+        queue_.reset();
+    }
+    return true;
+}
+
+bool OSCServer::setBundleHandler(BundleHandler handler) {
+    if (running_) {
+        std::cerr << "OSC Server: bundle handler can only change before start()" << std::endl;
+        return false;
+    }
+    
+    bundle_handler_ = std::move(handler);
+    return true;
+}
+
+void OSCServer::addHandler(const osc::Address& address, MessageHandler handler) {
+    int route = findRoute(address.hash, address.path);
+    if (route >= 0) {
+        routes_[route].handler = std::move(handler);
+        routes_[route].view_handler = nullptr;
+        return;
+    }
+    routes_.push_back({address.hash, address.path, std::move(handler), nullptr});
+    rebuildRouteTable();
+}
+
+void OSCServer::addViewHandler(const osc::Address& address, ViewHandler handler) {
+    int route = findRoute(address.hash, address.path);
+    if (route >= 0) {
+        routes_[route].handler = nullptr;
+        routes_[route].view_handler = std::move(handler);
+        return;
+    }
+    routes_.push_back({address.hash, address.path, nullptr, std::move(handler)});
+    rebuildRouteTable();
+}
+
+void OSCServer::removeHandler(const osc::Address& address) {
+    int route = findRoute(address.hash, address.path);
+    if (route < 0) {
+        return;
+    }
+    routes_.erase(routes_.begin() + route);
+    rebuildRouteTable();
+}
+
+size_t OSCServer::poll(size_t max_items) {
+    if (!queue_) {
+        return 0;
+    }
+    
+    size_t count = 0;
+    while (count < max_items && queue_->tryPop([this](Packet& packet) {
+        if (packet.raw) {
+            dispatch(packet.view);
+            packet.raw = false;
+        } else if (bundle_handler_ && !packet.bundle.isImmediate()) {
+            OSCBundle bundle;
+            bundle.swap(packet.bundle);
+            bundle_handler_(std::move(bundle));
+        } else {
+            dispatch(packet.bundle);
+            packet.bundle.release();
+        }
+    })) {
+        count++;
+    }
+    
+    uint64_t dropped = dropped_count_.load(std::memory_order_relaxed);
+    if (dropped != reported_drops_) {
+        std::cerr << "OSC Server queue full: dropped " << (dropped - reported_drops_)
+                  << " messages (" << dropped << " total)" << std::endl;
+        reported_drops_ = dropped;
+    }
+    return count;
 }
 
-void OSCServer::removeHandler(const std::string& path) {
-    handlers_.erase(path);
+void OSCServer::dispatch(const OSCBundle& bundle) {
+    for (size_t i = 0; i < bundle.count_; ++i) {
+        dispatch(bundle.messages_[i].path.c_str(), bundle.messages_[i].msg);
+    }
 }
 
 std::string OSCServer::getURL() const {
@@ -83,22 +324,258 @@ int OSCServer::genericHandler(const char* path, const char* types, lo_arg** argv
                              int argc, lo_message msg, void* user_data) {
     OSCServer* server = static_cast<OSCServer*>(user_data);
     
-    // Find handler for this path
-    auto it = server->handlers_.find(path);
-    if (it != server->handlers_.end()) {
-        it->second(path, msg);
-        return 0; // Message handled
+    if (!server->queue_) {
+        server->dispatch(path, msg);
+        return 0;
+    }
+    
+    // Keep the message alive past this callback until poll() handles it;
+    // messages of a bundle are queued together once it ends
+    if (server->bundle_depth_ > 0) {
+        server->bundle_.append(path, msg);
+        return 0;
+    }
+    bool queued = server->queue_->tryPush([&](Packet& packet) {
+        packet.bundle.time_ = {0, 1};       // LO_TT_IMMEDIATE
+        packet.bundle.append(path, msg);
+    });
+    if (queued) {
+        server->queued_count_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        server->dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+int OSCServer::bundleStartHandler(lo_timetag time, void* user_data) {
+    OSCServer* server = static_cast<OSCServer*>(user_data);
+    
+    // Nested bundles join the outermost one and take its timetag
+    if (server->bundle_depth_++ == 0) {
+        server->bundle_.time_ = time;
+    }
+    return 0;
+}
+
+int OSCServer::bundleEndHandler(void* user_data) {
+    OSCServer* server = static_cast<OSCServer*>(user_data);
+    if (server->bundle_depth_ == 0 || --server->bundle_depth_ > 0) {
+        return 0;
+    }
+    
+    // Swap the bundle into a free cell; the cell's old buffers are reused
+    // for the next bundle
+    size_t count = server->bundle_.count_;
+    if (count == 0) {
+        return 0;
+    }
+    bool queued = server->queue_->tryPush([&](Packet& packet) { packet.bundle.swap(server->bundle_); });
+    if (queued) {
+        server->queued_count_.fetch_add(count, std::memory_order_relaxed);
+    } else {
+        server->bundle_.release();
+        server->dropped_count_.fetch_add(count, std::memory_order_relaxed);
+    }
+    return 0;
+}
+
+void OSCServer::dispatch(const char* path, lo_message msg) {
+    Received message = {path, msg, nullptr, false};
+    dispatch(message);
+}
+
+void OSCServer::dispatch(const OSCMessageView& view) {
+    Received message = {view.getAddress(), nullptr, &view, false};
+    dispatch(message);
+    if (message.owns_msg) {
+        lo_message_free(message.msg);
+    }
+}
+
+void OSCServer::dispatch(Received& message) {
+    const char* path = message.path;
+    uint64_t hash = hashString(path);
+    int route = findRoute(hash, path);
+    if (route >= 0) {
+        invoke(routes_[route], message);
+        return;
     }
     
-    // No specific handler found
+    if (OSCPattern::isPattern(path)) {
+        // A handler may change the routes, which drops the cached pattern
+        const PatternRoutes* matched = &matchPattern(hash, path);
+        const uint64_t revision = route_revision_;
+        size_t count = matched->routes.size();
+        for (size_t i = 0; i < count && route_revision_ == revision; ++i) {
+            invoke(routes_[matched->routes[i]], message);
+        }
+        if (count > 0) {
+            return;
+        }
+    }
+    
+    const char* types = message.view ? message.view->getTypes() : lo_message_get_types(message.msg);
     std::cout << "Unhandled OSC message: " << path << " (" << types << ")" << std::endl;
-    return 1; // Message not handled
 }
 
-void OSCServer::serverThread() {
-    while (running_) {
-        // Process messages with timeout
-        lo_server_recv_noblock(server_, 50); // 50ms timeout
+int OSCServer::findRoute(uint64_t hash, const char* path) const {
+    if (route_slots_.empty()) {
+        return -1;
+    }
+    const size_t mask = route_slots_.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        uint32_t slot = route_slots_[i];
+        if (slot == 0) {
+            return -1;
+        }
+        const Route& route = routes_[slot - 1];
+        if (route.hash == hash && route.path == path) {
+            return static_cast<int>(slot - 1);
+        }
+    }
+}
+
+void OSCServer::rebuildRouteTable() {
+    size_t size = 8;
+    while (size < 2 * routes_.size()) {
+        size *= 2;
+    }
+    route_slots_.assign(size, 0);
+    for (size_t r = 0; r < routes_.size(); ++r) {
+        size_t i = routes_[r].hash & (size - 1);
+        while (route_slots_[i] != 0) {
+            i = (i + 1) & (size - 1);
+        }
+        route_slots_[i] = static_cast<uint32_t>(r + 1);
+    }
+    patterns_.clear();
+    route_revision_++;
+}
+
+const OSCServer::PatternRoutes& OSCServer::matchPattern(uint64_t hash, const char* pattern) {
+    auto it = patterns_.find(hash);
+    if (it != patterns_.end() && it->second.pattern.getPattern() == pattern) {
+        return it->second;
+    }
+    
+    // Clients usually send a handful of patterns over and over; anything
+    // beyond that starts the cache over
+    if (it == patterns_.end() && patterns_.size() >= MAX_CACHED_PATTERNS) {
+        patterns_.clear();
+    }
+    PatternRoutes& entry = patterns_[hash];
+    entry.routes.clear();
+    if (!entry.pattern.compile(pattern)) {
+        std::cerr << "Invalid OSC address pattern: " << pattern << std::endl;
+        return entry;
+    }
+    for (size_t r = 0; r < routes_.size(); ++r) {
+        if (entry.pattern.matches(routes_[r].path)) {
+            entry.routes.push_back(static_cast<uint32_t>(r));
+        }
+    }
+    return entry;
+}
+
+void OSCServer::invoke(const Route& route, Received& message) {
+    // Convert the message once if the handler wants the other form
+    if (route.view_handler && !message.view) {
+        size_t size = lo_message_length(message.msg, message.path);
+        view_buffer_.resize(size);
+        lo_message_serialise(message.msg, message.path, view_buffer_.data(), &size);
+        if (!view_scratch_.parse(view_buffer_.data(), size)) {
+            std::cerr << "Cannot decode OSC message " << route.path << std::endl;
+            return;
+        }
+        message.view = &view_scratch_;
+    } else if (!route.view_handler && !message.msg) {
+        int result = 0;
+        message.msg = lo_message_deserialise(const_cast<char*>(message.view->getData()),
+                                             message.view->getSize(), &result);
+        if (!message.msg) {
+            std::cerr << "Cannot decode OSC message " << route.path << " (error " << result << ")" << std::endl;
+            return;
+        }
+        message.owns_msg = true;
+    }
+    
+    // Handlers run inside the receive callback or the poll loop; an
+    // exception must not escape into either
+    try {
+        if (route.view_handler) {
+            route.view_handler(*message.view);
+        } else {
+            route.handler(route.path, message.msg);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error handling OSC message " << route.path << ": " << e.what() << std::endl;
+    }
+}
+
+void OSCServer::receive() {
+    if (batch_) {
+        receiveBatch();
+        return;
+    }
+    
+    // Take everything that is ready; liblo returns 0 once the socket is empty
+    while (lo_server_recv_noblock(server_, 0) > 0) {
+    }
+}
+
+void OSCServer::receiveBatch() {
+#if defined(__linux__)
+    const int fd = lo_server_get_socket_fd(server_);
+    BatchReceiver& batch = *batch_;
+    for (;;) {
+        for (size_t i = 0; i < BATCH_DATAGRAMS; ++i) {
+            msghdr& header = batch.headers[i].msg_hdr;
+            header = {};
+            header.msg_iov = &batch.vectors[i];
+            header.msg_iovlen = 1;
+        }
+        int count = recvmmsg(fd, batch.headers, BATCH_DATAGRAMS, MSG_DONTWAIT, nullptr);
+        if (count <= 0) {
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (batch.headers[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                std::cerr << "OSC Server: dropped datagram larger than " << MAX_DATAGRAM_SIZE
+                          << " bytes" << std::endl;
+                dropped_count_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            receiveDatagram(static_cast<const char*>(batch.vectors[i].iov_base), batch.headers[i].msg_len);
+        }
+        if (static_cast<size_t>(count) < BATCH_DATAGRAMS) {
+            return;
+        }
+    }
+#endif
+}
+
+void OSCServer::receiveDatagram(const char* data, size_t size) {
+    // Plain messages skip liblo; bundles, and anything it should report as
+    // malformed, go through it
+    OSCMessageView view;
+    if (!view.parse(data, size)) {
+        lo_server_dispatch_data(server_, const_cast<char*>(data), size);
+        return;
+    }
+    if (!queue_) {
+        dispatch(view);
+        return;
+    }
+    
+    bool queued = queue_->tryPush([&](Packet& packet) {
+        packet.datagram.assign(data, data + size);
+        packet.view.parse(packet.datagram.data(), size);
+        packet.raw = true;
+    });
+    if (queued) {
+        queued_count_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        dropped_count_.fetch_add(1, std::memory_order_relaxed);
     }
 }
 
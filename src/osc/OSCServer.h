@@ -3,16 +3,67 @@
 #include <lo/lo.h>
 #include <string>
 #include <functional>
-#include <map>
 #include <memory>
-#include <thread>
 #include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "OSCMessages.h"
+#include "OSCPattern.h"
+#include "OSCEventLoop.h"
+#include "OSCMessageView.h"
+#include "../core/MpscQueue.h"
 
 namespace gfx {
 
+// Messages received together: a single message, or the messages of an OSC
+// bundle (nested bundles flattened) with the bundle's timetag. Holds a
+// reference to each message, released on destruction. Move-only.
+class OSCBundle {
+public:
+    OSCBundle() = default;
+    OSCBundle(OSCBundle&& other) noexcept { swap(other); }
+    OSCBundle& operator=(OSCBundle&& other) noexcept;
+    ~OSCBundle() { release(); }
+    
+    OSCBundle(const OSCBundle&) = delete;
+    OSCBundle& operator=(const OSCBundle&) = delete;
+    
+    lo_timetag getTime() const { return time_; }
+    bool isImmediate() const { return time_.sec == 0 && time_.frac == 1; }
+    size_t getMessageCount() const { return count_; }
+    
+private:
+    friend class OSCServer;
+    
+    struct Message {
+        std::string path;
+        lo_message msg = nullptr;
+    };
+    
+    void append(const char* path, lo_message msg);
+    void release();
+    void swap(OSCBundle& other) noexcept;
+    
+    lo_timetag time_ = {0, 1};          // LO_TT_IMMEDIATE
+    std::vector<Message> messages_;     // The first count_ are held; the rest keep their capacity
+    size_t count_ = 0;
+};
+
 class OSCServer {
 public:
     using MessageHandler = std::function<void(const std::string& path, lo_message msg)>;
+    using ViewHandler = std::function<void(const OSCMessageView& message)>;
+    using BundleHandler = std::function<void(OSCBundle bundle)>;
+    
+    // How handlers run. IMMEDIATE calls them on the event loop thread.
+    // QUEUED puts received messages into a bounded lock-free queue and runs
+    // their handlers on the thread calling poll(), e.g. at the start of each
+    // frame: handlers then never race with that thread, and the receive
+    // thread never waits for them. Messages arriving while the queue is full
+    // are dropped and counted.
+    enum class DispatchMode { IMMEDIATE, QUEUED };
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
     
     OSCServer(int port);
     ~OSCServer();
@@ -22,9 +73,61 @@ public:
     void stop();
     bool isRunning() const { return running_; }
     
-    // Register message handlers
-    void addHandler(const std::string& path, MessageHandler handler);
-    void removeHandler(const std::string& path);
+    // Receive on a shared event loop, so that several servers use one
+    // thread; only before start(). The owner starts and stops the loop.
+    // Without one the server runs a loop of its own.
+    bool setEventLoop(std::shared_ptr<OSCEventLoop> event_loop);
+    
+    // Linux: receive with recvmmsg, many datagrams per call, into buffers
+    // allocated once at start(). Messages are queued as raw datagrams and
+    // decoded in place for view handlers, without creating an lo_message
+    // or allocating; bundles, and messages for handlers taking an
+    // lo_message, still go through liblo. liblo's own timed-bundle queue is
+    // off in this mode, so bundles not held by a bundle handler are handled
+    // on arrival. Returns false where recvmmsg is unavailable. Only before
+    // start().
+    bool setBatchedReceive(bool enabled);
+    
+    // Choose the dispatch mode; only before start()
+    bool setDispatchMode(DispatchMode mode, size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
+    DispatchMode getDispatchMode() const { return dispatch_mode_; }
+    
+    // Register message handlers. In queued mode handlers only run inside
+    // poll(), so they may be changed from the polling thread at any time.
+    //
+    // Handlers are found by the hash of their address (compile-time for the
+    // osc:: constants). A message whose address is an OSC pattern (see
+    // OSCPattern) runs the handler of every address it matches; patterns
+    // are compiled once and cached with the handlers they match. Patterns
+    // are matched against registered addresses only, never against
+    // arguments.
+    void addHandler(const osc::Address& address, MessageHandler handler);
+    void removeHandler(const osc::Address& address);
+    
+    // Register a handler reading messages in place (see OSCMessageView).
+    // Used for high-rate messages; it replaces a handler for the same
+    // address, and removeHandler() removes either kind. Messages received
+    // through liblo are serialised once for it.
+    void addViewHandler(const osc::Address& address, ViewHandler handler);
+    
+    // Queued mode: timed bundles. Without a bundle handler poll() handles
+    // bundles as they arrive, whatever their timetag. With one, a bundle
+    // with a timetag is passed to it instead, so the owner can hold it and
+    // dispatch() all of its messages at once when it is due. Messages of a
+    // bundle are queued and dropped together. Only before start().
+    bool setBundleHandler(BundleHandler handler);
+    
+    // Queued mode: handle up to max_items queued messages or bundles in
+    // arrival order on the calling thread, which must always be the same
+    // one. Returns the number taken; reports newly dropped messages.
+    size_t poll(size_t max_items = SIZE_MAX);
+    
+    // Run the handlers of a bundle's messages, in order
+    void dispatch(const OSCBundle& bundle);
+    
+    // Queued mode: messages queued and dropped since start
+    uint64_t getQueuedCount() const { return queued_count_.load(std::memory_order_relaxed); }
+    uint64_t getDroppedCount() const { return dropped_count_.load(std::memory_order_relaxed); }
     
     // Get server info
     int getPort() const { return port_; }
@@ -34,14 +137,88 @@ private:
     static void errorHandler(int num, const char* msg, const char* path);
     static int genericHandler(const char* path, const char* types, lo_arg** argv, 
                              int argc, lo_message msg, void* user_data);
+    static int bundleStartHandler(lo_timetag time, void* user_data);
+    static int bundleEndHandler(void* user_data);
+    
+    void receive();
+    void receiveBatch();
+    void receiveDatagram(const char* data, size_t size);
+    
+    // A message being dispatched, in the form it arrived in; the other form
+    // is made on demand for handlers that need it
+    struct Received {
+        const char* path;
+        lo_message msg;
+        const OSCMessageView* view;
+        bool owns_msg;
+    };
+    
+    void dispatch(const char* path, lo_message msg);
+    void dispatch(const OSCMessageView& view);
+    void dispatch(Received& message);
+    
+    struct Route {
+        uint64_t hash;
+        std::string path;
+        MessageHandler handler;
+        ViewHandler view_handler;       // Used instead of handler when set
+    };
+    
+    struct PatternRoutes {
+        OSCPattern pattern;
+        std::vector<uint32_t> routes;   // Indices into routes_
+    };
     
-    void serverThread();
+    int findRoute(uint64_t hash, const char* path) const;
+    void rebuildRouteTable();
+    const PatternRoutes& matchPattern(uint64_t hash, const char* pattern);
+    void invoke(const Route& route, Received& message);
     
     int port_;
     lo_server server_;
-    std::map<std::string, MessageHandler> handlers_;
+    
+    // Dispatch table: route_slots_ is open addressing over the routes' hashes
+    // (index into routes_ plus one, 0 for empty) with at most half its slots
+    // used. patterns_ caches received address patterns by hash; it is
+    // cleared whenever the routes change, which also bumps route_revision_.
+    std::vector<Route> routes_;
+    std::vector<uint32_t> route_slots_;
+    std::unordered_map<uint64_t, PatternRoutes> patterns_;
+    uint64_t route_revision_;
+    
     std::atomic<bool> running_;
-    std::thread server_thread_;
+    std::shared_ptr<OSCEventLoop> event_loop_;
+    bool owns_event_loop_;
+    uint64_t event_source_;
+    
+    // Queue cell: messages received by liblo, or a raw datagram decoded in
+    // place. Buffers keep their capacity between uses.
+    struct Packet {
+        OSCBundle bundle;
+        std::vector<char> datagram;
+        OSCMessageView view;
+        bool raw = false;               // view is set, bundle empty
+    };
+    
+    DispatchMode dispatch_mode_;
+    std::unique_ptr<MpscQueue<Packet>> queue_;
+    std::atomic<uint64_t> queued_count_;
+    std::atomic<uint64_t> dropped_count_;
+    uint64_t reported_drops_;                   // Drops already reported by poll()
+    BundleHandler bundle_handler_;
+    
+    // Event loop thread: bundle being received
+    OSCBundle bundle_;
+    int bundle_depth_;
+    
+    // Batched receive: recvmmsg buffers, allocated at start()
+    struct BatchReceiver;
+    bool batched_receive_;
+    std::unique_ptr<BatchReceiver> batch_;
+    
+    // Messages serialised for view handlers
+    std::vector<char> view_buffer_;
+    OSCMessageView view_scratch_;
 };
 
 } // namespace gfx
@@ -0,0 +1,136 @@
+// A steady frame (no edits since the last one) must not touch the heap on
+// any thread: the publisher, dirty collection, batch processor and
+// scheduler all run from reused buffers and the frame arena. Mirrors the
+// CPU half of GraphicsEngine::renderFrame without a GL context.
+#include "core/FrameArena.h"
+#include "core/GraphVersion.h"
+#include "core/NodeBatch.h"
+#include "core/NodeRegistry.h"
+#include "core/NodeScheduler.h"
+#include <atomic>
+#include <iostream>
+#include <string>
+
+using namespace gfx;
+
+namespace {
+
+constexpr int CHAINS = 16;
+constexpr int WARMUP_FRAMES = 8;
+constexpr int STEADY_FRAMES = 200;
+
+std::atomic<uint64_t> evaluations{0};
+
+struct Frame {
+    NodeGraph& writer;
+    NodeGraph& reader;
+    GraphPublisher& publisher;
+    NodeBatchProcessor& batch;
+    NodeScheduler& scheduler;
+    FrameArena& arena;
+    std::vector<Node*> unbatched;
+    uint64_t applied = 0;
+
+    // Writer publishes (a no-op without edits), reader applies what changed
+    // and evaluates the dirty nodes
+    void run(float time) {
+        publisher.publish(writer);
+        const GraphVersion* version = publisher.acquire();
+        if (version->getNumber() != applied) {
+            reader.applyVersion(*version);
+            applied = version->getNumber();
+        }
+        unbatched.clear();
+        batch.run(reader, reader.collectDirtyNodes(), time, unbatched);
+        scheduler.run(reader, unbatched);
+        arena.reset();
+    }
+};
+
+} // namespace
+
+int main() {
+#ifndef GFX_COUNT_ALLOCATIONS
+    std::cout << "steady allocation test skipped (built without GFX_COUNT_ALLOCATIONS)" << std::endl;
+    return 0;
+#else
+    NodeRegistry registry;
+    registerBuiltinNodeKinds(registry);
+
+    // A time-dependent kind without a batch kernel, so that the scheduler
+    // has work every frame
+    NodeKind& cpu = registry.registerKind("cpu", osc::NodeType::GENERATOR);
+    cpu.addParameter("gain", osc::ParameterType::FLOAT, {1.0f})
+       .addOutput("value", osc::ParameterType::VEC4);
+    cpu.evaluate = [](Node&) { evaluations.fetch_add(1, std::memory_order_relaxed); };
+    cpu.time_dependent = true;
+
+    NodeGraph writer;
+    writer.setNodeFactory(registry.getFactory());
+
+    // Per chain: lfo -> remap -> math.factor, cpu -> math.a; the math nodes
+    // are chained through b and the last one feeds the output
+    int id = 1;
+    int connection = 1;
+    int previous = 0;
+    for (int i = 0; i < CHAINS; ++i) {
+        std::string suffix = std::to_string(i);
+        int lfo = id++;
+        int remap = id++;
+        int source = id++;
+        int math = id++;
+        writer.addNode(registry.createNode(lfo, "lfo" + suffix, "lfo"));
+        writer.addNode(registry.createNode(remap, "remap" + suffix, "remap"));
+        writer.addNode(registry.createNode(source, "cpu" + suffix, "cpu"));
+        writer.addNode(registry.createNode(math, "math" + suffix, "math"));
+        writer.addConnection(Connection(connection++, lfo, "value", remap, "in"));
+        writer.addConnection(Connection(connection++, remap, "value", math, "factor"));
+        writer.addConnection(Connection(connection++, source, "value", math, "a"));
+        if (previous != 0) {
+            writer.addConnection(Connection(connection++, previous, "result", math, "b"));
+        }
+        previous = math;
+    }
+    int output = id++;
+    writer.addNode(registry.createNode(output, "out", "output"));
+    writer.addConnection(Connection(connection++, previous, "result", output, "color"));
+
+    FrameArena arena;
+    NodeGraph reader;
+    reader.setNodeFactory(registry.getFactory());
+    reader.setDeadNodePruning(true);
+    reader.setScratchResource(arena.getResource());
+
+    GraphPublisher publisher;
+    NodeBatchProcessor batch(registry);
+    NodeScheduler scheduler(4);
+    scheduler.setSerialThreshold(1);
+
+    Frame frame{writer, reader, publisher, batch, scheduler, arena};
+    float time = 0.0f;
+    for (int i = 0; i < WARMUP_FRAMES; ++i) {
+        frame.run(time += 0.016f);
+    }
+
+    uint64_t before_evaluations = evaluations.load();
+    uint64_t before = getAllocationCount();
+    for (int i = 0; i < STEADY_FRAMES; ++i) {
+        frame.run(time += 0.016f);
+    }
+    uint64_t allocations = getAllocationCount() - before;
+    uint64_t evaluated = evaluations.load() - before_evaluations;
+
+    if (evaluated != static_cast<uint64_t>(CHAINS) * STEADY_FRAMES) {
+        std::cerr << "expected " << CHAINS * STEADY_FRAMES << " evaluations, got "
+                  << evaluated << std::endl;
+        return 1;
+    }
+    if (allocations > 0) {
+        std::cerr << allocations << " heap allocation(s) in " << STEADY_FRAMES
+                  << " steady frames" << std::endl;
+        return 1;
+    }
+    std::cout << "steady allocation test passed" << std::endl;
+    return 0;
+#endif
+}